@@ -1,12 +1,9 @@
 #include "BPPulseDetector.h"
-#include <stdlib.h>
+#include "Clock.h"
 #include <math.h>
 
-BPPulseDetector::BPPulseDetector(BloodPressureReader* reader, uint8_t windowSize)
+BPPulseDetector::BPPulseDetector(BloodPressureReader* reader)
   : _reader(reader),
-    _bufferSize(windowSize),
-    _bufferIndex(0),
-    _bufferCount(0),
     _currentPressure(0.0f),
     _systolic(0.0f),
     _diastolic(0.0f),
@@ -21,72 +18,15 @@ BPPulseDetector::BPPulseDetector(BloodPressureReader* reader, uint8_t windowSize
     _pulseCount(0),
     _state(STATE_IDLE)
 {
-  _pressureBuffer = (float*)malloc(sizeof(float) * _bufferSize);
-  if (_pressureBuffer) {
-    for (uint8_t i = 0; i < _bufferSize; i++) {
-      _pressureBuffer[i] = 0.0f;
-    }
-  }
-}
-
-BPPulseDetector::~BPPulseDetector() {
-  if (_pressureBuffer) {
-    free(_pressureBuffer);
-  }
-}
-
-void BPPulseDetector::pushBuffer(float pressure) {
-  if (!_pressureBuffer) return;
-  
-  _pressureBuffer[_bufferIndex] = pressure;
-  _bufferIndex = (_bufferIndex + 1) % _bufferSize;
-  
-  if (_bufferCount < _bufferSize) {
-    _bufferCount++;
-  }
-}
-
-float BPPulseDetector::getBufferMax() const {
-  if (!_pressureBuffer || _bufferCount == 0) return 0.0f;
-  
-  float maxVal = _pressureBuffer[0];
-  for (uint8_t i = 1; i < _bufferCount; i++) {
-    if (_pressureBuffer[i] > maxVal) {
-      maxVal = _pressureBuffer[i];
-    }
-  }
-  return maxVal;
-}
-
-float BPPulseDetector::getBufferMin() const {
-  if (!_pressureBuffer || _bufferCount == 0) return 0.0f;
-  
-  float minVal = _pressureBuffer[0];
-  for (uint8_t i = 1; i < _bufferCount; i++) {
-    if (_pressureBuffer[i] < minVal) {
-      minVal = _pressureBuffer[i];
-    }
-  }
-  return minVal;
-}
-
-float BPPulseDetector::getBufferAverage() const {
-  if (!_pressureBuffer || _bufferCount == 0) return 0.0f;
-  
-  float sum = 0.0f;
-  for (uint8_t i = 0; i < _bufferCount; i++) {
-    sum += _pressureBuffer[i];
-  }
-  return sum / _bufferCount;
 }
 
 void BPPulseDetector::detectPulse() {
-  if (_bufferCount < _bufferSize) return;
+  if (!_window.isFull()) return;
   
-  unsigned long now = millis();
-  float currentMax = getBufferMax();
-  float currentMin = getBufferMin();
-  float currentAvg = getBufferAverage();
+  unsigned long now = Clock::millis();
+  float currentMax = _window.getMax();
+  float currentMin = _window.getMin();
+  float currentAvg = _window.getAverage();
   
   switch (_state) {
     case STATE_IDLE:
@@ -138,7 +78,7 @@ void BPPulseDetector::update() {
   if (_reader->update()) {
     _currentPressure = _reader->getPressureMmHg();
     
-    pushBuffer(_currentPressure);
+    _window.push(_currentPressure);
     
     detectPulse();
   }
@@ -2,11 +2,13 @@
 #define BP_PULSE_DETECTOR_H
 
 #include "BloodPressureReader.h"
+#include "SlidingWindowStats.h"
 
 class BPPulseDetector {
 public:
-  BPPulseDetector(BloodPressureReader* reader, uint8_t windowSize = 20);
-  ~BPPulseDetector();
+  static const size_t WINDOW_SIZE = 20;
+
+  BPPulseDetector(BloodPressureReader* reader);
   
   void update();
   
@@ -26,10 +28,7 @@ public:
 private:
   BloodPressureReader* _reader;
   
-  float* _pressureBuffer;
-  uint8_t _bufferSize;
-  uint8_t _bufferIndex;
-  uint8_t _bufferCount;
+  SlidingWindowStats<float, WINDOW_SIZE> _window;
   
   float _currentPressure;
   float _systolic;
@@ -54,10 +53,6 @@ private:
   };
   State _state;
   
-  void pushBuffer(float pressure);
-  float getBufferMax() const;
-  float getBufferMin() const;
-  float getBufferAverage() const;
   bool isLocalMaximum(uint8_t index) const;
   bool isLocalMinimum(uint8_t index) const;
   void detectPulse();
@@ -1,15 +1,39 @@
 // BloodPressureReader.cpp (Versión corregida - sin autoCalibrate)
 #include "BloodPressureReader.h"
+#include "Profiler.h"
+#include "Clock.h"
+#include "SensorTrace.h"
+#include "WaveformStreamer.h"
 #include <math.h>
-#include <stdlib.h>
 
-BloodPressureReader::BloodPressureReader(uint8_t doutPin, uint8_t sckPin, uint8_t samples)
+#ifdef ARDUINO_ARCH_ESP32
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
+
+// Evita que otras interrupciones dejen SCK en alto más de los 60 us que
+// apagan el HX711 a mitad de una transferencia.
+static portMUX_TYPE hx711Mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+namespace {
+  struct BPCalibrationRecord {
+    static const uint32_t MAGIC = 0x41435042UL;  // "BPCA"
+    static const uint16_t VERSION = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    float offsetCounts;
+    float countsPerKPa;
+    uint32_t crc;
+  };
+
+  const char* const BP_CALIBRATION_KEY = "bp_cal";
+}
+
+BloodPressureReader::BloodPressureReader(uint8_t doutPin, uint8_t sckPin)
   : _doutPin(doutPin), 
     _sckPin(sckPin),
-    _samples((samples >= 1) ? samples : 1),
-    _buffer(nullptr), 
-    _bufIdx(0), 
-    _bufCount(0),
     _lastRaw(0), 
     _lastFilteredCounts(0.0f), 
     _lastKPa(0.0f), 
@@ -17,42 +41,46 @@ BloodPressureReader::BloodPressureReader(uint8_t doutPin, uint8_t sckPin, uint8_
     _offsetCounts(0.0f), 
     _countsPerKPa(0.0f),
     _hasZeroBeenCalibrated(false), 
-    _zeroCountsSaved(0.0f)
+    _zeroCountsSaved(0.0f),
+    _calSumRaw(0),
+    _calSampleCount(0),
+    _interruptMode(false),
+    _taskClocking(false),
+    _replayMode(false),
+    _traceWriter(nullptr),
+    _waveformStreamer(nullptr)
 {
-  // Allocate buffer
-  _buffer = (float*)malloc(sizeof(float) * _samples);
-  if (_buffer) {
-    for (uint8_t i = 0; i < _samples; ++i) {
-      _buffer[i] = 0.0f;
-    }
-  } else {
-    // Si malloc falla, asegurar consistencia mínima
-    _samples = 1;
-    _buffer = (float*)malloc(sizeof(float) * _samples);
-    if (_buffer) {
-      _buffer[0] = 0.0f;
-    }
-  }
-}
-
-BloodPressureReader::~BloodPressureReader() {
-  if (_buffer) {
-    free(_buffer);
-    _buffer = nullptr;
-  }
+#ifdef ARDUINO_ARCH_ESP32
+  _sckMask = 0;
+  _sckSetReg = GPIO_OUT_W1TS_REG;
+  _sckClearReg = GPIO_OUT_W1TC_REG;
+  _doutMask = 0;
+  _doutInReg = GPIO_IN_REG;
+  _edgeCycles = 0;
+#endif
 }
 
 void BloodPressureReader::begin() {
   pinMode(_sckPin, OUTPUT);
   pinMode(_doutPin, INPUT);
   digitalWrite(_sckPin, LOW);
+  
+#ifdef ARDUINO_ARCH_ESP32
+  _sckMask = 1UL << (_sckPin & 31);
+  _sckSetReg = (_sckPin < 32) ? GPIO_OUT_W1TS_REG : GPIO_OUT1_W1TS_REG;
+  _sckClearReg = (_sckPin < 32) ? GPIO_OUT_W1TC_REG : GPIO_OUT1_W1TC_REG;
+  _doutMask = 1UL << (_doutPin & 31);
+  _doutInReg = (_doutPin < 32) ? GPIO_IN_REG : GPIO_IN1_REG;
+  // El HX711 pide >= 0,2 us por nivel de SCK; cada flanco se mantiene ~0,25 us
+  _edgeCycles = ESP.getCpuFreqMHz() / 4;
+#endif
+  
   delay(100);
   
   // Default calibration: zeros (must calibrate before accurate readings)
   _offsetCounts = 0.0f;
   _countsPerKPa = 0.0f;
-  _bufIdx = 0;
-  _bufCount = 0;
+  _buffer.reset();
   _hasZeroBeenCalibrated = false;
 }
 
@@ -61,76 +89,232 @@ bool BloodPressureReader::isReady() const {
   return digitalRead(_doutPin) == LOW;
 }
 
-long BloodPressureReader::readRawInstant() {
-  // Asume que ya comprobaste isReady() antes de llamar a esta función
-  unsigned long value = 0;
+uint32_t IRAM_ATTR BloodPressureReader::clockOutPortable(uint8_t doutPin, uint8_t sckPin) {
+  uint32_t value = 0;
   
   // Read 24 bits
   for (uint8_t i = 0; i < 24; ++i) {
-    digitalWrite(_sckPin, HIGH);
+    digitalWrite(sckPin, HIGH);
     delayMicroseconds(1);
-    value = (value << 1) | (digitalRead(_doutPin) & 1);
-    digitalWrite(_sckPin, LOW);
+    value = (value << 1) | (digitalRead(doutPin) & 1);
+    digitalWrite(sckPin, LOW);
     delayMicroseconds(1);
   }
   
   // Send 3 extra pulses to select channel A / gain 128 (HX711)
   for (uint8_t p = 0; p < 3; ++p) {
-    digitalWrite(_sckPin, HIGH);
+    digitalWrite(sckPin, HIGH);
     delayMicroseconds(1);
-    digitalWrite(_sckPin, LOW);
+    digitalWrite(sckPin, LOW);
     delayMicroseconds(1);
   }
   
-  // Sign extend 24->32 bits
-  if (value & 0x800000UL) {
-    value |= 0xFF000000UL;
+  return value;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+static inline void IRAM_ATTR hx711Hold(uint32_t cycles) {
+  uint32_t start = ESP.getCycleCount();
+  while (ESP.getCycleCount() - start < cycles) {
   }
-  
-  _lastRaw = (long)value;
-  return _lastRaw;
 }
 
-void BloodPressureReader::pushBuffer(float counts) {
-  if (!_buffer) return;
+uint32_t IRAM_ATTR BloodPressureReader::clockOutFast(bool fromISR) const {
+  uint32_t value = 0;
   
-  _buffer[_bufIdx] = counts;
-  _bufIdx = (_bufIdx + 1) % _samples;
+  if (fromISR) {
+    portENTER_CRITICAL_ISR(&hx711Mux);
+  } else {
+    portENTER_CRITICAL(&hx711Mux);
+  }
   
-  if (_bufCount < _samples) {
-    _bufCount++;
+  // 24 bits de dato + 3 pulsos para canal A / ganancia 128, unos 15 us en total
+  for (uint8_t i = 0; i < 27; ++i) {
+    REG_WRITE(_sckSetReg, _sckMask);
+    hx711Hold(_edgeCycles);
+    if (i < 24) {
+      value = (value << 1) | ((REG_READ(_doutInReg) & _doutMask) ? 1 : 0);
+    }
+    REG_WRITE(_sckClearReg, _sckMask);
+    hx711Hold(_edgeCycles);
+  }
+  
+  if (fromISR) {
+    portEXIT_CRITICAL_ISR(&hx711Mux);
+  } else {
+    portEXIT_CRITICAL(&hx711Mux);
+  }
+  
+  return value;
+}
+#endif
+
+uint32_t IRAM_ATTR BloodPressureReader::clockOut(bool fromISR) const {
+#ifdef ARDUINO_ARCH_ESP32
+  return clockOutFast(fromISR);
+#else
+  (void)fromISR;
+  return clockOutPortable(_doutPin, _sckPin);
+#endif
+}
+
+long IRAM_ATTR BloodPressureReader::decodeRaw(uint32_t bits) {
+  // Extensión de signo de 24 a 32 bits
+  bits &= 0x00FFFFFFUL;
+  if (bits & 0x800000UL) {
+    bits |= 0xFF000000UL;
   }
+  return (long)(int32_t)bits;
+}
+
+long BloodPressureReader::readRawInstant() {
+  // Asume que ya comprobaste isReady() antes de llamar a esta función
+  PROFILE_SCOPE(PROF_HX711);
+  _lastRaw = decodeRaw(clockOut(false));
+  return _lastRaw;
 }
 
-float BloodPressureReader::averageBuffer() const {
-  if (!_buffer || _bufCount == 0) {
-    return 0.0f;
+long BloodPressureReader::readRawPortable() {
+  _lastRaw = decodeRaw(clockOutPortable(_doutPin, _sckPin));
+  return _lastRaw;
+}
+
+void IRAM_ATTR BloodPressureReader::onDataReady(void* arg) {
+  BloodPressureReader* self = static_cast<BloodPressureReader*>(arg);
+  
+  // Sacar la muestra hace oscilar DOUT y vuelve a armar la interrupción;
+  // esos flancos espurios llegan con DOUT ya otra vez en alto. Mientras la
+  // propia tarea está sacando una muestra se ignoran del todo.
+  if (self->_taskClocking || digitalRead(self->_doutPin) != LOW) {
+    return;
   }
   
-  float sum = 0.0f;
-  for (uint8_t i = 0; i < _bufCount; ++i) {
-    sum += _buffer[i];
+  QueuedSample sample;
+  sample.timestampUs = Clock::micros();
+  sample.raw = decodeRaw(self->clockOut(true));
+  self->_sampleQueue.push(sample);
+}
+
+void BloodPressureReader::enableInterruptMode() {
+  if (_interruptMode) return;
+  
+  _sampleQueue.clear();
+  _interruptMode = true;
+  attachInterruptArg(digitalPinToInterrupt(_doutPin), onDataReady, this, FALLING);
+  
+  // Una conversión terminada antes de armar la interrupción ya no dará flanco
+  if (isReady()) {
+    QueuedSample sample;
+    sample.timestampUs = Clock::micros();
+    _taskClocking = true;
+    sample.raw = decodeRaw(clockOut(false));
+    _taskClocking = false;
+    _sampleQueue.push(sample);
   }
+}
+
+void BloodPressureReader::disableInterruptMode() {
+  if (!_interruptMode) return;
   
-  return sum / _bufCount;
+  detachInterrupt(digitalPinToInterrupt(_doutPin));
+  _interruptMode = false;
+  _sampleQueue.clear();
+}
+
+bool BloodPressureReader::isInterruptMode() const {
+  return _interruptMode;
+}
+
+uint32_t BloodPressureReader::getDroppedSamples() const {
+  return _sampleQueue.dropped();
+}
+
+void BloodPressureReader::setReplayMode(bool enabled) {
+  if (enabled) {
+    disableInterruptMode();
+  }
+  _sampleQueue.clear();
+  _replayMode = enabled;
+}
+
+bool BloodPressureReader::isReplayMode() const {
+  return _replayMode;
+}
+
+bool BloodPressureReader::injectSample(long raw) {
+  if (!_replayMode) return false;
+  QueuedSample sample;
+  sample.raw = raw;
+  sample.timestampUs = Clock::micros();
+  return _sampleQueue.push(sample);
+}
+
+void BloodPressureReader::setTraceWriter(SensorTraceWriter* writer) {
+  _traceWriter = writer;
+}
+
+void BloodPressureReader::setWaveformStreamer(WaveformStreamer* streamer) {
+  _waveformStreamer = streamer;
+}
+
+void BloodPressureReader::traceSample(long raw, uint32_t timestampUs) {
+  if (_traceWriter) {
+    int32_t value = (int32_t)raw;
+    _traceWriter->record(TRACE_HX711, timestampUs, &value);
+  }
+}
+
+bool BloodPressureReader::takeQueuedSample(long& raw) {
+  // Cada muestra sacada de la cola cuenta en PROF_HX711 igual que una
+  // lectura por sondeo; una cola vacía no se registra
+#ifdef ENABLE_PROFILING
+  uint32_t start = Profiler::now();
+#endif
+  QueuedSample sample;
+  if (!_sampleQueue.pop(sample)) {
+    return false;
+  }
+  raw = sample.raw;
+  _lastRaw = raw;
+  traceSample(raw, sample.timestampUs);
+#ifdef ENABLE_PROFILING
+  Profiler::record(PROF_HX711, Profiler::now() - start);
+#endif
+  return true;
 }
 
 bool BloodPressureReader::update() {
+  if (_interruptMode || _replayMode) {
+    // Vaciar en lote todo lo que el ISR encoló desde la última llamada
+    long raw;
+    bool gotSample = false;
+    while (takeQueuedSample(raw)) {
+      applySample(raw);
+      gotSample = true;
+    }
+    return gotSample;
+  }
+  
   if (!isReady()) {
     return false;   // No listo → no bloquea
   }
   
   // Leer valor RAW
   long raw = readRawInstant();
+  traceSample(raw, Clock::micros());
+  applySample(raw);
+  
+  return true;
+}
+
+void BloodPressureReader::applySample(long raw) {
   float counts = (float)raw;
   
   // Agregar al buffer de promedio móvil
-  pushBuffer(counts);
-  float avgCounts = averageBuffer();
+  _buffer.push(counts);
+  float avgCounts = _buffer.average();
   _lastFilteredCounts = avgCounts;
   
-  // ✅ ELIMINADO autoCalibrate() - sin sentido físico
-  
   // Calcular presión solo si ya está calibrado
   if (_countsPerKPa != 0.0f) {
     float kPa = (avgCounts - _offsetCounts) / _countsPerKPa;
@@ -143,59 +327,64 @@ bool BloodPressureReader::update() {
     _lastMmHg = 0.0f;
   }
   
-  return true;
+  if (_waveformStreamer) {
+    _waveformStreamer->push(WAVE_PRESSURE, (int32_t)lroundf(_lastMmHg * 10.0f), Clock::millis());
+  }
 }
 
-void BloodPressureReader::calibrateZero() {
-  long sumRaw = 0;
-  const int numSamples = 10;
-  
-  for (int i = 0; i < numSamples; i++) {
-    while (!isReady()) {
-      delay(1);
-    }
-    sumRaw += readRawInstant();
-    delay(10);
+bool BloodPressureReader::readSample(long& raw) {
+  if (_interruptMode || _replayMode) {
+    return takeQueuedSample(raw);
   }
   
-  float avgRaw = (float)sumRaw / numSamples;
-  
-  if (_buffer) {
-    for (uint8_t i = 0; i < _samples; ++i) {
-      _buffer[i] = avgRaw;
-    }
-    _bufCount = _samples;
-    _lastFilteredCounts = avgRaw;
-    _offsetCounts = avgRaw;
-    _hasZeroBeenCalibrated = true;
-    _zeroCountsSaved = _offsetCounts;
+  if (!isReady()) {
+    return false;
   }
+  
+  raw = readRawInstant();
+  traceSample(raw, Clock::micros());
+  return true;
+}
+
+void BloodPressureReader::resetCalibrationSamples() {
+  _calSumRaw = 0;
+  _calSampleCount = 0;
+}
+
+void BloodPressureReader::addCalibrationSample(long raw) {
+  _calSumRaw += raw;
+  _calSampleCount++;
+}
+
+uint16_t BloodPressureReader::getCalibrationSampleCount() const {
+  return _calSampleCount;
 }
 
-bool BloodPressureReader::calibratePoint(float knownMmHg) {
-  if (!_hasZeroBeenCalibrated) {
+bool BloodPressureReader::applyZeroCalibration() {
+  if (_calSampleCount == 0) {
     return false;
   }
   
-  long sumRaw = 0;
-  const int numSamples = 10;
+  float avgRaw = (float)_calSumRaw / _calSampleCount;
+  resetCalibrationSamples();
   
-  for (int i = 0; i < numSamples; i++) {
-    while (!isReady()) {
-      delay(1);
-    }
-    sumRaw += readRawInstant();
-    delay(10);
+  _buffer.fill(avgRaw);
+  _lastFilteredCounts = avgRaw;
+  _offsetCounts = avgRaw;
+  _hasZeroBeenCalibrated = true;
+  _zeroCountsSaved = _offsetCounts;
+  return true;
+}
+
+bool BloodPressureReader::applyPointCalibration(float knownMmHg) {
+  if (!_hasZeroBeenCalibrated || _calSampleCount == 0) {
+    return false;
   }
   
-  float avgRaw = (float)sumRaw / numSamples;
+  float avgRaw = (float)_calSumRaw / _calSampleCount;
+  resetCalibrationSamples();
   
-  if (_buffer) {
-    for (uint8_t i = 0; i < _samples; ++i) {
-      _buffer[i] = avgRaw;
-    }
-    _bufCount = _samples;
-  }
+  _buffer.fill(avgRaw);
   
   float currentCounts = avgRaw;
   
@@ -221,6 +410,32 @@ void BloodPressureReader::setCalibration(float offsetCounts, float countsPerKPa)
   _zeroCountsSaved = offsetCounts;
 }
 
+bool BloodPressureReader::loadCalibration(CalibrationStore& store) {
+  BPCalibrationRecord record;
+  if (!loadCalibrationRecord(store, BP_CALIBRATION_KEY, record)) {
+    return false;
+  }
+  
+  if (!isfinite(record.offsetCounts) || !isfinite(record.countsPerKPa) ||
+      record.countsPerKPa == 0.0f) {
+    return false;
+  }
+  
+  setCalibration(record.offsetCounts, record.countsPerKPa);
+  return true;
+}
+
+bool BloodPressureReader::saveCalibration(CalibrationStore& store) const {
+  if (_countsPerKPa == 0.0f) {
+    return false;
+  }
+  
+  BPCalibrationRecord record = {};
+  record.offsetCounts = _offsetCounts;
+  record.countsPerKPa = _countsPerKPa;
+  return saveCalibrationRecord(store, BP_CALIBRATION_KEY, record);
+}
+
 long BloodPressureReader::getLastRaw() const {
   return _lastRaw;
 }
@@ -246,14 +461,7 @@ float BloodPressureReader::getCountsPerKPa() const {
 }
 
 void BloodPressureReader::reset() {
-  if (!_buffer) return;
-  
-  for (uint8_t i = 0; i < _samples; ++i) {
-    _buffer[i] = 0.0f;
-  }
-  
-  _bufIdx = 0;
-  _bufCount = 0;
+  _buffer.reset();
   _lastRaw = 0;
   _lastFilteredCounts = 0.0f;
   _lastKPa = 0.0f;
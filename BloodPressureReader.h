@@ -2,25 +2,47 @@
 #define BLOOD_PRESSURE_READER_H
 
 #include <Arduino.h>
+#include "RingBuffer.h"
+#include "SpscRing.h"
+#include "CalibrationStore.h"
+
+class SensorTraceWriter;
+class WaveformStreamer;
 
 class BloodPressureReader {
 public:
-  BloodPressureReader(uint8_t doutPin, uint8_t sckPin, uint8_t samples = 10);
-  
-  ~BloodPressureReader();
+  BloodPressureReader(uint8_t doutPin, uint8_t sckPin);
 
   void begin();
 
   bool update();
 
+  // En el ESP32 accede directamente a los registros GPIO; en otro caso, digitalWrite.
   long readRawInstant();
 
-  void calibrateZero();
+  // Bit-bang portátil con digitalWrite/digitalRead, siempre disponible.
+  long readRawPortable();
+
+  // Extiende el signo de la palabra de 24 bits en complemento a dos del HX711.
+  static long decodeRaw(uint32_t bits);
+
+  // Lectura sin bloqueo: con interrupción, la siguiente muestra en cola; si
+  // no, lectura directa si hay conversión lista. false si no hay ninguna.
+  bool readSample(long& raw);
 
-  bool calibratePoint(float knownMmHg);
+  // Calibración por muestras: se añaden según llegan y luego se aplica.
+  void resetCalibrationSamples();
+  void addCalibrationSample(long raw);
+  uint16_t getCalibrationSampleCount() const;
+  bool applyZeroCalibration();
+  bool applyPointCalibration(float knownMmHg);
 
   void setCalibration(float offsetCounts, float countsPerKPa);
 
+  // Calibración persistida; load rechaza registros ausentes, antiguos o corruptos.
+  bool loadCalibration(CalibrationStore& store);
+  bool saveCalibration(CalibrationStore& store) const;
+
   long getLastRaw() const;
   float getLastFilteredCounts() const;
   float getPressureKPa() const;
@@ -33,16 +55,35 @@ public:
 
   bool isReady() const;
 
+  // Adquisición por interrupción: el flanco de bajada de DOUT saca la
+  // muestra dentro de la ISR y la encola; update() vacía la cola.
+  void enableInterruptMode();
+  void disableInterruptMode();
+  bool isInterruptMode() const;
+  uint32_t getDroppedSamples() const;
+
+  // Modo reproducción: sin tocar el hardware; las muestras llegan por
+  // injectSample() y pasan por la misma cola que las de la interrupción.
+  void setReplayMode(bool enabled);
+  bool isReplayMode() const;
+  bool injectSample(long raw);
+
+  // Graba cada muestra cruda que se entrega al filtro o a la calibración.
+  void setTraceWriter(SensorTraceWriter* writer);
+
+  // Envía cada valor de presión filtrado, en décimas de mmHg.
+  void setWaveformStreamer(WaveformStreamer* streamer);
+
   static constexpr float KPA_TO_MMHG = 7.50062f;
 
+  static const size_t FILTER_SAMPLES = 10;
+  static const size_t SAMPLE_QUEUE_SIZE = 32;
+
 private:
   uint8_t _doutPin;
   uint8_t _sckPin;
-  uint8_t _samples;
 
-  float* _buffer;
-  uint8_t _bufIdx;
-  uint8_t _bufCount;
+  SummingRingBuffer<float, FILTER_SAMPLES> _buffer;
 
   long  _lastRaw;
   float _lastFilteredCounts;
@@ -55,8 +96,41 @@ private:
   bool _hasZeroBeenCalibrated;
   float _zeroCountsSaved;
 
-  void pushBuffer(float counts);
-  float averageBuffer() const;
+  long _calSumRaw;
+  uint16_t _calSampleCount;
+
+  volatile bool _interruptMode;
+  volatile bool _taskClocking;
+  bool _replayMode;
+  // Cada muestra con el instante del flanco de DOUT, para la traza
+  struct QueuedSample {
+    long raw;
+    uint32_t timestampUs;
+  };
+  SpscRing<QueuedSample, SAMPLE_QUEUE_SIZE> _sampleQueue;
+
+  SensorTraceWriter* _traceWriter;
+  WaveformStreamer* _waveformStreamer;
+
+#ifdef ARDUINO_ARCH_ESP32
+  // Direcciones de registro y máscaras del camino rápido, resueltas en begin()
+  uint32_t _sckMask;
+  uint32_t _sckSetReg;
+  uint32_t _sckClearReg;
+  uint32_t _doutMask;
+  uint32_t _doutInReg;
+  uint32_t _edgeCycles;
+
+  uint32_t clockOutFast(bool fromISR) const;
+#endif
+
+  static uint32_t clockOutPortable(uint8_t doutPin, uint8_t sckPin);
+  uint32_t clockOut(bool fromISR) const;
+  static void onDataReady(void* arg);
+
+  bool takeQueuedSample(long& raw);
+  void applySample(long raw);
+  void traceSample(long raw, uint32_t timestampUs);
 };
 
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Buzzer.h"
+#include "Clock.h"
 
 Buzzer::Buzzer(int pin) {
     this->pin = pin;
@@ -21,13 +22,13 @@ void Buzzer::off() {
 void Buzzer::beep(int ms) {
     on();
     beeping = true;
-    startTime = millis();
+    startTime = Clock::millis();
     duration = ms;
 }
 
 void Buzzer::update() {
     if (beeping) {
-        if (millis() - startTime >= duration) {
+        if (Clock::millis() - startTime >= duration) {
             off();
             beeping = false;
         }
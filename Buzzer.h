@@ -8,7 +8,7 @@ private:
     int pin;
     bool beeping;
     unsigned long startTime;
-    int duration;
+    unsigned long duration;
 public:
     Buzzer(int pin);
 
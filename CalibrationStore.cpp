@@ -0,0 +1,91 @@
+#include "CalibrationStore.h"
+#include <stdio.h>
+
+uint32_t calibrationCrc32(const void* data, size_t len) {
+  // CRC-32 (IEEE 802.3), bit a bit: solo se usa al arrancar y al guardar
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFFUL;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= bytes[i];
+    for (uint8_t b = 0; b < 8; ++b) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+    }
+  }
+  return ~crc;
+}
+
+#ifdef ARDUINO
+NvsCalibrationStore::NvsCalibrationStore(const char* nameSpace)
+  : _nameSpace(nameSpace),
+    _open(false)
+{
+}
+
+bool NvsCalibrationStore::begin() {
+  if (!_open) {
+    _open = _prefs.begin(_nameSpace, false);
+  }
+  return _open;
+}
+
+bool NvsCalibrationStore::read(const char* key, void* data, size_t len) {
+  if (!_open) return false;
+  if (_prefs.getBytesLength(key) != len) return false;
+  return _prefs.getBytes(key, data, len) == len;
+}
+
+bool NvsCalibrationStore::write(const char* key, const void* data, size_t len) {
+  if (!_open) return false;
+  return _prefs.putBytes(key, data, len) == len;
+}
+
+bool NvsCalibrationStore::erase(const char* key) {
+  if (!_open) return false;
+  return _prefs.remove(key);
+}
+#endif
+
+FileCalibrationStore::FileCalibrationStore(const char* directory)
+  : _directory(directory)
+{
+}
+
+bool FileCalibrationStore::begin() {
+  return _directory != nullptr;
+}
+
+bool FileCalibrationStore::pathFor(const char* key, char* path, size_t size) const {
+  int n = snprintf(path, size, "%s/%s.cal", _directory, key);
+  return n > 0 && (size_t)n < size;
+}
+
+bool FileCalibrationStore::read(const char* key, void* data, size_t len) {
+  char path[96];
+  if (!pathFor(key, path, sizeof(path))) return false;
+  
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  
+  size_t got = fread(data, 1, len, f);
+  bool exact = (got == len) && (fgetc(f) == EOF);
+  fclose(f);
+  return exact;
+}
+
+bool FileCalibrationStore::write(const char* key, const void* data, size_t len) {
+  char path[96];
+  if (!pathFor(key, path, sizeof(path))) return false;
+  
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  
+  size_t put = fwrite(data, 1, len, f);
+  bool ok = (fclose(f) == 0) && (put == len);
+  return ok;
+}
+
+bool FileCalibrationStore::erase(const char* key) {
+  char path[96];
+  if (!pathFor(key, path, sizeof(path))) return false;
+  return remove(path) == 0;
+}
@@ -0,0 +1,77 @@
+#ifndef CALIBRATION_STORE_H
+#define CALIBRATION_STORE_H
+
+#include <Arduino.h>
+#include <stddef.h>
+
+// Almacén persistente clave → bloque para los registros de calibración.
+class CalibrationStore {
+public:
+  virtual ~CalibrationStore() {}
+
+  virtual bool begin() = 0;
+  virtual bool read(const char* key, void* data, size_t len) = 0;
+  virtual bool write(const char* key, const void* data, size_t len) = 0;
+  virtual bool erase(const char* key) = 0;
+};
+
+#ifdef ARDUINO
+#include <Preferences.h>
+
+// En el equipo: un espacio de nombres NVS, una entrada por registro.
+class NvsCalibrationStore : public CalibrationStore {
+public:
+  NvsCalibrationStore(const char* nameSpace = "alertavital");
+
+  bool begin() override;
+  bool read(const char* key, void* data, size_t len) override;
+  bool write(const char* key, const void* data, size_t len) override;
+  bool erase(const char* key) override;
+
+private:
+  const char* _nameSpace;
+  Preferences _prefs;
+  bool _open;
+};
+#endif
+
+// Un fichero por registro bajo `directory` (pruebas en host o un FS montado).
+class FileCalibrationStore : public CalibrationStore {
+public:
+  FileCalibrationStore(const char* directory);
+
+  bool begin() override;
+  bool read(const char* key, void* data, size_t len) override;
+  bool write(const char* key, const void* data, size_t len) override;
+  bool erase(const char* key) override;
+
+private:
+  const char* _directory;
+
+  bool pathFor(const char* key, char* path, size_t size) const;
+};
+
+uint32_t calibrationCrc32(const void* data, size_t len);
+
+// Los registros son structs planos que empiezan por `magic` y `version` y
+// acaban en `crc` (CRC-32 de todos los bytes anteriores). Record::MAGIC y
+// Record::VERSION identifican el formato; al cargar se rechaza cualquier otro.
+template <typename Record>
+bool loadCalibrationRecord(CalibrationStore& store, const char* key, Record& record) {
+  Record candidate;
+  if (!store.read(key, &candidate, sizeof(candidate))) return false;
+  if (candidate.magic != Record::MAGIC || candidate.version != Record::VERSION) return false;
+  if (candidate.crc != calibrationCrc32(&candidate, offsetof(Record, crc))) return false;
+  record = candidate;
+  return true;
+}
+
+template <typename Record>
+bool saveCalibrationRecord(CalibrationStore& store, const char* key, Record& record) {
+  record.magic = Record::MAGIC;
+  record.version = Record::VERSION;
+  record.crc = calibrationCrc32(&record, offsetof(Record, crc));
+  return store.write(key, &record, sizeof(record));
+}
+
+#endif
@@ -0,0 +1,13 @@
+#include "Clock.h"
+
+bool Clock::_virtual = false;
+uint64_t Clock::_virtualUs = 0;
+
+void Clock::useVirtual(uint64_t startUs) {
+  _virtualUs = startUs;
+  _virtual = true;
+}
+
+void Clock::useSystem() {
+  _virtual = false;
+}
@@ -0,0 +1,35 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+
+// Fuente de tiempo de las clases del firmware. Por defecto es el reloj del
+// ESP32; una simulación o una reproducción de trazas puede cambiar a un
+// reloj virtual y avanzarlo a mano, más rápido que el tiempo real.
+// millis() y micros() derivan del mismo contador, así que son coherentes
+// entre sí en ambos modos.
+class Clock {
+public:
+  static unsigned long millis() {
+    return _virtual ? (unsigned long)(_virtualUs / 1000) : ::millis();
+  }
+
+  static uint32_t micros() {
+    return _virtual ? (uint32_t)_virtualUs : (uint32_t)::micros();
+  }
+
+  static void useVirtual(uint64_t startUs = 0);
+  static void useSystem();
+  static bool isVirtual() { return _virtual; }
+
+  // Solo tiene efecto con el reloj virtual
+  static void advanceMicros(uint64_t us) { _virtualUs += us; }
+  static void advanceMillis(uint32_t ms) { _virtualUs += (uint64_t)ms * 1000; }
+  static void setMicros(uint64_t us) { _virtualUs = us; }
+
+private:
+  static bool _virtual;
+  static uint64_t _virtualUs;
+};
+
+#endif
@@ -1,315 +1,931 @@
-#include <DeviceManager.h>
-#include <Arduino.h>
-#include <BLEDevice.h>
-#include <BLEUtils.h>
-#include <BLEServer.h>
-#include <ArduinoJson.h>
-
-BLEServer *pServer;
-BLECharacteristic *vitalsCharacteristic;
-BLECharacteristic *fallCharacteristic;
-
-#define SERVICE_UUID "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
-#define VITALS_CHAR_UUID    "beb5483e-36e1-4688-b7f5-ea07361b26a8"
-#define FALL_CHAR_UUID      "beb5483e-36e1-4688-b7f5-ea07361b26a9"
-
-#define DOUT_PIN 32
-#define SCK_PIN 33
-
-#define LED_PIN 14
-#define BUZZER_PIN 19
-
-bool isCalibrated = false;
-unsigned long lastPrintTime = 0;
-
-enum CalibrationState {
-  CAL_IDLE,
-  CAL_WAITING_ZERO,
-  CAL_TAKING_ZERO_SAMPLES,
-  CAL_WAITING_PRESSURE,
-  CAL_TAKING_PRESSURE_SAMPLES,
-  CAL_COMPLETE
-};
-
-CalibrationState calState = CAL_IDLE;
-unsigned long calStartTime = 0;
-int calSampleCount = 0;
-
-DeviceManager::DeviceManager(): 
-  pulseoximeter(), 
-  display(), 
-  fallDetector(), 
-  bpReader(DOUT_PIN, SCK_PIN, 10), 
-  pulseDetector(&bpReader, 20),
-  led(LED_PIN),
-  buzzer(BUZZER_PIN)
-{
-  alertActive = false;
-}
-
-void DeviceManager::init() {
-  Serial.begin(115200);
-  delay(1000);
-  
-  BLEDevice::init("IOT-01");
-  pServer = BLEDevice::createServer();
-  BLEService *pService = pServer->createService(SERVICE_UUID);
-
-  vitalsCharacteristic = pService->createCharacteristic(
-    VITALS_CHAR_UUID,
-    BLECharacteristic::PROPERTY_READ | 
-    BLECharacteristic::PROPERTY_NOTIFY
-  );
-
-  fallCharacteristic = pService->createCharacteristic(
-    FALL_CHAR_UUID,
-    BLECharacteristic::PROPERTY_READ | 
-    BLECharacteristic::PROPERTY_NOTIFY
-  );
-
-  pService->start();
-  BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
-  pAdvertising->addServiceUUID(SERVICE_UUID);
-  BLEDevice::startAdvertising();
-  Serial.println("BLE listo, esperando conexión...");
-
-  configTime(0, 0, "pool.ntp.org");
-  
-  pulseoximeter.begin();
-  fallDetector.begin();
-  bpReader.begin();
-  led.begin();
-  buzzer.begin();
-  startCalibration();
-  
-  pulseDetector.setThreshold(3.0f);
-  pulseDetector.setMinPeakDistance(400);
-  
-  display.init();
-  display.clear();
-  display.printPresentation();
-  display.display();
-  
-  Serial.println("Sistema inicializado\n");
-}
-
-void DeviceManager::startCalibration() {
-  
-  calState = CAL_WAITING_ZERO;
-  calStartTime = millis();
-  calSampleCount = 0;
-  isCalibrated = false;
-}
-
-void DeviceManager::updateCalibration() {
-  unsigned long now = millis();
-  
-  switch (calState) {
-    case CAL_IDLE:
-      break;
-      
-    case CAL_WAITING_ZERO:
-      if (now - calStartTime >= 3000) {
-        calState = CAL_TAKING_ZERO_SAMPLES;
-        calSampleCount = 0;
-      }
-      break;
-      
-    case CAL_TAKING_ZERO_SAMPLES:
-      if (bpReader.isReady()) {
-        bpReader.readRawInstant();
-        calSampleCount++;
-        
-        if (calSampleCount >= 15) {
-          bpReader.calibrateZero();
-          long zeroRaw = bpReader.getLastRaw();
-          
-          calState = CAL_WAITING_PRESSURE;
-          calStartTime = millis();
-          calSampleCount = 0;
-        }
-      }
-      break;
-      
-    case CAL_WAITING_PRESSURE:
-      {
-        unsigned long elapsed = now - calStartTime;
-        if (elapsed < 8000) {
-          // Mostrar countdown cada segundo
-          static unsigned long lastCountdown = 0;
-          if (now - lastCountdown >= 1000) {
-            lastCountdown = now;
-            int secondsLeft = 8 - (elapsed / 1000);
-          }
-        } else {
-          calState = CAL_TAKING_PRESSURE_SAMPLES;
-          calSampleCount = 0;
-        }
-      }
-      break;
-      
-    case CAL_TAKING_PRESSURE_SAMPLES:
-      if (bpReader.isReady()) {
-        bpReader.readRawInstant();
-        calSampleCount++;
-        
-        if (calSampleCount >= 15) {
-          float knownPressure = 100.0f;
-          bool success = bpReader.calibratePoint(knownPressure);
-          
-          if (success) {
-            long pressureRaw = bpReader.getLastRaw();
-            float offset = bpReader.getOffsetCounts();
-            float countsPerKPa = bpReader.getCountsPerKPa();
-            
-            isCalibrated = true;
-          } else {
-            isCalibrated = false;
-          }
-          
-          calState = CAL_COMPLETE;
-        }
-      }
-      break;
-      
-    case CAL_COMPLETE:
-      calState = CAL_IDLE;
-      break;
-  }
-}
-
-void DeviceManager::manage() {
-  if (calState != CAL_IDLE && calState != CAL_COMPLETE) {
-    updateCalibration();
-    return;
-  }
-  
-  pulseoximeter.on();
-  fallDetector.on();
-  
-  pulseDetector.update();
-  buzzer.update();
-  
-  unsigned long now = millis();
-  
-  if (now - lastPrintTime >= 100) {
-    lastPrintTime = now;
-    
-    float current = pulseDetector.getCurrentPressure();
-    float systolic = pulseDetector.getSystolic();
-    float diastolic = pulseDetector.getDiastolic();
-    float bpm = pulseoximeter.getAverageBPM();
-      
-    pulseDetector.clearNewReading();
-  }
-  
-  if (pulseoximeter.getPrintStatus()) {
-    Serial.print(" (BPM=");
-    Serial.print(pulseoximeter.getAverageBPM());
-    Serial.println(")");
-    Serial.print(" (SpO2=");
-    Serial.print(pulseoximeter.getSpO2());
-    Serial.println(")");
-    Serial.print(" (BP=");
-    Serial.print(String((int)pulseDetector.getSystolic()));
-    Serial.print("/");
-    Serial.print(String((int)pulseDetector.getDiastolic()));
-    Serial.println(")");
-    
-    display.clear();
-    display.print(0, 0, 2, "BPM: " + String(pulseoximeter.getAverageBPM()));
-    display.print(17, 0, 2, "SpO2: " + String(pulseoximeter.getSpO2()) + "%");
-    
-    if (pulseoximeter.getAverageBPM() < 60 || pulseoximeter.getAverageBPM() > 100 || pulseoximeter.getSpO2() < 92) {
-      alertActive = true;
-    } else {
-      alertActive = false;
-    }
-
-    if (pulseDetector.getPulseCount() > 0) {
-      display.print(34, 0, 2, "BP: " + String((int)pulseDetector.getSystolic()) + 
-                               "/" + String((int)pulseDetector.getDiastolic()));
-    }
-    
-    display.display();
-
-    StaticJsonDocument<200> doc;
-    doc["device"] = "IOT-01";
-    doc["type"] = "vitals";
-    doc["bpm"] = String(pulseoximeter.getAverageBPM());
-    doc["spo2"] = String(pulseoximeter.getSpO2());
-    doc["bpSystolic"] = String((int)pulseDetector.getSystolic());
-    doc["bpDiastolic"] = String((int)pulseDetector.getDiastolic());
-
-    String jsonOut;
-    serializeJson(doc, jsonOut);
-    vitalsCharacteristic->setValue(jsonOut);
-    vitalsCharacteristic->notify();
-
-    pulseoximeter.setPrintStatus(false);
-  }
-
-  if (fallDetector.wasFallDetected()) {
-    Serial.println("*** CAÍDA DETECTADA ***");
-    
-    alertActive = true;
-
-    StaticJsonDocument<300> doc;
-    doc["device"] = "IOT-01";
-    doc["type"] = "fall_alert";
-    String jsonOut;
-    serializeJson(doc, jsonOut);
-    fallCharacteristic->setValue(jsonOut);
-    fallCharacteristic->notify();
-  }
-
-  if (alertActive) {
-    led.on();
-    static unsigned long lastBeep = 0;
-    if (millis() - lastBeep > 500) {
-        buzzer.beep(200); 
-        lastBeep = millis();
-    }
-  } else {
-    led.off();
-  }
-}
-
-void DeviceManager::performCalibration() {
-  startCalibration();
-}
-
-void DeviceManager::manualCalibration() {
-
-  float offsetCounts = 233000.0f;
-  float countsPerKPa = 187.5f;
-  
-  bpReader.setCalibration(offsetCounts, countsPerKPa);
-  
-  Serial.print("  Offset:      ");
-  Serial.println(offsetCounts, 1);
-  Serial.print("  Counts/kPa:  ");
-  Serial.println(countsPerKPa, 2);
-  Serial.println();
-  
-  isCalibrated = true;
-  calState = CAL_IDLE;
-}
-
-void DeviceManager::classifyBP(float systolic, float diastolic) {
-  Serial.print("   Clasificación: ");
-  
-  if (systolic < 90 || diastolic < 60) {
-    Serial.println("⬇️  HIPOTENSIÓN (Baja)");
-  } else if (systolic < 120 && diastolic < 80) {
-    Serial.println("NORMAL");
-  } else if (systolic < 130 && diastolic < 80) {
-    Serial.println("ELEVADA");
-  } else if (systolic < 140 || diastolic < 90) {
-    Serial.println("HIPERTENSIÓN Etapa 1");
-  } else if (systolic < 180 || diastolic < 120) {
-    Serial.println("HIPERTENSIÓN Etapa 2");
-  } else {
-    Serial.println("CRISIS HIPERTENSIVA");
-  }
+#include <DeviceManager.h>
+#include <MemoryBudget.h>
+#include <Clock.h>
+#include <Profiler.h>
+#include <VitalsFrame.h>
+#include <I2CBus.h>
+#include <Log.h>
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEUtils.h>
+#include <BLEServer.h>
+#include <LittleFS.h>
+
+BLEServer *pServer;
+BLECharacteristic *vitalsCharacteristic;
+BLECharacteristic *fallCharacteristic;
+BLECharacteristic *waveformCharacteristic;
+BLECharacteristic *backlogCharacteristic;
+#ifdef ENABLE_PROFILING
+BLECharacteristic *diagnosticsCharacteristic;
+#endif
+
+#define SERVICE_UUID "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
+#define VITALS_CHAR_UUID    "beb5483e-36e1-4688-b7f5-ea07361b26a8"
+#define FALL_CHAR_UUID      "beb5483e-36e1-4688-b7f5-ea07361b26a9"
+#define DIAG_CHAR_UUID      "beb5483e-36e1-4688-b7f5-ea07361b26aa"
+#define WAVE_CHAR_UUID      "beb5483e-36e1-4688-b7f5-ea07361b26ab"
+#define BACKLOG_CHAR_UUID   "beb5483e-36e1-4688-b7f5-ea07361b26ac"
+
+// 247 permite tramas de onda de 244 bytes; el cliente puede negociar menos
+#define BLE_MTU 247
+#define MAX_WAVE_FRAMES_PER_TICK 4
+#define MAX_NOTIFY_SIZE 244
+// Peor caso con los cuatro valores en int de 32 bits: 131 caracteres
+#define JSON_VITALS_SIZE 160
+
+// Registro offline en LittleFS: 24 segmentos de 256 × 24 B (6 KB) ≈ 8,5 h
+// de vitales cada 5 s, más el segmento en curso. Los vitales pasan a flash
+// cada minuto; una caída, en cuanto se graba.
+// En el host la simulación lo redirige a su directorio de trabajo
+#ifndef OFFLINE_LOG_DIR
+#define OFFLINE_LOG_DIR "/littlefs"
+#endif
+#define VITALS_LOG_DIR OFFLINE_LOG_DIR "/vitals"
+#define FALL_LOG_DIR   OFFLINE_LOG_DIR "/falls"
+#define VITALS_SEGMENT_RECORDS 256
+#define VITALS_LOG_SEGMENTS 25
+#define VITALS_SYNC_INTERVAL 12
+#define FALL_SEGMENT_RECORDS 16
+#define FALL_LOG_SEGMENTS 5
+#define FALL_SYNC_INTERVAL 1
+// Traza de sensores de 't'; cada grabación reemplaza la anterior
+#define TRACE_PATH      OFFLINE_LOG_DIR "/trace.bin"
+#define TRACE_CHUNK_SIZE 256
+// Tras reconectar se espera a que el cliente active las notificaciones;
+// luego cada pasada envía como mucho este número de lotes para que lo
+// que llega en vivo no se quede detrás del histórico
+#define BACKLOG_START_MS 1000
+#define MAX_BACKLOG_FRAMES_PER_TICK 4
+
+#define DOUT_PIN 32
+#define SCK_PIN 33
+
+#define MPU_INT_PIN 25
+
+#define LED_PIN 14
+#define BUZZER_PIN 19
+
+// La adquisición corre en loop() (núcleo 1); pantalla, BLE y serie en el 0
+#define COMMS_CORE 0
+#define COMMS_STACK_SIZE 8192
+#define COMMS_PERIOD_MS 10
+
+#ifdef ENABLE_PROFILING
+// Etapas del perfil que registra cada núcleo; solo su dueño las reinicia
+static const ProfileStage ACQUISITION_STAGES[] = {
+  PROF_PPG, PROF_IMU, PROF_HX711, PROF_BP, PROF_ALERTS, PROF_REPORT
+};
+static const ProfileStage COMMS_STAGES[] = { PROF_DISPLAY, PROF_BLE, PROF_ENCODE };
+
+static void resetProfileStages(const ProfileStage* stages, size_t count) {
+  for (size_t i = 0; i < count; i++) Profiler::reset(stages[i]);
+}
+#endif
+
+bool isCalibrated = false;
+
+enum CalibrationState {
+  CAL_IDLE,
+  CAL_WAITING_ZERO,
+  CAL_TAKING_ZERO_SAMPLES,
+  CAL_WAITING_PRESSURE,
+  CAL_TAKING_PRESSURE_SAMPLES,
+  CAL_COMPLETE
+};
+
+CalibrationState calState = CAL_IDLE;
+unsigned long calStartTime = 0;
+
+// Lecturas del HX711 promediadas en cada punto de calibración
+const uint16_t CAL_SAMPLES = 15;
+
+DeviceManager::DeviceManager(): 
+  pulseoximeter(), 
+  display(), 
+  fallDetector(MPU_INT_PIN), 
+  bpReader(DOUT_PIN, SCK_PIN), 
+  pulseDetector(&bpReader),
+  led(LED_PIN),
+  buzzer(BUZZER_PIN),
+  vitalsStorage(VITALS_LOG_DIR),
+  fallStorage(FALL_LOG_DIR),
+  vitalsLog(vitalsStorage, VITALS_SEGMENT_RECORDS, VITALS_LOG_SEGMENTS, VITALS_SYNC_INTERVAL,
+            &calibrationStore, "log_vitals"),
+  fallLog(fallStorage, FALL_SEGMENT_RECORDS, FALL_LOG_SEGMENTS, FALL_SYNC_INTERVAL,
+          &calibrationStore, "log_falls"),
+  fallsPublished(0),
+  lastFallMs(0),
+  fallsSent(0),
+  vitalsPending(false),
+  pendingVitals(),
+  recalibrationRequested(false),
+  commsTask(nullptr),
+  statsRequested(false),
+  statsReady(false),
+#ifdef ENABLE_PROFILING
+  profileResetRequested(false),
+#endif
+  traceRequested(false),
+  traceRunning(false),
+  payloadFormat(PAYLOAD_BINARY),
+  frameSequence(0),
+  linkUp(false),
+  linkUpMs(0),
+  vitalsAwaitingSeq(0),
+  fallsAwaitingSeq(0),
+  traceFile(nullptr)
+{
+  alertActive = false;
+}
+
+void DeviceManager::init() {
+  Serial.begin(115200);
+  Log::begin(Serial, COMMS_CORE);
+  MemoryBudget::print(Serial);
+  
+  BLEDevice::init("IOT-01");
+  BLEDevice::setMTU(BLE_MTU);
+  pServer = BLEDevice::createServer();
+  BLEService *pService = pServer->createService(SERVICE_UUID);
+
+  vitalsCharacteristic = pService->createCharacteristic(
+    VITALS_CHAR_UUID,
+    BLECharacteristic::PROPERTY_READ | 
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+
+  fallCharacteristic = pService->createCharacteristic(
+    FALL_CHAR_UUID,
+    BLECharacteristic::PROPERTY_READ | 
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+
+  waveformCharacteristic = pService->createCharacteristic(
+    WAVE_CHAR_UUID,
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+
+  backlogCharacteristic = pService->createCharacteristic(
+    BACKLOG_CHAR_UUID,
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+
+#ifdef ENABLE_PROFILING
+  diagnosticsCharacteristic = pService->createCharacteristic(
+    DIAG_CHAR_UUID,
+    BLECharacteristic::PROPERTY_READ | 
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+#endif
+
+  pService->start();
+  BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
+  pAdvertising->addServiceUUID(SERVICE_UUID);
+  BLEDevice::startAdvertising();
+  Serial.println("BLE listo, esperando conexión...");
+
+  configTime(0, 0, "pool.ntp.org");
+  
+  i2cBus.begin();
+  pulseoximeter.begin();
+  fallDetector.begin();
+  fallDetector.setLowPower(true);
+  bpReader.begin();
+  bpReader.enableInterruptMode();
+  pulseoximeter.setWaveformStreamer(&waveformStreamer);
+  bpReader.setWaveformStreamer(&waveformStreamer);
+  led.begin();
+  buzzer.begin();
+  
+  calibrationStore.begin();
+  if (!restoreCalibration()) {
+    startCalibration();
+  }
+  
+  if (fallDetector.loadCalibration(calibrationStore)) {
+    Serial.println("Sesgo de la IMU restaurado");
+  } else {
+    Serial.println("IMU sin calibrar: se estimará con el equipo quieto (plano, o en varias posturas)");
+  }
+  
+  bool logReady = LittleFS.begin(true);
+  if (!logReady || !vitalsLog.begin() || !fallLog.begin()) {
+    Serial.println("Registro offline no disponible");
+  } else if (vitalsLog.pending() > 0 || fallLog.pending() > 0) {
+    Serial.printf("Registro offline: %lu vitales y %lu caídas por enviar\n",
+                  (unsigned long)vitalsLog.pending(), (unsigned long)fallLog.pending());
+  }
+  
+  pulseDetector.setThreshold(3.0f);
+  pulseDetector.setMinPeakDistance(400);
+  
+  // Periodo y presupuesto (us) de cada subsistema
+  scheduler.addTask("ppg",    runPulseoximeterTask, this,  10000,  2000);
+  scheduler.addTask("imu",    runFallDetectorTask,  this,  10000,  1000);
+  scheduler.addTask("bp",     runBloodPressureTask, this,  10000,  1000);
+  scheduler.addTask("alertas", runAlertsTask,       this,  20000,  1000);
+  scheduler.addTask("reporte", runReportTask,       this, 100000,   500);
+  
+  display.init();
+  display.clear();
+  display.printPresentation();
+  display.display();
+  
+  // El resto de init() bloquea más de lo que cabe en el anillo del MAX30102
+  pulseoximeter.startSampling();
+  xTaskCreatePinnedToCore(commsTaskEntry, "comms", COMMS_STACK_SIZE, this, 1, &commsTask, COMMS_CORE);
+  
+  Serial.println("Sistema inicializado\n");
+}
+
+void DeviceManager::startCalibration() {
+  calState = CAL_WAITING_ZERO;
+  calStartTime = Clock::millis();
+  bpReader.resetCalibrationSamples();
+  isCalibrated = false;
+}
+
+bool DeviceManager::restoreCalibration() {
+  if (!bpReader.loadCalibration(calibrationStore)) {
+    Serial.println("Sin calibración guardada válida, calibrando...");
+    return false;
+  }
+  
+  Serial.print("Calibración restaurada. Offset: ");
+  Serial.print(bpReader.getOffsetCounts(), 1);
+  Serial.print("  Counts/kPa: ");
+  Serial.println(bpReader.getCountsPerKPa(), 2);
+  
+  isCalibrated = true;
+  calState = CAL_IDLE;
+  return true;
+}
+
+void DeviceManager::startTrace() {
+  traceWriter.begin(traceBuffer);
+  pulseoximeter.setTraceWriter(&traceWriter);
+  fallDetector.setTraceWriter(&traceWriter);
+  bpReader.setTraceWriter(&traceWriter);
+}
+
+void DeviceManager::stopTrace() {
+  pulseoximeter.setTraceWriter(nullptr);
+  fallDetector.setTraceWriter(nullptr);
+  bpReader.setTraceWriter(nullptr);
+  traceWriter.end();
+}
+
+void DeviceManager::updateCalibration() {
+  unsigned long now = Clock::millis();
+  long raw;
+  
+  switch (calState) {
+    case CAL_IDLE:
+      break;
+      
+    case CAL_WAITING_ZERO:
+      // Descartar lecturas mientras el brazalete se estabiliza
+      while (bpReader.readSample(raw)) {}
+      
+      if (now - calStartTime >= 3000) {
+        calState = CAL_TAKING_ZERO_SAMPLES;
+        bpReader.resetCalibrationSamples();
+      }
+      break;
+      
+    case CAL_TAKING_ZERO_SAMPLES:
+      while (bpReader.readSample(raw)) {
+        bpReader.addCalibrationSample(raw);
+        
+        if (bpReader.getCalibrationSampleCount() >= CAL_SAMPLES) {
+          bpReader.applyZeroCalibration();
+          
+          calState = CAL_WAITING_PRESSURE;
+          calStartTime = Clock::millis();
+          break;
+        }
+      }
+      break;
+      
+    case CAL_WAITING_PRESSURE:
+      {
+        while (bpReader.readSample(raw)) {}
+        
+        unsigned long elapsed = now - calStartTime;
+        if (elapsed >= 8000) {
+          calState = CAL_TAKING_PRESSURE_SAMPLES;
+          bpReader.resetCalibrationSamples();
+        }
+      }
+      break;
+      
+    case CAL_TAKING_PRESSURE_SAMPLES:
+      while (bpReader.readSample(raw)) {
+        bpReader.addCalibrationSample(raw);
+        
+        if (bpReader.getCalibrationSampleCount() >= CAL_SAMPLES) {
+          float knownPressure = 100.0f;
+          bool success = bpReader.applyPointCalibration(knownPressure);
+          
+          if (success) {
+            if (!bpReader.saveCalibration(calibrationStore)) {
+              LOG_ERROR("No se pudo guardar la calibración");
+            }
+            isCalibrated = true;
+          } else {
+            isCalibrated = false;
+          }
+          
+          calState = CAL_COMPLETE;
+          break;
+        }
+      }
+      break;
+      
+    case CAL_COMPLETE:
+      calState = CAL_IDLE;
+      break;
+  }
+}
+
+void DeviceManager::handleSerialCommands() {
+  while (Serial.available() > 0) {
+    char cmd = (char)Serial.read();
+    
+    switch (cmd) {
+      case 'c':
+        // La calibración pertenece al lado de adquisición
+        Serial.println("Recalibración solicitada");
+        recalibrationRequested.store(true);
+        break;
+        
+      case 's':
+        // Lo del núcleo 1 lo copia él; se imprime cuando esté listo
+        statsRequested.store(true);
+        break;
+        
+      case 't':
+        toggleTrace();
+        break;
+        
+      case 'j':
+        if (payloadFormat == PAYLOAD_JSON) {
+          setPayloadFormat(PAYLOAD_BINARY);
+          Serial.println("Formato BLE: binario");
+        } else {
+          setPayloadFormat(PAYLOAD_JSON);
+          Serial.println("Formato BLE: JSON (compatibilidad)");
+        }
+        break;
+        
+#ifdef ENABLE_PROFILING
+      case 'p':
+        publishProfile();
+        break;
+        
+      case 'r':
+        // Cada núcleo reinicia solo las etapas que él registra
+        resetProfileStages(COMMS_STAGES, sizeof(COMMS_STAGES) / sizeof(COMMS_STAGES[0]));
+        profileResetRequested.store(true);
+        Serial.println("Perfil reiniciado");
+        break;
+#endif
+        
+      default:
+        break;
+    }
+  }
+}
+
+void DeviceManager::printStats() {
+  if (!statsReady.load(std::memory_order_acquire)) return;
+  
+  const AcquisitionStats& acq = acquisitionStats;
+  TaskScheduler::printReport(acq.scheduler, Serial);
+  Serial.printf("Ondas: %lu tramas, %lu muestras, %lu bytes, descartadas PPG %lu / presión %lu\n",
+                (unsigned long)waveformStreamer.getFramesSent(),
+                (unsigned long)waveformStreamer.getSamplesSent(),
+                (unsigned long)waveformStreamer.getBytesSent(),
+                (unsigned long)waveformStreamer.getDropped(WAVE_PPG),
+                (unsigned long)waveformStreamer.getDropped(WAVE_PRESSURE));
+  I2CBus::Stats i2c[I2CBus::PRIORITY_COUNT];
+  i2c[I2CBus::PRIORITY_SENSOR] = acq.i2cSensors;
+  i2c[I2CBus::PRIORITY_DISPLAY] = i2cBus.getStats(I2CBus::PRIORITY_DISPLAY);
+  I2CBus::printStats(i2c, Serial);
+  Serial.printf("OLED: %lu bytes I2C (última actualización %lu)\n",
+                (unsigned long)display.getBytesSent(),
+                (unsigned long)display.getLastFlushBytes());
+  Serial.printf("IMU: %lu interrupciones, %lu despertares, %lu transacciones I2C, %lu bytes, %lu desbordes del FIFO\n",
+                (unsigned long)acq.imuInterrupts,
+                (unsigned long)acq.imu.wakeups,
+                (unsigned long)acq.imu.busTransactions,
+                (unsigned long)acq.imu.bytesRead,
+                (unsigned long)acq.imuFifoOverflows);
+  Serial.printf("IMU bajo consumo: %s, %lu entradas, %lu s acumulados, %lu despertares por caída libre\n",
+                acq.imuLowPower ? "sí" : "no",
+                (unsigned long)acq.imu.lowPowerEntries,
+                (unsigned long)(acq.imu.lowPowerMs / 1000),
+                (unsigned long)acq.imu.freefallWakes);
+  if (acq.imuCalibrated) {
+    Serial.printf("IMU sesgo: %d, %d, %d cuentas\n", acq.imuBias[0], acq.imuBias[1], acq.imuBias[2]);
+  } else {
+    Serial.printf("IMU calibración pendiente: %u de %u posturas quietas (plano, una basta)\n",
+                  (unsigned)acq.imuOrientations, (unsigned)FallDetector::MIN_ORIENTATIONS);
+  }
+  Serial.printf("PPG: %lu muestras perdidas en el anillo de la librería\n",
+                (unsigned long)acq.ppgDropped);
+  Serial.printf("Registro offline: %lu vitales y %lu caídas pendientes, %lu pisados, %lu corruptos\n",
+                (unsigned long)vitalsLog.pending(),
+                (unsigned long)fallLog.pending(),
+                (unsigned long)(vitalsLog.getOverwritten() + fallLog.getOverwritten()),
+                (unsigned long)(vitalsLog.getCorrupt() + fallLog.getCorrupt()));
+  Serial.printf("Log: %lu mensajes descartados\n", (unsigned long)Log::dropped());
+  Serial.printf("Eventos: %lu avisos de vitales descartados con la cola llena, %lu caídas enviadas\n",
+                (unsigned long)events.dropped(), (unsigned long)fallsSent);
+  VitalsSnapshot vitals;
+  if (latestVitals.version() > 0 && latestVitals.read(vitals)) {
+    Serial.printf("Vitales: BPM %d, SpO2 %d, PA %d/%d, alerta %s (hace %lu ms)\n",
+                  vitals.bpm, vitals.spo2, vitals.systolic, vitals.diastolic,
+                  vitals.alert ? "sí" : "no",
+                  (unsigned long)(Clock::millis() - vitals.timestampMs));
+  }
+  Serial.printf("Heap: %lu libres, mínimo %lu, bloque mayor %lu\n",
+                (unsigned long)ESP.getFreeHeap(),
+                (unsigned long)ESP.getMinFreeHeap(),
+                (unsigned long)ESP.getMaxAllocHeap());
+  
+  statsReady.store(false, std::memory_order_release);
+}
+
+void DeviceManager::toggleTrace() {
+  if (traceRequested.load()) {
+    traceRequested.store(false);
+    Serial.println("Traza: parando...");
+    return;
+  }
+  if (traceFile) {
+    Serial.println("Traza: aún se está cerrando la anterior");
+    return;
+  }
+  
+  traceFile = fopen(TRACE_PATH, "wb");
+  if (!traceFile) {
+    Serial.println("Traza: no se pudo crear " TRACE_PATH);
+    return;
+  }
+  traceRequested.store(true);
+  Serial.println("Traza: grabando en " TRACE_PATH " ('t' para parar)");
+}
+
+void DeviceManager::drainTrace() {
+  if (!traceFile) return;
+  
+  // Se lee el estado antes de vaciar: si la adquisición ya paró, todo lo
+  // que escribió está en el buffer
+  bool stopped = !traceRequested.load() && !traceRunning.load(std::memory_order_acquire);
+  
+  uint8_t chunk[TRACE_CHUNK_SIZE];
+  size_t n;
+  while ((n = traceBuffer.read(chunk, sizeof(chunk))) > 0) {
+    fwrite(chunk, 1, n, traceFile);
+  }
+  
+  if (stopped && traceBuffer.empty()) {
+    fclose(traceFile);
+    traceFile = nullptr;
+    Serial.printf("Traza: %lu registros, %lu bytes, %lu descartados, %lu fuera de orden\n",
+                  (unsigned long)traceWriter.getRecordCount(),
+                  (unsigned long)traceWriter.getBytesWritten(),
+                  (unsigned long)traceWriter.getDropped(),
+                  (unsigned long)traceWriter.getClamped());
+  }
+}
+
+void DeviceManager::runPulseoximeterTask(void* ctx) {
+  PROFILE_SCOPE(PROF_PPG);
+  static_cast<DeviceManager*>(ctx)->pulseoximeter.on();
+}
+
+void DeviceManager::runFallDetectorTask(void* ctx) {
+  PROFILE_SCOPE(PROF_IMU);
+  DeviceManager* self = static_cast<DeviceManager*>(ctx);
+  self->fallDetector.on();
+  
+  if (self->fallDetector.takeCalibrationUpdate()) {
+    if (self->fallDetector.saveCalibration(self->calibrationStore)) {
+      LOG_INFO("Sesgo de la IMU estimado y guardado");
+    } else {
+      LOG_ERROR("No se pudo guardar el sesgo de la IMU");
+    }
+  }
+}
+
+void DeviceManager::runBloodPressureTask(void* ctx) {
+  PROFILE_SCOPE(PROF_BP);
+  static_cast<DeviceManager*>(ctx)->serviceBloodPressure();
+}
+
+void DeviceManager::runAlertsTask(void* ctx) {
+  PROFILE_SCOPE(PROF_ALERTS);
+  static_cast<DeviceManager*>(ctx)->serviceAlerts();
+}
+
+void DeviceManager::runReportTask(void* ctx) {
+  PROFILE_SCOPE(PROF_REPORT);
+  static_cast<DeviceManager*>(ctx)->reportVitals();
+}
+
+void DeviceManager::commsTaskEntry(void* ctx) {
+  DeviceManager* self = static_cast<DeviceManager*>(ctx);
+  for (;;) {
+    self->updateLink();
+    self->handleSerialCommands();
+    self->printStats();
+    self->drainTrace();
+    self->processEvents();
+    self->streamWaveforms();
+    self->drainBacklog();
+    vTaskDelay(pdMS_TO_TICKS(COMMS_PERIOD_MS));
+  }
+}
+
+void DeviceManager::manage() {
+  serviceRequests();
+  scheduler.runOnce();
+}
+
+void DeviceManager::serviceRequests() {
+  // Entre tarea y tarea nada del núcleo 1 está a medio escribir
+  if (statsRequested.load(std::memory_order_acquire) &&
+      !statsReady.load(std::memory_order_acquire)) {
+    statsRequested.store(false);
+    AcquisitionStats& acq = acquisitionStats;
+    scheduler.getReport(acq.scheduler);
+    // Como hacía 's' antes de pasar a comunicaciones: cada informe cubre
+    // el intervalo desde el anterior
+    scheduler.resetStats();
+    acq.i2cSensors = i2cBus.getStats(I2CBus::PRIORITY_SENSOR);
+    acq.imu = fallDetector.getStats();
+    acq.imuInterrupts = fallDetector.getInterruptCount();
+    acq.imuFifoOverflows = fallDetector.getFifoOverflows();
+    acq.imuLowPower = fallDetector.isLowPower();
+    acq.imuCalibrated = fallDetector.isCalibrated();
+    acq.imuOrientations = fallDetector.getCalibrationOrientations();
+    fallDetector.getBias(acq.imuBias[0], acq.imuBias[1], acq.imuBias[2]);
+    acq.ppgDropped = pulseoximeter.getDroppedSamples();
+    statsReady.store(true, std::memory_order_release);
+  }
+  
+#ifdef ENABLE_PROFILING
+  if (profileResetRequested.exchange(false)) {
+    resetProfileStages(ACQUISITION_STAGES, sizeof(ACQUISITION_STAGES) / sizeof(ACQUISITION_STAGES[0]));
+  }
+#endif
+  
+  bool traceWanted = traceRequested.load();
+  if (traceWanted != traceWriter.isActive()) {
+    if (traceWanted) {
+      startTrace();
+    } else {
+      stopTrace();
+    }
+    traceRunning.store(traceWanted, std::memory_order_release);
+  }
+}
+
+void DeviceManager::serviceBloodPressure() {
+  if (recalibrationRequested.exchange(false)) {
+    performCalibration();
+  }
+  
+  // La calibración avanza con las muestras que van llegando, sin bloquear
+  if (calState != CAL_IDLE && calState != CAL_COMPLETE) {
+    updateCalibration();
+  } else {
+    pulseDetector.update();
+  }
+}
+
+void DeviceManager::reportVitals() {
+  pulseDetector.clearNewReading();
+  
+  VitalsSnapshot vitals;
+  vitals.bpm = pulseoximeter.getAverageBPM();
+  vitals.spo2 = pulseoximeter.getSpO2();
+  vitals.systolic = (int)pulseDetector.getSystolic();
+  vitals.diastolic = (int)pulseDetector.getDiastolic();
+  vitals.pulseCount = pulseDetector.getPulseCount();
+  vitals.timestampMs = Clock::millis();
+  
+  bool ready = pulseoximeter.getPrintStatus();
+  if (ready) {
+    if (vitals.bpm < 60 || vitals.bpm > 100 || vitals.spo2 < 92) {
+      alertActive = true;
+    } else {
+      alertActive = false;
+    }
+  }
+  vitals.alert = alertActive;
+  latestVitals.write(vitals);
+  
+  if (ready) {
+    DeviceEvent event;
+    event.type = DeviceEvent::VITALS;
+    event.timestampMs = vitals.timestampMs;
+    
+    publishEvent(event);
+    pulseoximeter.setPrintStatus(false);
+  }
+}
+
+void DeviceManager::serviceAlerts() {
+  buzzer.update();
+  
+  if (fallDetector.wasFallDetected()) {
+    alertActive = true;
+    
+    DeviceEvent event = {};
+    event.type = DeviceEvent::FALL;
+    event.timestampMs = Clock::millis();
+    publishEvent(event);
+  }
+
+  if (alertActive) {
+    led.on();
+    static unsigned long lastBeep = 0;
+    if (Clock::millis() - lastBeep > 500) {
+        buzzer.beep(200); 
+        lastBeep = Clock::millis();
+    }
+  } else {
+    led.off();
+  }
+}
+
+void DeviceManager::publishEvent(const DeviceEvent& event) {
+  if (event.type == DeviceEvent::FALL) {
+    lastFallMs.store(event.timestampMs, std::memory_order_relaxed);
+    fallsPublished.fetch_add(1, std::memory_order_release);
+    return;
+  }
+  // Si comunicaciones va atrasada se descarta el aviso (la cola lo cuenta);
+  // nunca se espera
+  events.push(event);
+}
+
+void DeviceManager::processEvents() {
+  // Las caídas primero, antes que cualquier vital
+  uint32_t published = fallsPublished.load(std::memory_order_acquire);
+  while (fallsSent != published) {
+    DeviceEvent fall = {};
+    fall.type = DeviceEvent::FALL;
+    fall.timestampMs = lastFallMs.load(std::memory_order_relaxed);
+    sendFallAlert(fall);
+    fallsSent++;
+  }
+
+  // Si entretanto llegó otro aviso, ese ya lee lo último publicado
+  if (vitalsPending && events.empty()) sendVitals(pendingVitals);
+
+  DeviceEvent event;
+  while (events.pop(event)) {
+    if (event.type == DeviceEvent::VITALS) sendVitals(event);
+  }
+}
+
+void DeviceManager::sendVitals(const DeviceEvent& event) {
+  // Una sola lectura para pantalla, log y BLE: todos muestran el mismo
+  // instante, el último publicado
+  VitalsSnapshot reading;
+  if (!latestVitals.read(reading)) {
+    LOG_WARN("Vitales: lectura a medias, se reintenta el informe de %lu ms",
+             (unsigned long)event.timestampMs);
+    vitalsPending = true;
+    pendingVitals = event;
+    return;
+  }
+  vitalsPending = false;
+  LOG_INFO("BPM=%d SpO2=%d BP=%d/%d", reading.bpm, reading.spo2, reading.systolic, reading.diastolic);
+  
+  {
+    PROFILE_SCOPE(PROF_DISPLAY);
+    char text[8];
+    
+    snprintf(text, sizeof(text), "%d", reading.bpm);
+    display.setField(FIELD_BPM, text);
+    snprintf(text, sizeof(text), "%d%%", reading.spo2);
+    display.setField(FIELD_SPO2, text);
+
+    if (reading.pulseCount > 0) {
+      snprintf(text, sizeof(text), "%d/%d", reading.systolic, reading.diastolic);
+      display.setField(FIELD_BP, text);
+    }
+    
+    display.setAlert(reading.alert);
+    display.flush();
+  }
+
+  PROFILE_SCOPE(PROF_BLE);
+  if (linkUp && payloadFormat == PAYLOAD_JSON) {
+    // Mismo texto que generaba ArduinoJson (valores entre comillas), sin
+    // pasar por String ni por el heap
+    static char json[JSON_VITALS_SIZE];
+    int n;
+    {
+      PROFILE_SCOPE(PROF_ENCODE);
+      n = snprintf(json, sizeof(json),
+                   "{\"device\":\"IOT-01\",\"type\":\"vitals\",\"bpm\":\"%d\",\"spo2\":\"%d\","
+                   "\"bpSystolic\":\"%d\",\"bpDiastolic\":\"%d\"}",
+                   reading.bpm, reading.spo2, reading.systolic, reading.diastolic);
+    }
+    if (n < 0 || (size_t)n >= sizeof(json)) return;
+    vitalsCharacteristic->setValue((uint8_t*)json, (size_t)n);
+    vitalsCharacteristic->notify();
+    return;
+  }
+
+  static uint8_t frame[VITALS_FRAME_MAX_SIZE];
+  size_t len;
+  {
+    PROFILE_SCOPE(PROF_ENCODE);
+    VitalsFrame vitals;
+    vitals.type = VitalsFrame::VITALS;
+    vitals.sequence = frameSequence++;
+    vitals.timestampMs = reading.timestampMs;
+    vitals.bpm = (uint8_t)constrain(reading.bpm, 0, 255);
+    vitals.spo2 = reading.spo2 < 0 ? VITALS_FRAME_NO_SPO2 : (uint8_t)constrain(reading.spo2, 0, 100);
+    vitals.systolic = (int16_t)reading.systolic;
+    vitals.diastolic = (int16_t)reading.diastolic;
+    vitals.flags = (reading.alert ? VitalsFrame::FLAG_ALERT : 0) |
+                   (reading.pulseCount > 0 ? VitalsFrame::FLAG_BP_VALID : 0);
+    len = encodeVitalsFrame(vitals, frame, sizeof(frame));
+  }
+  
+  // Sin cliente se guarda siempre en binario, sea cual sea el formato
+  if (!linkUp) {
+    vitalsLog.append(frame, len);
+    return;
+  }
+  vitalsCharacteristic->setValue(frame, len);
+  vitalsCharacteristic->notify();
+}
+
+void DeviceManager::sendFallAlert(const DeviceEvent& event) {
+  LOG_WARN("*** CAÍDA DETECTADA ***");
+
+  {
+    PROFILE_SCOPE(PROF_DISPLAY);
+    display.setAlert(true);
+    display.flush();
+  }
+
+  PROFILE_SCOPE(PROF_BLE);
+  if (linkUp && payloadFormat == PAYLOAD_JSON) {
+    static const char json[] = "{\"device\":\"IOT-01\",\"type\":\"fall_alert\"}";
+    fallCharacteristic->setValue((uint8_t*)json, sizeof(json) - 1);
+    fallCharacteristic->notify();
+    return;
+  }
+
+  static uint8_t frame[VITALS_FRAME_HEADER_SIZE];
+  VitalsFrame alert = {};
+  alert.type = VitalsFrame::FALL_ALERT;
+  alert.sequence = frameSequence++;
+  alert.timestampMs = event.timestampMs;
+  size_t len = encodeVitalsFrame(alert, frame, sizeof(frame));
+  if (!linkUp) {
+    fallLog.append(frame, len);
+    return;
+  }
+  fallCharacteristic->setValue(frame, len);
+  fallCharacteristic->notify();
+}
+
+static size_t maxNotifyLength() {
+  // El MTU lo negocia el cliente; 3 bytes son de la cabecera ATT
+  uint16_t mtu = pServer->getPeerMTU(pServer->getConnId());
+  size_t maxLen = mtu > 23 ? mtu - 3 : 20;
+  return maxLen < MAX_NOTIFY_SIZE ? maxLen : MAX_NOTIFY_SIZE;
+}
+
+void DeviceManager::updateLink() {
+  bool connected = pServer->getConnectedCount() > 0;
+  if (connected && !linkUp) {
+    linkUpMs = Clock::millis();
+    // Se acaba el tramo sin cliente: lo que quede en el buffer, a flash
+    vitalsLog.sync();
+  } else if (!connected && linkUp) {
+    // Al conectar se deja de anunciar; sin esto no habría reconexión
+    BLEDevice::startAdvertising();
+    // Las notificaciones de la última pasada pudieron no salir: se reenvían
+    vitalsLog.rewind();
+    fallLog.rewind();
+    vitalsAwaitingSeq = 0;
+    fallsAwaitingSeq = 0;
+  }
+  linkUp = connected;
+}
+
+void DeviceManager::streamWaveforms() {
+  if (!linkUp) {
+    waveformStreamer.discardPending();
+    return;
+  }
+  
+  size_t maxLen = maxNotifyLength();
+  static uint8_t frame[WaveformStreamer::MAX_FRAME_SIZE];
+  for (uint8_t i = 0; i < MAX_WAVE_FRAMES_PER_TICK; i++) {
+    size_t len = waveformStreamer.nextFrame(frame, maxLen, Clock::millis());
+    if (len == 0) break;
+    
+    waveformCharacteristic->setValue(frame, len);
+    waveformCharacteristic->notify();
+  }
+}
+
+void DeviceManager::drainBacklog() {
+  if (!linkUp) return;
+
+  // notify() no confirma nada: lo enviado en la pasada anterior se da por
+  // entregado si el enlace sigue arriba una pasada después
+  if (fallsAwaitingSeq != 0) fallLog.commit(fallsAwaitingSeq);
+  if (vitalsAwaitingSeq != 0) vitalsLog.commit(vitalsAwaitingSeq);
+  fallsAwaitingSeq = 0;
+  vitalsAwaitingSeq = 0;
+
+  if (Clock::millis() - linkUpMs < BACKLOG_START_MS) return;
+  
+  size_t maxLen = maxNotifyLength();
+  static uint8_t batch[MAX_NOTIFY_SIZE];
+  for (uint8_t i = 0; i < MAX_BACKLOG_FRAMES_PER_TICK; i++) {
+    // Las caídas guardadas salen antes que cualquier vital atrasado
+    uint32_t lastSeq = 0;
+    size_t len = fallLog.peekBatch(batch, maxLen, lastSeq);
+    if (len > 0) {
+      fallsAwaitingSeq = lastSeq;
+    } else {
+      len = vitalsLog.peekBatch(batch, maxLen, lastSeq);
+      if (len == 0) break;
+      vitalsAwaitingSeq = lastSeq;
+    }
+    
+    backlogCharacteristic->setValue(batch, len);
+    backlogCharacteristic->notify();
+  }
+}
+
+void DeviceManager::setPayloadFormat(PayloadFormat format) {
+  payloadFormat = format;
+}
+
+#ifdef ENABLE_PROFILING
+void DeviceManager::publishProfile() {
+  static char report[384];
+  
+  Profiler::printReport(Serial);
+  
+  size_t len = Profiler::format(report, sizeof(report));
+  diagnosticsCharacteristic->setValue((uint8_t*)report, len);
+  diagnosticsCharacteristic->notify();
+}
+#endif
+
+void DeviceManager::performCalibration() {
+  startCalibration();
+}
+
+void DeviceManager::manualCalibration() {
+
+  float offsetCounts = 233000.0f;
+  float countsPerKPa = 187.5f;
+  
+  bpReader.setCalibration(offsetCounts, countsPerKPa);
+  
+  Serial.print("  Offset:      ");
+  Serial.println(offsetCounts, 1);
+  Serial.print("  Counts/kPa:  ");
+  Serial.println(countsPerKPa, 2);
+  Serial.println();
+  
+  isCalibrated = true;
+  calState = CAL_IDLE;
+}
+
+void DeviceManager::classifyBP(float systolic, float diastolic) {
+  Serial.print("   Clasificación: ");
+  
+  if (systolic < 90 || diastolic < 60) {
+    Serial.println("⬇️  HIPOTENSIÓN (Baja)");
+  } else if (systolic < 120 && diastolic < 80) {
+    Serial.println("NORMAL");
+  } else if (systolic < 130 && diastolic < 80) {
+    Serial.println("ELEVADA");
+  } else if (systolic < 140 || diastolic < 90) {
+    Serial.println("HIPERTENSIÓN Etapa 1");
+  } else if (systolic < 180 || diastolic < 120) {
+    Serial.println("HIPERTENSIÓN Etapa 2");
+  } else {
+    Serial.println("CRISIS HIPERTENSIVA");
+  }
 }
\ No newline at end of file
@@ -1,33 +1,163 @@
-#ifndef DEVICE_MANAGER_H
-#define DEVICE_MANAGER_H
-
-#include <Pulseoximeter.h>
-#include <Display.h>
-#include <FallDetector.h>
-#include <BloodPressureReader.h>
-#include <BPPulseDetector.h>
-#include <Led.h>
-#include <Buzzer.h>
-
-class DeviceManager {
-  private:
-    Pulseoximeter pulseoximeter;
-    Display display;
-    FallDetector fallDetector;
-    BloodPressureReader bpReader;
-    BPPulseDetector pulseDetector;
-    Led led;
-    Buzzer buzzer;
-    bool alertActive;
-  public:
-    DeviceManager();
-    void init();
-    void manage();
-    void performCalibration();
-    void manualCalibration();
-    void classifyBP(float systolic, float diastolic);
-    void startCalibration();
-    void updateCalibration();
-};
-
+#ifndef DEVICE_MANAGER_H
+#define DEVICE_MANAGER_H
+
+#include <Pulseoximeter.h>
+#include <Display.h>
+#include <FallDetector.h>
+#include <BloodPressureReader.h>
+#include <BPPulseDetector.h>
+#include <Led.h>
+#include <Buzzer.h>
+#include <CalibrationStore.h>
+#include <TaskScheduler.h>
+#include <I2CBus.h>
+#include <SpscRing.h>
+#include <SeqLock.h>
+#include <Profiler.h>
+#include <SensorTrace.h>
+#include <WaveformStreamer.h>
+#include <VitalsLog.h>
+#include <atomic>
+
+// Signos vitales leídos de una vez en la misma pasada de la adquisición,
+// para que nadie combine valores de momentos distintos
+struct VitalsSnapshot {
+  int bpm;
+  int spo2;              // -1 sin estimación
+  int systolic;
+  int diastolic;
+  uint32_t pulseCount;   // 0: presión aún sin medir
+  uint32_t timestampMs;
+  bool alert;
+};
+
+// Lo que la adquisición publica hacia el núcleo de comunicaciones. VITALS
+// solo avisa de que hay informe: los valores se leen de latestVitals
+struct DeviceEvent {
+  enum Type : uint8_t { VITALS, FALL };
+  Type type;
+  uint32_t timestampMs;
+};
+
+class DeviceManager {
+  public:
+    // Binario (VitalsFrame) por defecto; JSON para clientes antiguos
+    enum PayloadFormat : uint8_t { PAYLOAD_BINARY, PAYLOAD_JSON };
+
+  private:
+    Pulseoximeter pulseoximeter;
+    Display display;
+    FallDetector fallDetector;
+    BloodPressureReader bpReader;
+    BPPulseDetector pulseDetector;
+    Led led;
+    Buzzer buzzer;
+    NvsCalibrationStore calibrationStore;
+    TaskScheduler scheduler;
+    SensorTraceWriter traceWriter;
+    TraceBuffer traceBuffer;
+    WaveformStreamer waveformStreamer;
+    FileLogStorage vitalsStorage;
+    FileLogStorage fallStorage;
+    VitalsLog vitalsLog;
+    VitalsLog fallLog;
+    bool alertActive;
+
+    // Adquisición (loop, núcleo 1) → comunicaciones (núcleo 0), sin bloqueo.
+    // Solo lleva avisos de vitales: si se llena, se descartan y se cuentan
+    SpscRing<DeviceEvent, 16> events;
+    // Las caídas no pasan por la cola para que ninguna se pierda: la
+    // adquisición incrementa el contador y comunicaciones envía una alerta
+    // por cada una que aún no haya enviado
+    std::atomic<uint32_t> fallsPublished;
+    std::atomic<uint32_t> lastFallMs;
+    uint32_t fallsSent;
+    // Últimos vitales, reescritos en cada pasada de reportVitals
+    SeqLock<VitalsSnapshot> latestVitals;
+    // Informe cuya lectura de latestVitals salió a medias; se reintenta en
+    // la siguiente pasada de comunicaciones
+    bool vitalsPending;
+    DeviceEvent pendingVitals;
+    std::atomic<bool> recalibrationRequested;
+    TaskHandle_t commsTask;
+
+    // Lo que escribe el núcleo 1, copiado por él mismo cuando 's' lo pide.
+    // Comunicaciones solo lo lee con statsReady activo y lo suelta al
+    // terminar de imprimir.
+    struct AcquisitionStats {
+      TaskScheduler::Report scheduler;
+      I2CBus::Stats i2cSensors;
+      FallDetector::Stats imu;
+      uint32_t imuInterrupts;
+      uint32_t imuFifoOverflows;
+      bool imuLowPower;
+      bool imuCalibrated;
+      uint8_t imuOrientations;
+      int16_t imuBias[3];
+      uint32_t ppgDropped;
+    };
+    AcquisitionStats acquisitionStats;
+    std::atomic<bool> statsRequested;
+    std::atomic<bool> statsReady;
+#ifdef ENABLE_PROFILING
+    std::atomic<bool> profileResetRequested;
+#endif
+    // 't' pide grabar o parar; la adquisición arranca o para el escritor
+    // entre tarea y tarea y lo confirma en traceRunning
+    std::atomic<bool> traceRequested;
+    std::atomic<bool> traceRunning;
+
+    // Solo los usa el lado de comunicaciones
+    PayloadFormat payloadFormat;
+    uint16_t frameSequence;
+    bool linkUp;
+    unsigned long linkUpMs;
+    // Última secuencia enviada de cada registro, pendiente de confirmar
+    // (0: nada). Se confirma si el enlace sigue arriba en la pasada siguiente
+    uint32_t vitalsAwaitingSeq;
+    uint32_t fallsAwaitingSeq;
+    FILE* traceFile;
+
+    void handleSerialCommands();
+    void serviceRequests();
+    void printStats();
+    void toggleTrace();
+    void drainTrace();
+    void startTrace();
+    void stopTrace();
+    void serviceBloodPressure();
+    void reportVitals();
+    void serviceAlerts();
+    void publishEvent(const DeviceEvent& event);
+    void processEvents();
+    void sendVitals(const DeviceEvent& event);
+    void sendFallAlert(const DeviceEvent& event);
+    void streamWaveforms();
+    void updateLink();
+    void drainBacklog();
+#ifdef ENABLE_PROFILING
+    void publishProfile();
+#endif
+
+    static void runPulseoximeterTask(void* ctx);
+    static void runFallDetectorTask(void* ctx);
+    static void runBloodPressureTask(void* ctx);
+    static void runAlertsTask(void* ctx);
+    static void runReportTask(void* ctx);
+    static void commsTaskEntry(void* ctx);
+  public:
+    DeviceManager();
+    void init();
+    void manage();
+    void performCalibration();
+    void manualCalibration();
+    void classifyBP(float systolic, float diastolic);
+    void startCalibration();
+    void updateCalibration();
+    bool restoreCalibration();
+
+    // Llamar desde el lado de comunicaciones o antes de init()
+    void setPayloadFormat(PayloadFormat format);
+};
+
 #endif
\ No newline at end of file
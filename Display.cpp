@@ -1,42 +1,240 @@
-#include <Display.h>
-#include <Wire.h>
-#include <Arduino.h>
-
-#define SCREEN_WIDTH 128  
-#define SCREEN_HEIGHT 64  
-#define OLED_RESET -1
-
-Display::Display(): oled(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET) {
-
-}
-
-void Display::init() {
-  if(!oled.begin(SSD1306_SWITCHCAPVCC, 0x3C)) { 
-    Serial.println("ERROR: No se encontró la pantalla OLED");
-    while (true); 
-  }
-}
-
-void Display::clear() {
-  oled.clearDisplay();
-}
-
-void Display::display() {
-  oled.display();
-}
-
-void Display::print(int y, int x, int textSize, String text) {
-  oled.setTextSize(textSize);
-  oled.setTextColor(SSD1306_WHITE);
-  oled.setCursor(x, y);
-  oled.println(text);
-}
-
-void Display::printPresentation() {
-  oled.setTextSize(3);
-  oled.setTextColor(SSD1306_WHITE);
-  oled.setCursor(0, 0);
-  oled.println("ALERTA");
-  oled.setCursor(0, 24);
-  oled.println("VITAL");
-}
+#include <Display.h>
+#include <I2CBus.h>
+#include <Wire.h>
+#include <Arduino.h>
+
+#define SCREEN_WIDTH 128  
+#define SCREEN_HEIGHT 64  
+#define OLED_RESET -1
+#define OLED_ADDR 0x3C
+
+#define SSD1306_PAGE_ROWS 8
+#define SSD1306_PAGES (SCREEN_HEIGHT / SSD1306_PAGE_ROWS)
+
+// Texto tamaño 2: 12x16 px por carácter, dos páginas de alto
+#define FIELD_CHAR_W 12
+#define FIELD_HEIGHT 16
+
+struct FieldLayout {
+  const char* label;
+  uint8_t page;     // primera de las dos páginas del campo
+  uint8_t valueX;   // las etiquetas no se redibujan nunca
+  uint8_t width;
+};
+
+static const FieldLayout LAYOUT[FIELD_COUNT] = {
+  { "BPM:",  0, 60, 68 },
+  { "SpO2:", 2, 72, 56 },
+  { "BP:",   4, 40, 88 },
+};
+
+#define ALERT_PAGE 6
+#define ALERT_X 112
+#define ALERT_W 16
+
+static const uint8_t ALERT_ICON[] PROGMEM = {
+  0x01, 0x80, 0x03, 0xC0, 0x03, 0xC0, 0x06, 0x60,
+  0x06, 0x60, 0x0D, 0xB0, 0x0D, 0xB0, 0x19, 0x98,
+  0x19, 0x98, 0x31, 0x8C, 0x30, 0x0C, 0x61, 0x86,
+  0x61, 0x86, 0xC0, 0x03, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// Mismo reloj antes y después: por defecto Adafruit deja el bus a 100 kHz
+// tras cada transferencia y los sensores lo heredarían
+Display::Display(): oled(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET,
+                         I2CBus::CLOCK_HZ, I2CBus::CLOCK_HZ) {
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    fields[i].text[0] = '\0';
+    fields[i].dirtyFrom = 0;
+    fields[i].dirtyTo = 0;
+  }
+  alertShown = false;
+  alertDirty = false;
+  layoutShown = false;
+  bytesSent = 0;
+  lastFlushBytes = 0;
+}
+
+void Display::init() {
+  // Wire lo inicia I2CBus, no la librería
+  i2cBus.begin();
+  if(!oled.begin(SSD1306_SWITCHCAPVCC, OLED_ADDR, true, false)) { 
+    Serial.println("ERROR: No se encontró la pantalla OLED");
+    while (true); 
+  }
+}
+
+void Display::clear() {
+  oled.clearDisplay();
+  layoutShown = false;
+}
+
+void Display::display() {
+  // Pantalla completa por el mismo camino troceado que los campos
+  uint32_t before = bytesSent;
+  sendRegion(0, SSD1306_PAGES - 1, 0, SCREEN_WIDTH - 1);
+  lastFlushBytes = bytesSent - before;
+}
+
+void Display::print(int y, int x, int textSize, const char* text) {
+  oled.setTextSize(textSize);
+  oled.setTextColor(SSD1306_WHITE);
+  oled.setCursor(x, y);
+  oled.println(text);
+}
+
+void Display::printPresentation() {
+  oled.setTextSize(3);
+  oled.setTextColor(SSD1306_WHITE);
+  oled.setCursor(0, 0);
+  oled.println("ALERTA");
+  oled.setCursor(0, 24);
+  oled.println("VITAL");
+}
+
+void Display::markDirty(Field& f, int16_t fromX, int16_t toX) {
+  if (f.dirtyTo <= f.dirtyFrom) {
+    f.dirtyFrom = fromX;
+    f.dirtyTo = toX;
+  } else {
+    if (fromX < f.dirtyFrom) f.dirtyFrom = fromX;
+    if (toX > f.dirtyTo) f.dirtyTo = toX;
+  }
+}
+
+void Display::setField(DisplayField field, const char* text) {
+  Field& f = fields[field];
+  const FieldLayout& layout = LAYOUT[field];
+
+  // Los caracteres iguales al principio no cambian de píxeles
+  uint8_t same = 0;
+  while (same < FIELD_TEXT_SIZE - 1 && f.text[same] != '\0' && f.text[same] == text[same]) {
+    same++;
+  }
+  size_t oldLen = strlen(f.text);
+  size_t newLen = strnlen(text, FIELD_TEXT_SIZE - 1);
+  if (same == oldLen && same == newLen) return;
+
+  size_t end = oldLen > newLen ? oldLen : newLen;
+  int16_t fromX = layout.valueX + same * FIELD_CHAR_W;
+  int16_t toX = layout.valueX + end * FIELD_CHAR_W;
+  if (toX > layout.valueX + layout.width) toX = layout.valueX + layout.width;
+
+  strncpy(f.text, text, FIELD_TEXT_SIZE - 1);
+  f.text[FIELD_TEXT_SIZE - 1] = '\0';
+  if (toX > fromX) {
+    markDirty(f, fromX, toX);
+  }
+}
+
+void Display::setAlert(bool active) {
+  if (active != alertShown) {
+    alertShown = active;
+    alertDirty = true;
+  }
+}
+
+void Display::drawField(DisplayField field, int16_t fromX, int16_t toX) {
+  const FieldLayout& layout = LAYOUT[field];
+  int16_t y = layout.page * SSD1306_PAGE_ROWS;
+
+  oled.fillRect(fromX, y, toX - fromX, FIELD_HEIGHT, SSD1306_BLACK);
+
+  // El texto completo se vuelve a pintar; fuera de [fromX, toX) los
+  // píxeles quedan idénticos y esas columnas no se envían
+  oled.setTextSize(2);
+  oled.setTextColor(SSD1306_WHITE);
+  oled.setTextWrap(false);
+  oled.setCursor(layout.valueX, y);
+  oled.print(fields[field].text);
+}
+
+void Display::drawAlert() {
+  int16_t y = ALERT_PAGE * SSD1306_PAGE_ROWS;
+  oled.fillRect(ALERT_X, y, ALERT_W, FIELD_HEIGHT, SSD1306_BLACK);
+  if (alertShown) {
+    oled.drawBitmap(ALERT_X, y, ALERT_ICON, ALERT_W, FIELD_HEIGHT, SSD1306_WHITE);
+  }
+}
+
+void Display::drawLayout() {
+  oled.clearDisplay();
+  oled.setTextSize(2);
+  oled.setTextColor(SSD1306_WHITE);
+  oled.setTextWrap(false);
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    oled.setCursor(0, LAYOUT[i].page * SSD1306_PAGE_ROWS);
+    oled.print(LAYOUT[i].label);
+    drawField((DisplayField)i, LAYOUT[i].valueX, LAYOUT[i].valueX + LAYOUT[i].width);
+    fields[i].dirtyFrom = fields[i].dirtyTo = 0;
+  }
+  drawAlert();
+  alertDirty = false;
+  layoutShown = true;
+}
+
+void Display::flush() {
+  if (!layoutShown) {
+    drawLayout();
+    display();
+    return;
+  }
+
+  uint32_t before = bytesSent;
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    Field& f = fields[i];
+    if (f.dirtyTo <= f.dirtyFrom) continue;
+
+    drawField((DisplayField)i, f.dirtyFrom, f.dirtyTo);
+    sendRegion(LAYOUT[i].page, LAYOUT[i].page + 1, f.dirtyFrom, f.dirtyTo - 1);
+    f.dirtyFrom = f.dirtyTo = 0;
+  }
+
+  if (alertDirty) {
+    drawAlert();
+    sendRegion(ALERT_PAGE, ALERT_PAGE + 1, ALERT_X, ALERT_X + ALERT_W - 1);
+    alertDirty = false;
+  }
+  lastFlushBytes = bytesSent - before;
+}
+
+void Display::sendRegion(uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol) {
+  // Direccionamiento horizontal (el que deja begin()): la ventana de
+  // PAGEADDR/COLUMNADDR se recorre fila de páginas a fila de páginas.
+  // Cada transacción toma el bus por separado para que los sensores
+  // puedan colarse entre trozos; la posición del SSD1306 no se pierde.
+  {
+    I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_DISPLAY);
+    Wire.beginTransmission(OLED_ADDR);
+    Wire.write((uint8_t)0x00);
+    Wire.write((uint8_t)SSD1306_PAGEADDR);
+    Wire.write(firstPage);
+    Wire.write(lastPage);
+    Wire.write((uint8_t)SSD1306_COLUMNADDR);
+    Wire.write(firstCol);
+    Wire.write(lastCol);
+    Wire.endTransmission();
+  }
+  bytesSent += 2 + 6;
+
+  const uint8_t* buffer = oled.getBuffer();
+  for (uint8_t page = firstPage; page <= lastPage; page++) {
+    const uint8_t* row = buffer + page * SCREEN_WIDTH;
+    uint16_t col = firstCol;
+    while (col <= lastCol) {
+      uint16_t n = lastCol - col + 1;
+      if (n > I2CBus::DISPLAY_CHUNK) n = I2CBus::DISPLAY_CHUNK;
+
+      {
+        I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_DISPLAY);
+        Wire.beginTransmission(OLED_ADDR);
+        Wire.write((uint8_t)0x40);
+        Wire.write(row + col, n);
+        Wire.endTransmission();
+      }
+      bytesSent += 2 + n;
+
+      col += n;
+    }
+  }
+}
@@ -1,19 +1,61 @@
-#ifndef DISPLAY_H
-#define DISPLAY_H
-
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-
-class Display {
-  private:
-    Adafruit_SSD1306 oled;
-  public:
-    Display();
-    void init();
-    void clear();
-    void print(int y, int x, int textSize, String text);
-    void display();
-    void printPresentation();
-};
-
-#endif
\ No newline at end of file
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+// Campos de la pantalla de signos vitales. Cada uno ocupa una región fija
+// alineada a páginas del SSD1306 (8 filas), así que redibujar un campo
+// solo obliga a enviar sus páginas y columnas.
+enum DisplayField : uint8_t {
+  FIELD_BPM,
+  FIELD_SPO2,
+  FIELD_BP,
+  FIELD_COUNT
+};
+
+class Display {
+  private:
+    Adafruit_SSD1306 oled;
+
+    static const uint8_t FIELD_TEXT_SIZE = 8;
+
+    struct Field {
+      char text[FIELD_TEXT_SIZE];
+      int16_t dirtyFrom;   // columnas a redibujar, [dirtyFrom, dirtyTo)
+      int16_t dirtyTo;
+    };
+    Field fields[FIELD_COUNT];
+    bool alertShown;
+    bool alertDirty;
+    bool layoutShown;
+
+    uint32_t bytesSent;
+    uint32_t lastFlushBytes;
+
+    void drawLayout();
+    void drawField(DisplayField field, int16_t fromX, int16_t toX);
+    void drawAlert();
+    void markDirty(Field& f, int16_t fromX, int16_t toX);
+    void sendRegion(uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol);
+  public:
+    Display();
+    void init();
+    void clear();
+    void print(int y, int x, int textSize, const char* text);
+    void display();
+    void printPresentation();
+
+    // Solo marca como sucio lo que cambió respecto a lo que está en pantalla
+    void setField(DisplayField field, const char* text);
+    void setAlert(bool active);
+    // Redibuja los campos sucios y envía solo sus páginas/columnas. La
+    // primera vez dibuja la plantilla completa (etiquetas incluidas).
+    void flush();
+
+    // Bytes puestos en el bus I2C (dirección + control + datos)
+    uint32_t getBytesSent() const { return bytesSent; }
+    uint32_t getLastFlushBytes() const { return lastFlushBytes; }
+};
+
+#endif
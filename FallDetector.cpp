@@ -1,146 +1,640 @@
-#include <FallDetector.h>
-#include <Wire.h>
-#include <Arduino.h>
-#include <math.h>
-
-const int MPU_addr = 0x68;
-int16_t AcX, AcY, AcZ, Tmp, GyX, GyY, GyZ;
-float ax=0, ay=0, az=0, gx=0, gy=0, gz=0;
-
-const float ACC_SENS = 16384.0; 
-const float GYRO_SENS = 131.0;  
-
-const float FREEFALL_THRESHOLD = 0.30f;
-const float IMPACT_THRESHOLD   = 3.0f;
-const unsigned long MAX_FREEFALL_WINDOW = 500;
-const unsigned long ORIENTATION_CHECK_DELAY = 200;
-
-enum FDState { IDLE, MAYBE_FREEFALL, MAYBE_IMPACT, CHECK_ORIENTATION };
-FDState state = IDLE;
-unsigned long freefallStart = 0;
-unsigned long impactTime = 0;
-
-float lastStableAx = 0, lastStableAy = 0, lastStableAz = 1;
-float postImpactAx = 0, postImpactAy = 0, postImpactAz = 0;
-
-void FallDetector::mpu_read() {
-  Wire.beginTransmission(MPU_addr);
-  Wire.write(0x3B);
-  Wire.endTransmission(false);
-  Wire.requestFrom(MPU_addr, 14, true);
-  AcX = Wire.read()<<8 | Wire.read();
-  AcY = Wire.read()<<8 | Wire.read();
-  AcZ = Wire.read()<<8 | Wire.read();
-  Tmp = Wire.read()<<8 | Wire.read();
-  GyX = Wire.read()<<8 | Wire.read();
-  GyY = Wire.read()<<8 | Wire.read();
-  GyZ = Wire.read()<<8 | Wire.read();
-}
-
-FallDetector::FallDetector() {
-  this->fallDetected = false;
-}
-
-void FallDetector::begin() {
-  Wire.begin();
-  Wire.beginTransmission(MPU_addr);
-  Wire.write(0x6B);
-  Wire.write(0);
-  Wire.endTransmission(true);
-  long axSum=0, aySum=0, azSum=0;
-  for(int i=0; i<100; i++) {
-    mpu_read();
-    axSum += AcX;
-    aySum += AcY;
-    azSum += AcZ;
-    delay(10);
-  }
-}
-
-static float angleBetween(const float ax1, const float ay1, const float az1,
-                          const float ax2, const float ay2, const float az2) {
-  float dot = ax1*ax2 + ay1*ay2 + az1*az2;
-  float n1 = sqrt(ax1*ax1 + ay1*ay1 + az1*az1);
-  float n2 = sqrt(ax2*ax2 + ay2*ay2 + az2*az2);
-  if (n1==0 || n2==0) return 0.0f;
-  float cosv = dot / (n1*n2);
-  if (cosv > 1.0f) cosv = 1.0f;
-  if (cosv < -1.0f) cosv = -1.0f;
-  return acos(cosv) * 180.0f / PI;
-}
-
-void FallDetector::on() {
-  mpu_read();
-
-  ax = (float)AcX / ACC_SENS;
-  ay = (float)AcY / ACC_SENS;
-  az = (float)AcZ / ACC_SENS;
-  gx = (float)GyX / GYRO_SENS;
-  gy = (float)GyY / GYRO_SENS;
-  gz = (float)GyZ / GYRO_SENS;
-
-  float mag = sqrt(ax*ax + ay*ay + az*az);
-  unsigned long now = millis();
-
-  if (state == IDLE && mag > 0.85f && mag < 1.15f) {
-    lastStableAx = ax;
-    lastStableAy = ay;
-    lastStableAz = az;
-  }
-
-  switch (state) {
-    case IDLE:
-      if (mag < FREEFALL_THRESHOLD) {
-        state = MAYBE_FREEFALL;
-        freefallStart = now;
-        Serial.println("Freefall detectada");
-      }
-      break;
-
-    case MAYBE_FREEFALL:
-      if (mag > IMPACT_THRESHOLD) {
-        state = MAYBE_IMPACT;
-        impactTime = now;
-        Serial.print("Impacto detectado, mag=");
-        Serial.println(mag);
-      } else if ((now - freefallStart) > MAX_FREEFALL_WINDOW) {
-        Serial.println("Timeout freefall sin impacto");
-        state = IDLE;
-      }
-      break;
-
-    case MAYBE_IMPACT:
-      if ((now - impactTime) >= ORIENTATION_CHECK_DELAY) {
-        postImpactAx = ax;
-        postImpactAy = ay;
-        postImpactAz = az;
-
-        float angle = angleBetween(lastStableAx, lastStableAy, lastStableAz,
-                                   postImpactAx, postImpactAy, postImpactAz);
-
-        if (angle > 45.0f) {
-          fallDetected = true;
-        } else {
-          Serial.println("No es caída (ángulo pequeño)");
-        }
-        
-        state = IDLE;
-      }
-      else if (mag > IMPACT_THRESHOLD * 1.5f) {
-        Serial.println("Movimiento brusco continuo, no es caída");
-        state = IDLE;
-      }
-      break;
-
-    default:
-      state = IDLE;
-      break;
-  }
-}
-
-
-bool FallDetector::wasFallDetected() {
-    bool res = fallDetected;
-    fallDetected = false;
-    return res;
-}
\ No newline at end of file
+#include <FallDetector.h>
+#include <Clock.h>
+#include <SensorTrace.h>
+#include <I2CBus.h>
+#include <Log.h>
+#include <Wire.h>
+#include <Arduino.h>
+#include <math.h>
+
+// Registros del MPU6050
+#define REG_SMPLRT_DIV   0x19
+#define REG_CONFIG       0x1A
+#define REG_ACCEL_CONFIG 0x1C
+#define REG_FF_THR       0x1D
+#define REG_FF_DUR       0x1E
+#define REG_FIFO_EN      0x23
+#define REG_INT_PIN_CFG  0x37
+#define REG_INT_ENABLE   0x38
+#define REG_INT_STATUS   0x3A
+#define REG_ACCEL_XOUT_H 0x3B
+#define REG_USER_CTRL    0x6A
+#define REG_PWR_MGMT_1   0x6B
+#define REG_PWR_MGMT_2   0x6C
+#define REG_FIFO_COUNT_H 0x72
+#define REG_FIFO_R_W     0x74
+
+#define FIFO_EN_ACCEL_GYRO  0x78   // XG, YG, ZG y acelerómetro: 12 bytes por muestra
+#define USER_CTRL_FIFO_EN   0x40
+#define USER_CTRL_FIFO_RST  0x04
+#define INT_RD_CLEAR        0x10   // cualquier lectura limpia el estado; pulso de 50 us
+#define INT_DATA_RDY        0x01
+#define INT_FF              0x80
+#define DLPF_44HZ           0x03   // con DLPF el reloj de muestreo es 1 kHz
+
+// Bajo consumo: ciclo de solo acelerómetro a 40 Hz (≈140 uA frente a 3,9 mA)
+#define PWR1_CYCLE_TEMP_DIS 0x28
+#define PWR2_LP_40HZ_NO_GYRO 0xC7
+// DHPF en reset: los detectores ven la aceleración tal cual. Con un corte
+// o en hold, en reposo verían ~0 g en los tres ejes y la caída libre
+// saltaría sin caerse nada
+#define ACCEL_HPF_RESET     0x00
+// Umbrales en LSB de 2 mg y duraciones en ms
+#define FF_THR_LSB          150    // 0,3 g, el mismo umbral que la máquina de estados
+#define FF_DUR_MS           20
+
+// Muestras por requestFrom: caben en el buffer de Wire
+#define SAMPLES_PER_BURST (I2C_BUFFER_LENGTH / FallDetector::FIFO_SAMPLE_SIZE)
+
+constexpr float ACC_SENS = 16384.0f;
+
+constexpr float FREEFALL_THRESHOLD = 0.30f;
+constexpr float IMPACT_THRESHOLD   = 3.0f;
+constexpr float STABLE_MIN = 0.85f;
+constexpr float STABLE_MAX = 1.15f;
+const unsigned long MAX_FREEFALL_WINDOW = 500;
+const unsigned long ORIENTATION_CHECK_DELAY = 200;
+
+// Los umbrales en g pasan a cuentas² para comparar con |a|² sin raíces.
+// Como |a|² es entero, |a| < t ⇔ |a|² < ⌈(t·S)²⌉ y |a| > t ⇔ |a|² > ⌊(t·S)²⌋.
+static constexpr double countsSq(float g) {
+  return ((double)g * ACC_SENS) * ((double)g * ACC_SENS);
+}
+static constexpr uint64_t floorSq(float g) {
+  return (uint64_t)countsSq(g);
+}
+static constexpr uint64_t ceilSq(float g) {
+  return (double)(uint64_t)countsSq(g) < countsSq(g) ? (uint64_t)countsSq(g) + 1 : (uint64_t)countsSq(g);
+}
+
+static constexpr uint64_t FREEFALL_BELOW_SQ = ceilSq(FREEFALL_THRESHOLD);
+static constexpr uint64_t IMPACT_ABOVE_SQ   = floorSq(IMPACT_THRESHOLD);
+static constexpr uint64_t BRUSQUE_ABOVE_SQ  = floorSq(IMPACT_THRESHOLD * 1.5f);
+static constexpr uint64_t STABLE_ABOVE_SQ   = floorSq(STABLE_MIN);
+static constexpr uint64_t STABLE_BELOW_SQ   = ceilSq(STABLE_MAX);
+// En bajo consumo, entre dos lecturas de postura: ≈0,5 g de cambio (unos
+// 30°), lo que antes vigilaba el detector de movimiento del chip
+static constexpr uint64_t MOTION_WAKE_SQ    = floorSq(0.5f);
+
+// Reposo: desviación típica por eje por debajo de 0,01 g en la ventana.
+// Plano: X e Y por debajo de 0,05 g (≈3°), así que Z lleva toda la gravedad.
+const int32_t REST_SIGMA = 164;
+const int32_t FLAT_LIMIT = 819;
+const int32_t BIAS_AGREEMENT = 164;   // entre ventanas consecutivas
+const int32_t MAX_BIAS = 2048;        // 0,125 g; más es un sensor dañado
+// En otra postura cuenta como orientación nueva si gira más de 30°
+constexpr float ORIENTATION_MIN_ANGLE_COS = 0.866f;
+// El ajuste se rechaza si las posturas casi caben en un plano o si la
+// gravedad que sale se aleja más de un 10 % de 1 g
+constexpr double FIT_MIN_PIVOT = 1e-3;
+constexpr double FIT_GRAVITY_TOLERANCE = 0.10;
+
+namespace {
+  struct ImuCalibrationRecord {
+    static const uint32_t MAGIC = 0x4143554DUL;  // "MUCA"
+    static const uint16_t VERSION = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    int16_t biasX;
+    int16_t biasY;
+    int16_t biasZ;
+    int16_t reserved2;
+    uint32_t crc;
+  };
+
+  const char* const IMU_CALIBRATION_KEY = "imu_cal";
+}
+
+FallDetector::FallDetector(int8_t intPin, uint8_t address)
+  : address(address),
+    intPin(intPin)
+{
+  this->fallDetected = false;
+}
+
+void FallDetector::writeRegister(uint8_t reg, uint8_t value) {
+  I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission(true);
+  stats.busTransactions++;
+}
+
+bool FallDetector::readRegister(uint8_t reg, uint8_t& value) {
+  I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  Wire.endTransmission(false);
+  stats.busTransactions++;
+  if (Wire.requestFrom(address, (uint8_t)1, (uint8_t)true) != 1) return false;
+  stats.bytesRead++;
+  value = Wire.read();
+  return true;
+}
+
+void FallDetector::mpu_read(int16_t* raw) {
+  {
+    I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+    Wire.beginTransmission(address);
+    Wire.write(REG_ACCEL_XOUT_H);
+    Wire.endTransmission(false);
+    Wire.requestFrom(address, (uint8_t)14, (uint8_t)true);
+    stats.busTransactions++;
+    stats.bytesRead += 14;
+  }
+  raw[0] = Wire.read()<<8 | Wire.read();
+  raw[1] = Wire.read()<<8 | Wire.read();
+  raw[2] = Wire.read()<<8 | Wire.read();
+  Wire.read(); Wire.read();   // temperatura
+  raw[3] = Wire.read()<<8 | Wire.read();
+  raw[4] = Wire.read()<<8 | Wire.read();
+  raw[5] = Wire.read()<<8 | Wire.read();
+}
+
+void FallDetector::resetFifo() {
+  writeRegister(REG_USER_CTRL, USER_CTRL_FIFO_RST);
+  writeRegister(REG_USER_CTRL, USER_CTRL_FIFO_EN);
+}
+
+bool FallDetector::readFifoCount(uint16_t& count) {
+  I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+  Wire.beginTransmission(address);
+  Wire.write(REG_FIFO_COUNT_H);
+  Wire.endTransmission(false);
+  stats.busTransactions++;
+  if (Wire.requestFrom(address, (uint8_t)2, (uint8_t)true) != 2) return false;
+  stats.bytesRead += 2;
+  count = (uint16_t)(Wire.read() << 8 | Wire.read());
+  return true;
+}
+
+void IRAM_ATTR FallDetector::onInterrupt(void* arg) {
+  FallDetector* self = static_cast<FallDetector*>(arg);
+  self->lastReadyUs = Clock::micros();
+  self->readyCount = self->readyCount + 1;
+  self->interruptPending = true;
+}
+
+void FallDetector::begin() {
+  i2cBus.begin();
+  writeRegister(REG_PWR_MGMT_1, 0);
+  writeRegister(REG_CONFIG, DLPF_44HZ);
+  writeRegister(REG_SMPLRT_DIV, (uint8_t)(1000 / SAMPLE_RATE_HZ - 1));
+  writeRegister(REG_FF_THR, FF_THR_LSB);
+  writeRegister(REG_FF_DUR, FF_DUR_MS);
+
+  if (intPin >= 0) {
+    writeRegister(REG_INT_PIN_CFG, INT_RD_CLEAR);
+    pinMode(intPin, INPUT);
+    attachInterruptArg(digitalPinToInterrupt(intPin), onInterrupt, this, RISING);
+  }
+  startFullRate();
+}
+
+void FallDetector::startFullRate() {
+  writeRegister(REG_PWR_MGMT_1, 0);
+  writeRegister(REG_PWR_MGMT_2, 0);
+  writeRegister(REG_ACCEL_CONFIG, 0);
+  writeRegister(REG_FIFO_EN, FIFO_EN_ACCEL_GYRO);
+  resetFifo();
+  if (intPin >= 0) writeRegister(REG_INT_ENABLE, INT_DATA_RDY);
+  lowPower = false;
+  lastActivityMs = Clock::millis();
+}
+
+void FallDetector::enterLowPower(unsigned long now) {
+  writeRegister(REG_INT_ENABLE, 0);
+  writeRegister(REG_USER_CTRL, 0);
+  writeRegister(REG_FIFO_EN, 0);
+  writeRegister(REG_ACCEL_CONFIG, ACCEL_HPF_RESET);
+  writeRegister(REG_PWR_MGMT_2, PWR2_LP_40HZ_NO_GYRO);
+  writeRegister(REG_PWR_MGMT_1, PWR1_CYCLE_TEMP_DIS);
+
+  // Un dato listo anterior no debe despertarlo; uno de caída libre sí. El
+  // detector de movimiento, sobre la aceleración sin filtrar, saltaría con
+  // la propia gravedad: el movimiento lo detecta refreshOrientation()
+  interruptPending = false;
+  latchedStatus = 0;
+  writeRegister(REG_INT_ENABLE, INT_FF);
+
+  lowPower = true;
+  lowPowerSince = now;
+  lastOrientationMs = now;
+  stats.lowPowerEntries++;
+}
+
+void FallDetector::wake(unsigned long wakeMs) {
+  // Lo que una lectura anterior ya borró del chip sigue en latchedStatus
+  uint8_t status = 0;
+  readRegister(REG_INT_STATUS, status);
+  status |= latchedStatus;
+  latchedStatus = 0;
+
+  stats.lowPowerMs += wakeMs - lowPowerSince;
+  startFullRate();
+
+  // La caída libre ya dura FF_DUR_MS: se salta IDLE para que el impacto,
+  // que puede llegar antes que la primera muestra del FIFO, cuente
+  if ((status & INT_FF) && state == IDLE) {
+    state = MAYBE_FREEFALL;
+    freefallStart = wakeMs - FF_DUR_MS;
+    stats.freefallWakes++;
+    LOG_INFO("Freefall detectada (despertar)");
+  }
+}
+
+bool FallDetector::refreshOrientation(unsigned long now) {
+  // INT_STATUS (0x3A) va justo delante de ACCEL_XOUT_H: con INT_RD_CLEAR
+  // cualquier lectura lo borra, así que se lee en la misma ráfaga y se
+  // guarda para que wake() no pierda una caída libre
+  uint8_t data[7];
+  {
+    I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+    Wire.beginTransmission(address);
+    Wire.write(REG_INT_STATUS);
+    Wire.endTransmission(false);
+    Wire.requestFrom(address, (uint8_t)sizeof(data), (uint8_t)true);
+    stats.busTransactions++;
+    stats.bytesRead += sizeof(data);
+    for (uint8_t i = 0; i < sizeof(data); i++) data[i] = Wire.read();
+  }
+  lastOrientationMs = now;
+  latchedStatus |= data[0];
+
+  int32_t ax = (int16_t)(data[1] << 8 | data[2]) - biasX;
+  int32_t ay = (int16_t)(data[3] << 8 | data[4]) - biasY;
+  int32_t az = (int16_t)(data[5] << 8 | data[6]) - biasZ;
+  uint32_t mag2 = (uint32_t)(ax*ax) + (uint32_t)(ay*ay) + (uint32_t)(az*az);
+  if (mag2 <= STABLE_ABOVE_SQ || mag2 >= STABLE_BELOW_SQ) {
+    return true;   // acelerando: no está quieto
+  }
+
+  // Cambio de postura desde la última lectura
+  int32_t dx = ax - lastStableAx;
+  int32_t dy = ay - lastStableAy;
+  int32_t dz = az - lastStableAz;
+  bool moved = (uint32_t)(dx*dx) + (uint32_t)(dy*dy) + (uint32_t)(dz*dz) > MOTION_WAKE_SQ;
+
+  lastStableAx = (int16_t)ax;
+  lastStableAy = (int16_t)ay;
+  lastStableAz = (int16_t)az;
+  return moved;
+}
+
+void FallDetector::setLowPower(bool enabled) {
+  lowPowerEnabled = enabled && intPin >= 0;
+  if (!lowPowerEnabled && lowPower) {
+    stats.lowPowerMs += Clock::millis() - lowPowerSince;
+    startFullRate();
+  }
+}
+
+// ángulo(a, b) > 45° ⇔ cos < 1/√2 ⇔ a·b < 0, o bien 2(a·b)² < |a|²|b|².
+// a es siempre una orientación estable (|a| ≤ 1,15 g), así que los
+// productos caben en 64 bits.
+// La comparación es exacta. El acos en float al que sustituyó redondeaba y,
+// a menos de 2·10⁻⁵° de 45°, podía decidir al revés; esa diferencia se
+// acepta a propósito: aquí decide el ángulo real (test_fall_kernel).
+static bool angleAbove45(int32_t ax1, int32_t ay1, int32_t az1,
+                         int32_t ax2, int32_t ay2, int32_t az2) {
+  int64_t dot = (int64_t)ax1*ax2 + (int64_t)ay1*ay2 + (int64_t)az1*az2;
+  if (dot < 0) return true;
+  uint64_t n1 = (uint64_t)(ax1*ax1) + (uint64_t)(ay1*ay1) + (uint64_t)(az1*az1);
+  uint64_t n2 = (uint64_t)(ax2*ax2) + (uint64_t)(ay2*ay2) + (uint64_t)(az2*az2);
+  return 2 * (uint64_t)dot * (uint64_t)dot < n1 * n2;
+}
+
+void FallDetector::setTraceWriter(SensorTraceWriter* writer) {
+  this->traceWriter = writer;
+}
+
+void FallDetector::on() {
+  if (lowPower && !interruptPending) {
+    unsigned long now = Clock::millis();
+    if (now - lastOrientationMs < LOW_POWER_ORIENTATION_MS) return;
+    stats.wakeups++;
+    bool moved = refreshOrientation(now);
+    // Una caída libre cuyo pulso aún no se ha atendido también despierta
+    if (moved || (latchedStatus & INT_FF)) wake(now);
+    return;
+  }
+
+  if (intPin >= 0) {
+    if (!interruptPending) return;
+    interruptPending = false;
+  }
+  stats.wakeups++;
+
+  if (lowPower) {
+    wake(Clock::millis() - (Clock::micros() - lastReadyUs) / 1000);
+    return;
+  }
+
+  // Si entra una interrupción mientras se lee el contador, la marca de
+  // tiempo podría no corresponder a la última muestra contada: se repite
+  uint16_t count = 0;
+  uint32_t newestUs = Clock::micros();
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    uint32_t before = readyCount;
+    if (intPin >= 0) newestUs = lastReadyUs;
+    if (!readFifoCount(count)) return;
+    if (intPin < 0 || readyCount == before) break;
+  }
+
+  // Lleno (1024 no es múltiplo de 12) o desalineado: las muestras ya no se
+  // pueden separar, se empieza de cero
+  if (count > FIFO_SIZE - FIFO_SAMPLE_SIZE || count % FIFO_SAMPLE_SIZE != 0) {
+    fifoOverflows++;
+    resetFifo();
+    return;
+  }
+
+  uint16_t samples = count / FIFO_SAMPLE_SIZE;
+  uint32_t nowUs = Clock::micros();
+  unsigned long nowMs = Clock::millis();
+
+  while (samples > 0) {
+    uint8_t burst = samples < SAMPLES_PER_BURST ? (uint8_t)samples : (uint8_t)SAMPLES_PER_BURST;
+    {
+      I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+      Wire.beginTransmission(address);
+      Wire.write(REG_FIFO_R_W);
+      Wire.endTransmission(false);
+      Wire.requestFrom(address, (uint8_t)(burst * FIFO_SAMPLE_SIZE), (uint8_t)true);
+      stats.busTransactions++;
+      stats.bytesRead += burst * FIFO_SAMPLE_SIZE;
+    }
+
+    for (uint8_t i = 0; i < burst; i++) {
+      int16_t raw[6];
+      for (uint8_t f = 0; f < 6; f++) {
+        raw[f] = Wire.read()<<8 | Wire.read();
+      }
+      samples--;
+
+      // La más reciente es la del último dato listo; las anteriores, un
+      // periodo de muestreo antes cada una
+      uint32_t sampleUs = newestUs - samples * SAMPLE_PERIOD_US;
+      unsigned long sampleMs = nowMs - (nowUs - sampleUs) / 1000;
+
+      if (traceWriter) {
+        int32_t values[6] = { raw[0], raw[1], raw[2], raw[3], raw[4], raw[5] };
+        traceWriter->record(TRACE_IMU, sampleUs, values);
+      }
+
+      if (!biasValid) updateBias(raw[0], raw[1], raw[2]);
+      processSample(raw[0], raw[1], raw[2], raw[3], raw[4], raw[5], sampleMs);
+    }
+  }
+
+  if (lowPowerEnabled && state == IDLE && nowMs - lastActivityMs >= LOW_POWER_IDLE_MS) {
+    enterLowPower(nowMs);
+  }
+}
+
+void FallDetector::processSample(int16_t rawAx, int16_t rawAy, int16_t rawAz,
+                                 int16_t rawGx, int16_t rawGy, int16_t rawGz,
+                                 unsigned long now) {
+  // El giróscopo no interviene en la decisión; llega en la misma firma que
+  // el FIFO y la reproducción de trazas
+  (void)rawGx; (void)rawGy; (void)rawGz;
+
+  // Todo en cuentas. Con el sesgo acotado a MAX_BIAS, |a|² sigue cabiendo
+  // en 32 bits sin signo
+  int32_t ax = (int32_t)rawAx - biasX;
+  int32_t ay = (int32_t)rawAy - biasY;
+  int32_t az = (int32_t)rawAz - biasZ;
+  uint32_t mag2 = (uint32_t)(ax*ax) + (uint32_t)(ay*ay) + (uint32_t)(az*az);
+
+  if (state == IDLE && mag2 > STABLE_ABOVE_SQ && mag2 < STABLE_BELOW_SQ) {
+    lastStableAx = (int16_t)ax;
+    lastStableAy = (int16_t)ay;
+    lastStableAz = (int16_t)az;
+  } else {
+    lastActivityMs = now;
+  }
+
+  switch (state) {
+    case IDLE:
+      if (mag2 < FREEFALL_BELOW_SQ) {
+        state = MAYBE_FREEFALL;
+        freefallStart = now;
+        LOG_INFO("Freefall detectada");
+      }
+      break;
+
+    case MAYBE_FREEFALL:
+      if (mag2 > IMPACT_ABOVE_SQ) {
+        state = MAYBE_IMPACT;
+        impactTime = now;
+        LOG_INFO("Impacto detectado, mag=%.2f", sqrtf((float)mag2) / ACC_SENS);
+      } else if ((now - freefallStart) > MAX_FREEFALL_WINDOW) {
+        LOG_DEBUG("Timeout freefall sin impacto");
+        state = IDLE;
+      }
+      break;
+
+    case MAYBE_IMPACT:
+      if ((now - impactTime) >= ORIENTATION_CHECK_DELAY) {
+        if (angleAbove45(lastStableAx, lastStableAy, lastStableAz, ax, ay, az)) {
+          fallDetected = true;
+        } else {
+          LOG_DEBUG("No es caída (ángulo pequeño)");
+        }
+
+        state = IDLE;
+      }
+      else if (mag2 > BRUSQUE_ABOVE_SQ) {
+        LOG_DEBUG("Movimiento brusco continuo, no es caída");
+        state = IDLE;
+      }
+      break;
+
+    default:
+      state = IDLE;
+      break;
+  }
+}
+
+
+bool FallDetector::wasFallDetected() {
+    bool res = fallDetected;
+    fallDetected = false;
+    return res;
+}
+
+void FallDetector::updateBias(int16_t rawAx, int16_t rawAy, int16_t rawAz) {
+  const int32_t v[3] = { rawAx, rawAy, rawAz };
+  for (uint8_t i = 0; i < 3; i++) {
+    windowSum[i] += v[i];
+    windowSumSq[i] += (int64_t)v[i] * v[i];
+  }
+  if (++windowSamples < BIAS_WINDOW) return;
+
+  // N²·var = N·Σx² − (Σx)², sin divisiones
+  const int64_t n = BIAS_WINDOW;
+  bool rest = true;
+  int32_t mean[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    int64_t spread = n * windowSumSq[i] - (int64_t)windowSum[i] * windowSum[i];
+    if (spread > n * n * REST_SIGMA * REST_SIGMA) rest = false;
+    mean[i] = windowSum[i] / (int32_t)n;
+  }
+
+  windowSamples = 0;
+  for (uint8_t i = 0; i < 3; i++) {
+    windowSum[i] = 0;
+    windowSumSq[i] = 0;
+  }
+
+  if (!rest) {
+    restWindows = 0;
+    return;
+  }
+
+  // Una ventana que no coincide con la anterior reinicia la cuenta
+  bool agrees = restWindows > 0;
+  for (uint8_t i = 0; i < 3 && agrees; i++) {
+    if (abs(mean[i] - candidate[i]) > BIAS_AGREEMENT) agrees = false;
+  }
+  if (!agrees) {
+    restWindows = 0;
+    for (uint8_t i = 0; i < 3; i++) candidateSum[i] = 0;
+  }
+
+  for (uint8_t i = 0; i < 3; i++) {
+    candidate[i] = mean[i];
+    candidateSum[i] += mean[i];
+  }
+  if (++restWindows < BIAS_REST_WINDOWS) return;
+
+  int32_t still[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    still[i] = candidateSum[i] / BIAS_REST_WINDOWS;
+    candidateSum[i] = 0;
+  }
+  restWindows = 0;
+
+  // Plano con Z arriba: toda la gravedad está en Z y basta una postura
+  int32_t bias[3] = { still[0], still[1], still[2] - (int32_t)ACC_SENS };
+  bool flat = abs(still[0]) < FLAT_LIMIT && abs(still[1]) < FLAT_LIMIT && still[2] > 0;
+  bool plausible = abs(bias[0]) <= MAX_BIAS && abs(bias[1]) <= MAX_BIAS && abs(bias[2]) <= MAX_BIAS;
+  if (!flat || !plausible) {
+    // En cualquier otra postura la gravedad y el sesgo no se separan con
+    // una sola: se guardan posturas distintas hasta poder ajustar la esfera
+    if (!addOrientation(still) || !fitBias(bias)) return;
+  }
+
+  biasX = (int16_t)bias[0];
+  biasY = (int16_t)bias[1];
+  biasZ = (int16_t)bias[2];
+  biasValid = true;
+  biasUnsaved = true;
+}
+
+bool FallDetector::addOrientation(const int32_t* still) {
+  float norm = sqrtf((float)still[0] * still[0] + (float)still[1] * still[1] + (float)still[2] * still[2]);
+  if (norm < STABLE_MIN * ACC_SENS || norm > STABLE_MAX * ACC_SENS) return false;
+
+  for (uint8_t k = 0; k < orientationCount; k++) {
+    const int32_t* o = orientations[k];
+    float other = sqrtf((float)o[0] * o[0] + (float)o[1] * o[1] + (float)o[2] * o[2]);
+    float dot = (float)o[0] * still[0] + (float)o[1] * still[1] + (float)o[2] * still[2];
+    if (dot > ORIENTATION_MIN_ANGLE_COS * norm * other) return false;
+  }
+
+  // Llenas, la nueva sustituye a la más antigua
+  uint8_t slot = orientationCount < MAX_ORIENTATIONS ? orientationCount++ : nextOrientation;
+  nextOrientation = (uint8_t)((slot + 1) % MAX_ORIENTATIONS);
+  for (uint8_t i = 0; i < 3; i++) orientations[slot][i] = still[i];
+  return true;
+}
+
+bool FallDetector::fitBias(int32_t* bias) const {
+  if (orientationCount < MIN_ORIENTATIONS) return false;
+
+  // En reposo |m − b|² = g², o sea 2·m·b + (g² − |b|²) = |m|²: lineal en
+  // (bx, by, bz, c). Mínimos cuadrados por ecuaciones normales; se hace
+  // una vez y en double porque |m|² ronda 2,7·10⁸
+  double ata[4][5] = {};
+  for (uint8_t k = 0; k < orientationCount; k++) {
+    const int32_t* m = orientations[k];
+    double row[4] = { 2.0 * m[0], 2.0 * m[1], 2.0 * m[2], 1.0 };
+    double rhs = (double)m[0] * m[0] + (double)m[1] * m[1] + (double)m[2] * m[2];
+    for (uint8_t r = 0; r < 4; r++) {
+      for (uint8_t c = 0; c < 4; c++) ata[r][c] += row[r] * row[c];
+      ata[r][4] += row[r] * rhs;
+    }
+  }
+
+  // Eliminación sin intercambios (la matriz es simétrica definida
+  // positiva). Cada pivote, relativo a su diagonal de partida, mide cuánto
+  // aporta esa columna que no expliquen las anteriores: con posturas casi
+  // en un mismo plano sale diminuto y el ajuste no determina el sesgo
+  double diagonal[4];
+  for (uint8_t i = 0; i < 4; i++) diagonal[i] = ata[i][i];
+  for (uint8_t col = 0; col < 4; col++) {
+    if (!(ata[col][col] > FIT_MIN_PIVOT * diagonal[col])) return false;
+    for (uint8_t r = col + 1; r < 4; r++) {
+      double f = ata[r][col] / ata[col][col];
+      for (uint8_t c = col; c < 5; c++) ata[r][c] -= f * ata[col][c];
+    }
+  }
+  double x[4];
+  for (int8_t r = 3; r >= 0; r--) {
+    double sum = ata[r][4];
+    for (uint8_t c = r + 1; c < 4; c++) sum -= ata[r][c] * x[c];
+    x[r] = sum / ata[r][r];
+  }
+
+  double gravity2 = x[3] + x[0] * x[0] + x[1] * x[1] + x[2] * x[2];
+  double expected2 = (double)ACC_SENS * ACC_SENS;
+  if (gravity2 < expected2 * (1 - FIT_GRAVITY_TOLERANCE) * (1 - FIT_GRAVITY_TOLERANCE) ||
+      gravity2 > expected2 * (1 + FIT_GRAVITY_TOLERANCE) * (1 + FIT_GRAVITY_TOLERANCE)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    if (fabs(x[i]) > MAX_BIAS) return false;
+    bias[i] = (int32_t)lround(x[i]);
+  }
+  return true;
+}
+
+bool FallDetector::takeCalibrationUpdate() {
+  bool res = biasUnsaved;
+  biasUnsaved = false;
+  return res;
+}
+
+bool FallDetector::loadCalibration(CalibrationStore& store) {
+  ImuCalibrationRecord record;
+  if (!loadCalibrationRecord(store, IMU_CALIBRATION_KEY, record)) {
+    return false;
+  }
+
+  if (abs(record.biasX) > MAX_BIAS || abs(record.biasY) > MAX_BIAS || abs(record.biasZ) > MAX_BIAS) {
+    return false;
+  }
+
+  biasX = record.biasX;
+  biasY = record.biasY;
+  biasZ = record.biasZ;
+  biasValid = true;
+  biasUnsaved = false;
+  return true;
+}
+
+bool FallDetector::saveCalibration(CalibrationStore& store) const {
+  if (!biasValid) {
+    return false;
+  }
+
+  ImuCalibrationRecord record = {};
+  record.biasX = biasX;
+  record.biasY = biasY;
+  record.biasZ = biasZ;
+  return saveCalibrationRecord(store, IMU_CALIBRATION_KEY, record);
+}
@@ -1,15 +1,139 @@
-#ifndef FALL_DETECTOR_H
-#define FALL_DETECTOR_H
-
-class FallDetector {
-  private:
-    bool fallDetected = false; 
-  public:
-    FallDetector();
-    void begin();
-    void on();
-    void mpu_read();
-    bool wasFallDetected();
-};
-
-#endif
\ No newline at end of file
+#ifndef FALL_DETECTOR_H
+#define FALL_DETECTOR_H
+
+#include <Arduino.h>
+#include <CalibrationStore.h>
+
+class SensorTraceWriter;
+
+// El MPU6050 muestrea solo a SAMPLE_RATE_HZ y deja cada muestra en su FIFO
+// (acelerómetro + giróscopo, 12 bytes). Con el pin INT conectado, on() no
+// toca el bus hasta que llega la interrupción de dato listo; entonces lee
+// de una vez todo lo acumulado y pasa cada muestra por la máquina de
+// estados con su propia marca de tiempo.
+//
+// Con bajo consumo activo, tras LOW_POWER_IDLE_MS sin movimiento el chip
+// pasa a ciclo de solo acelerómetro (40 Hz, giróscopo en espera, sin FIFO)
+// y únicamente su detector de caída libre levanta INT. Al despertar vuelve
+// a muestreo completo; si fue por caída libre la máquina de estados arranca
+// ya en MAYBE_FREEFALL para no perder el impacto. Mientras duerme, on()
+// relee cada segundo el acelerómetro: la orientación previa a la caída no
+// se queda obsoleta, y si cambió de postura o está acelerando despierta.
+class FallDetector {
+  private:
+    enum State { IDLE, MAYBE_FREEFALL, MAYBE_IMPACT, CHECK_ORIENTATION };
+
+    uint8_t address;
+    int8_t intPin;
+    bool fallDetected = false;
+    SensorTraceWriter* traceWriter = nullptr;
+
+    State state = IDLE;
+    unsigned long freefallStart = 0;
+    unsigned long impactTime = 0;
+    int16_t lastStableAx = 0, lastStableAy = 0, lastStableAz = 16384;   // cuentas, 1 g en Z
+
+    // Escritos por la ISR
+    volatile bool interruptPending = false;
+    volatile uint32_t readyCount = 0;
+    volatile uint32_t lastReadyUs = 0;
+
+    uint32_t fifoOverflows = 0;
+
+    bool lowPowerEnabled = false;
+    bool lowPower = false;
+    unsigned long lowPowerSince = 0;
+    unsigned long lastActivityMs = 0;
+    unsigned long lastOrientationMs = 0;
+    uint8_t latchedStatus = 0;   // INT_STATUS leído antes de wake()
+
+    // Sesgo del acelerómetro (cuentas), restado antes de detectar. Se estima
+    // en segundo plano con el equipo quieto: plano (Z hacia arriba) basta
+    // una postura; en cualquier otra hacen falta MIN_ORIENTATIONS posturas
+    // distintas para ajustar la esfera |m − sesgo| = 1 g.
+    int16_t biasX = 0, biasY = 0, biasZ = 0;
+    bool biasValid = false;
+    bool biasUnsaved = false;
+    uint16_t windowSamples = 0;
+    int32_t windowSum[3] = { 0, 0, 0 };
+    int64_t windowSumSq[3] = { 0, 0, 0 };
+    uint8_t restWindows = 0;
+    int32_t candidate[3] = { 0, 0, 0 };
+    int32_t candidateSum[3] = { 0, 0, 0 };
+    static const uint8_t MAX_ORIENTATIONS = 6;
+    int32_t orientations[MAX_ORIENTATIONS][3] = {};   // medias en reposo
+    uint8_t orientationCount = 0;
+    uint8_t nextOrientation = 0;
+
+    void updateBias(int16_t rawAx, int16_t rawAy, int16_t rawAz);
+    bool addOrientation(const int32_t* still);
+    bool fitBias(int32_t* bias) const;
+
+    void writeRegister(uint8_t reg, uint8_t value);
+    bool readRegister(uint8_t reg, uint8_t& value);
+    void resetFifo();
+    bool readFifoCount(uint16_t& count);
+    void startFullRate();
+    void enterLowPower(unsigned long now);
+    void wake(unsigned long wakeMs);
+    // true si se ha movido desde la lectura anterior
+    bool refreshOrientation(unsigned long now);
+    static void onInterrupt(void* arg);
+  public:
+    struct Stats {
+      uint32_t busTransactions;
+      uint32_t bytesRead;
+      uint32_t wakeups;          // pasadas de on() que tocaron el bus
+      uint32_t lowPowerEntries;
+      uint32_t freefallWakes;
+      uint32_t lowPowerMs;       // acumulado hasta el último despertar
+    };
+
+    static const uint16_t SAMPLE_RATE_HZ = 100;
+    static const uint32_t SAMPLE_PERIOD_US = 1000000UL / SAMPLE_RATE_HZ;
+    static const uint8_t FIFO_SAMPLE_SIZE = 12;
+    static const uint16_t FIFO_SIZE = 1024;
+    static const uint16_t BIAS_WINDOW = 128;       // muestras por ventana de reposo
+    static const uint8_t BIAS_REST_WINDOWS = 4;    // ventanas seguidas que deben coincidir
+    static const uint8_t MIN_ORIENTATIONS = 4;     // fuera de plano, posturas para ajustar
+    // Cubre las cuatro ventanas del sesgo más el desfase de una
+    static const unsigned long LOW_POWER_IDLE_MS = 7000;
+    // En bajo consumo la orientación de referencia se relee con esta cadencia
+    static const unsigned long LOW_POWER_ORIENTATION_MS = 1000;
+
+    // intPin < 0: sin interrupción, on() consulta el contador del FIFO
+    FallDetector(int8_t intPin = -1, uint8_t address = 0x68);
+    void begin();
+    void on();
+    // Lectura directa de los registros (no del FIFO): ax, ay, az, gx, gy, gz
+    void mpu_read(int16_t* raw);
+    // Entrada de muestras crudas (cuentas del MPU6050); on() la usa por cada
+    // muestra del FIFO y la reproducción de trazas la llama directamente.
+    void processSample(int16_t rawAx, int16_t rawAy, int16_t rawAz,
+                       int16_t rawGx, int16_t rawGy, int16_t rawGz,
+                       unsigned long now);
+    void setTraceWriter(SensorTraceWriter* writer);
+    bool wasFallDetected();
+
+    // Sesgo persistido; load rechaza registros ausentes o corruptos.
+    bool loadCalibration(CalibrationStore& store);
+    bool saveCalibration(CalibrationStore& store) const;
+    bool isCalibrated() const { return biasValid; }
+    // Sin calibrar: posturas en reposo distintas reunidas hasta ahora
+    uint8_t getCalibrationOrientations() const { return orientationCount; }
+    void getBias(int16_t& x, int16_t& y, int16_t& z) const { x = biasX; y = biasY; z = biasZ; }
+    // true una sola vez cuando la estimación converge, para guardarla
+    bool takeCalibrationUpdate();
+    uint32_t getFifoOverflows() const { return fifoOverflows; }
+
+    // Requiere el pin INT. Desactivarlo despierta el chip en el acto.
+    void setLowPower(bool enabled);
+    bool isLowPower() const { return lowPower; }
+    const Stats& getStats() const { return stats; }
+    uint32_t getInterruptCount() const { return readyCount; }
+
+  private:
+    Stats stats = {};
+};
+
+#endif
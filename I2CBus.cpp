@@ -0,0 +1,92 @@
+#include "I2CBus.h"
+#include "Clock.h"
+
+I2CBus i2cBus;
+
+static const char* const PRIORITY_NAMES[I2CBus::PRIORITY_COUNT] = { "sensores", "pantalla" };
+
+I2CBus::I2CBus() : _busy(false), _sensorsWaiting(0), _started(false) {
+  resetStats();
+}
+
+void I2CBus::begin() {
+  if (_started) return;
+  Wire.begin();
+  Wire.setClock(CLOCK_HZ);
+  _started = true;
+}
+
+bool I2CBus::tryTake() {
+  bool expected = false;
+  return _busy.compare_exchange_strong(expected, true, std::memory_order_acquire);
+}
+
+void I2CBus::pause(Priority priority) {
+#ifdef ARDUINO
+  if (priority == PRIORITY_SENSOR) {
+    taskYIELD();         // el trozo en curso termina en menos de 1 ms
+  } else {
+    vTaskDelay(1);       // la pantalla puede esperar un tick
+  }
+#else
+  (void)priority;
+#endif
+}
+
+void I2CBus::acquire(Priority priority) {
+  uint32_t start = Clock::micros();
+  bool waited = false;
+
+  if (priority == PRIORITY_SENSOR) {
+    _sensorsWaiting.fetch_add(1, std::memory_order_acq_rel);
+    while (!tryTake()) {
+      waited = true;
+      pause(priority);
+    }
+    _sensorsWaiting.fetch_sub(1, std::memory_order_acq_rel);
+  } else {
+    for (;;) {
+      if (_sensorsWaiting.load(std::memory_order_acquire) == 0 && tryTake()) {
+        // Un sensor pudo llegar justo entre la comprobación y la toma
+        if (_sensorsWaiting.load(std::memory_order_acquire) == 0) break;
+        _busy.store(false, std::memory_order_release);
+      }
+      waited = true;
+      pause(priority);
+    }
+  }
+
+  Stats& st = _stats[priority];
+  st.acquisitions++;
+  if (waited) {
+    st.contended++;
+    uint32_t wait = Clock::micros() - start;
+    if (wait > st.maxWaitUs) st.maxWaitUs = wait;
+  }
+}
+
+void I2CBus::release() {
+  _busy.store(false, std::memory_order_release);
+}
+
+void I2CBus::resetStats() {
+  for (uint8_t i = 0; i < PRIORITY_COUNT; i++) {
+    _stats[i].acquisitions = 0;
+    _stats[i].contended = 0;
+    _stats[i].maxWaitUs = 0;
+  }
+}
+
+void I2CBus::printStats(Print& out) const {
+  printStats(_stats, out);
+}
+
+void I2CBus::printStats(const Stats (&stats)[PRIORITY_COUNT], Print& out) {
+  out.println("I2C        accesos  con espera  espera max(us)");
+  for (uint8_t i = 0; i < PRIORITY_COUNT; i++) {
+    out.printf("%-10s %8lu %11lu %15lu\n", PRIORITY_NAMES[i],
+               (unsigned long)stats[i].acquisitions,
+               (unsigned long)stats[i].contended,
+               (unsigned long)stats[i].maxWaitUs);
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+
+// Dueño único del bus I2C compartido (MAX30102, MPU6050 y SSD1306).
+//
+// Inicia Wire una sola vez y fija el reloj. Cada transacción se hace con
+// un Lock de prioridad: las lecturas de sensores (núcleo 1) se adelantan
+// a la pantalla (núcleo 0), que además envía en trozos pequeños y cede el
+// bus entre trozo y trozo. Un sensor espera como mucho un trozo de
+// pantalla que ya estuviera en curso.
+class I2CBus {
+public:
+  enum Priority : uint8_t {
+    PRIORITY_SENSOR,
+    PRIORITY_DISPLAY,
+    PRIORITY_COUNT
+  };
+
+  static const uint32_t CLOCK_HZ = 400000;
+  // Bytes de datos por transacción de baja prioridad: ~0,8 ms a 400 kHz
+  static const uint8_t DISPLAY_CHUNK = 32;
+
+  struct Stats {
+    uint32_t acquisitions;
+    uint32_t contended;
+    uint32_t maxWaitUs;
+  };
+
+  I2CBus();
+
+  void begin();
+
+  void acquire(Priority priority);
+  void release();
+
+  const Stats& getStats(Priority priority) const { return _stats[priority]; }
+  void resetStats();
+  void printStats(Print& out) const;
+  // Cada prioridad solo la escribe su núcleo; quien imprime desde otro
+  // núcleo pasa una copia tomada por el dueño de cada fila
+  static void printStats(const Stats (&stats)[PRIORITY_COUNT], Print& out);
+
+  class Lock {
+  public:
+    Lock(I2CBus& bus, Priority priority) : _bus(bus) { _bus.acquire(priority); }
+    ~Lock() { _bus.release(); }
+
+  private:
+    Lock(const Lock&);
+    Lock& operator=(const Lock&);
+
+    I2CBus& _bus;
+  };
+
+private:
+  std::atomic<bool> _busy;
+  std::atomic<uint8_t> _sensorsWaiting;
+  bool _started;
+  Stats _stats[PRIORITY_COUNT];
+
+  bool tryTake();
+  static void pause(Priority priority);
+};
+
+extern I2CBus i2cBus;
+
+#endif
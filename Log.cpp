@@ -0,0 +1,82 @@
+#include "Log.h"
+#include "MpscRing.h"
+#include "Clock.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+static MpscRing<Log::Record, Log::CAPACITY> ring;
+
+#ifdef ARDUINO
+// Prioridad del idle: solo vuelca cuando adquisición y comunicaciones ceden
+#define LOG_TASK_PRIORITY tskIDLE_PRIORITY
+#define LOG_STACK_SIZE 3072
+#define LOG_FLUSH_MS 50
+
+static TaskHandle_t logTask = nullptr;
+#endif
+
+bool Log::write(uint8_t level, const char* fmt, ...) {
+  Record record;
+  record.timestampMs = (uint32_t)Clock::millis();
+  record.level = level;
+
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(record.text, sizeof(record.text), fmt, args);
+  va_end(args);
+
+  return ring.push(record);
+}
+
+bool Log::pop(Record& record) {
+  return ring.pop(record);
+}
+
+uint32_t Log::dropped() {
+  return ring.dropped();
+}
+
+char Log::levelTag(uint8_t level) {
+  switch (level) {
+    case LOG_LEVEL_ERROR: return 'E';
+    case LOG_LEVEL_WARN:  return 'W';
+    case LOG_LEVEL_INFO:  return 'I';
+    default:              return 'D';
+  }
+}
+
+#ifdef ARDUINO
+void Log::begin(Print& out, BaseType_t core) {
+  if (logTask) return;
+  xTaskCreatePinnedToCore(taskEntry, "log", LOG_STACK_SIZE, &out, LOG_TASK_PRIORITY, &logTask, core);
+}
+
+void Log::flush(Print& out) {
+  static uint32_t reportedDrops = 0;
+  // Una sola escritura por línea; Print::printf pediría memoria al pasar de 64
+  char line[TEXT_SIZE + 16];
+  Record record;
+
+  while (ring.pop(record)) {
+    int n = snprintf(line, sizeof(line), "%lu %c %s\n",
+                     (unsigned long)record.timestampMs, levelTag(record.level), record.text);
+    if (n > 0) out.write((const uint8_t*)line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+  }
+
+  uint32_t drops = ring.dropped();
+  if (drops != reportedDrops) {
+    int n = snprintf(line, sizeof(line), "Log: %lu mensajes descartados\n",
+                     (unsigned long)(drops - reportedDrops));
+    if (n > 0) out.write((const uint8_t*)line, (size_t)n);
+    reportedDrops = drops;
+  }
+}
+
+void Log::taskEntry(void* ctx) {
+  Print& out = *static_cast<Print*>(ctx);
+  for (;;) {
+    flush(out);
+    vTaskDelay(pdMS_TO_TICKS(LOG_FLUSH_MS));
+  }
+}
+#endif
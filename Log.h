@@ -0,0 +1,79 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// Nivel máximo que se compila. Las macros de niveles superiores se quedan
+// en nada: ni llamada, ni evaluación de argumentos, ni cadena en flash.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Registro asíncrono para los mensajes de las rutas calientes. Quien llama
+// formatea el texto en un registro de tamaño fijo y lo deja en un anillo sin
+// bloqueos (cualquier tarea, cualquier núcleo); una tarea de baja prioridad
+// lo vuelca al puerto serie. Con el anillo lleno el mensaje se descarta y se
+// cuenta, nunca se espera a la UART.
+class Log {
+public:
+  static const size_t TEXT_SIZE = 88;        // con el '\0'; lo que sobre se trunca
+  static const size_t CAPACITY = 32;
+
+  struct Record {
+    uint32_t timestampMs;
+    uint8_t level;
+    char text[TEXT_SIZE];
+  };
+
+  static bool write(uint8_t level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  // Lado consumidor (la tarea de volcado, o quien lo drene en el host)
+  static bool pop(Record& record);
+  static uint32_t dropped();
+
+  static char levelTag(uint8_t level);
+
+#ifdef ARDUINO
+  // Lanza la tarea que vuelca a `out`. Lo escrito antes espera en el anillo.
+  static void begin(Print& out, BaseType_t core = 0);
+  // Vuelca lo pendiente y avisa de los descartes nuevos
+  static void flush(Print& out);
+#endif
+
+private:
+#ifdef ARDUINO
+  static void taskEntry(void* ctx);
+#endif
+};
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) ((void)Log::write(LOG_LEVEL_ERROR, __VA_ARGS__))
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) ((void)Log::write(LOG_LEVEL_WARN, __VA_ARGS__))
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) ((void)Log::write(LOG_LEVEL_INFO, __VA_ARGS__))
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) ((void)Log::write(LOG_LEVEL_DEBUG, __VA_ARGS__))
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <Arduino.h>
+#include <Pulseoximeter.h>
+#include <BloodPressureReader.h>
+#include <BPPulseDetector.h>
+#include <FallDetector.h>
+
+// RAM que cuesta cada pipeline de sensor, resuelta en tiempo de compilación.
+// Todos los buffers son de tamaño fijo, así que sizeof() es el coste real.
+namespace MemoryBudget {
+  static constexpr size_t PULSEOXIMETER = sizeof(Pulseoximeter);
+  static constexpr size_t BLOOD_PRESSURE = sizeof(BloodPressureReader) + sizeof(BPPulseDetector);
+  static constexpr size_t FALL_DETECTOR = sizeof(FallDetector);
+  static constexpr size_t SENSOR_TOTAL = PULSEOXIMETER + BLOOD_PRESSURE + FALL_DETECTOR;
+
+  static constexpr size_t SENSOR_LIMIT = 8192;
+  static_assert(SENSOR_TOTAL <= SENSOR_LIMIT, "Sensor pipelines exceed their static RAM budget");
+
+  inline void print(Print& out) {
+    out.println("Memoria estática por pipeline (bytes):");
+    out.print("  Pulsioxímetro: ");
+    out.println((unsigned long)PULSEOXIMETER);
+    out.print("  Presión (HX711 + pulsos): ");
+    out.println((unsigned long)BLOOD_PRESSURE);
+    out.print("  Caídas (MPU6050): ");
+    out.println((unsigned long)FALL_DETECTOR);
+    out.print("  Total: ");
+    out.print((unsigned long)SENSOR_TOTAL);
+    out.print(" / ");
+    out.println((unsigned long)SENSOR_LIMIT);
+  }
+}
+
+#endif
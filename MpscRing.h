@@ -0,0 +1,85 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Anillo sin bloqueos para cualquier número de productores (tareas de
+// cualquier núcleo) y un único consumidor. Cada celda lleva un número de
+// secuencia: el productor reserva una posición con un CAS sobre la cabeza y
+// publica la celda avanzando su secuencia, así el consumidor nunca ve un
+// elemento a medio escribir y los productores nunca se esperan entre sí.
+// N debe ser potencia de dos.
+template <typename T, size_t N>
+class MpscRing {
+public:
+  MpscRing() : _head(0), _tail(0), _dropped(0) {
+    for (uint32_t i = 0; i < N; i++) {
+      _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Lado productor. Nunca espera: si está lleno descarta el elemento y lo cuenta.
+  bool push(const T& item) {
+    uint32_t pos = _head.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &_cells[pos & MASK];
+      uint32_t seq = cell->seq.load(std::memory_order_acquire);
+      int32_t diff = (int32_t)(seq - pos);
+      if (diff == 0) {
+        if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        // El consumidor aún no ha liberado esta celda
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = _head.load(std::memory_order_relaxed);
+      }
+    }
+    cell->item = item;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Lado consumidor.
+  bool pop(T& item) {
+    uint32_t pos = _tail.load(std::memory_order_relaxed);
+    Cell& cell = _cells[pos & MASK];
+    if (cell.seq.load(std::memory_order_acquire) != pos + 1) {
+      return false;
+    }
+    item = cell.item;
+    cell.seq.store(pos + N, std::memory_order_release);
+    _tail.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Posiciones reservadas, incluidas las que un productor aún está escribiendo.
+  size_t size() const {
+    return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_relaxed);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  static constexpr size_t capacity() { return N; }
+
+private:
+  static_assert(N > 0 && (N & (N - 1)) == 0, "MpscRing size must be a power of two");
+  static const uint32_t MASK = N - 1;
+
+  struct Cell {
+    std::atomic<uint32_t> seq;
+    T item;
+  };
+
+  Cell _cells[N];
+  std::atomic<uint32_t> _head;
+  std::atomic<uint32_t> _tail;
+  std::atomic<uint32_t> _dropped;
+};
+
+#endif
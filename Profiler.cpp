@@ -0,0 +1,112 @@
+#include <Profiler.h>
+
+#ifdef ENABLE_PROFILING
+
+#include <stdio.h>
+#include <string.h>
+
+Profiler::StageStats Profiler::_stats[PROF_STAGE_COUNT];
+
+static const char* const STAGE_NAMES[PROF_STAGE_COUNT] = {
+  "ppg", "imu", "hx711", "bp", "alertas", "reporte", "oled", "ble", "codif"
+};
+
+uint8_t Profiler::bucketFor(uint32_t ticks) {
+  // Cubo i cubre [2^i, 2^(i+1)); el 0 también recoge el cero
+  uint8_t bucket = 0;
+  while (ticks > 1 && bucket < BUCKETS - 1) {
+    ticks >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void Profiler::record(ProfileStage stage, uint32_t ticks) {
+  StageStats& st = _stats[stage];
+  if (st.count == 0 || ticks < st.minTicks) st.minTicks = ticks;
+  if (ticks > st.maxTicks) st.maxTicks = ticks;
+  st.totalTicks += ticks;
+  st.buckets[bucketFor(ticks)]++;
+  st.count++;
+}
+
+void Profiler::reset() {
+  memset(_stats, 0, sizeof(_stats));
+}
+
+void Profiler::reset(ProfileStage stage) {
+  memset(&_stats[stage], 0, sizeof(_stats[stage]));
+}
+
+uint32_t Profiler::percentile(ProfileStage stage, uint8_t pct) {
+  const StageStats& st = _stats[stage];
+  if (st.count == 0) return 0;
+
+  uint32_t target = (uint32_t)(((uint64_t)st.count * pct + 99) / 100);
+  if (target == 0) target = 1;
+
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    seen += st.buckets[i];
+    if (seen >= target) {
+      uint32_t upper = (i == BUCKETS - 1) ? st.maxTicks : ((1UL << (i + 1)) - 1);
+      return upper < st.maxTicks ? upper : st.maxTicks;
+    }
+  }
+  return st.maxTicks;
+}
+
+uint32_t Profiler::ticksPerUs() {
+#ifdef ARDUINO
+  return ESP.getCpuFreqMHz();
+#else
+  return 1000;
+#endif
+}
+
+const char* Profiler::stageName(ProfileStage stage) {
+  return STAGE_NAMES[stage];
+}
+
+size_t Profiler::format(char* buf, size_t len) {
+  if (len == 0) return 0;
+  buf[0] = '\0';
+
+  uint32_t div = ticksPerUs();
+  size_t used = 0;
+  for (uint8_t s = 0; s < PROF_STAGE_COUNT && used < len - 1; s++) {
+    ProfileStage stage = (ProfileStage)s;
+    const StageStats& st = _stats[s];
+    int n = snprintf(buf + used, len - used, "%s %lu %lu %lu %lu %lu %lu\n",
+                     STAGE_NAMES[s], (unsigned long)st.count,
+                     (unsigned long)(st.minTicks / div),
+                     (unsigned long)(percentile(stage, 50) / div),
+                     (unsigned long)(percentile(stage, 95) / div),
+                     (unsigned long)(percentile(stage, 99) / div),
+                     (unsigned long)(st.maxTicks / div));
+    if (n < 0) break;
+    used += (size_t)n;
+  }
+  return used < len ? used : len - 1;
+}
+
+#ifdef ARDUINO
+void Profiler::printReport(Print& out) {
+  uint32_t div = ticksPerUs();
+  out.println("Etapa      n        min(us)  p50(us)  p95(us)  p99(us)  max(us)  media(us)");
+  for (uint8_t s = 0; s < PROF_STAGE_COUNT; s++) {
+    ProfileStage stage = (ProfileStage)s;
+    const StageStats& st = _stats[s];
+    unsigned long mean = st.count ? (unsigned long)(st.totalTicks / st.count / div) : 0;
+    out.printf("%-10s %-8lu %8lu %8lu %8lu %8lu %8lu %10lu\n",
+               STAGE_NAMES[s], (unsigned long)st.count,
+               (unsigned long)(st.minTicks / div),
+               (unsigned long)(percentile(stage, 50) / div),
+               (unsigned long)(percentile(stage, 95) / div),
+               (unsigned long)(percentile(stage, 99) / div),
+               (unsigned long)(st.maxTicks / div), mean);
+  }
+}
+#endif
+
+#endif
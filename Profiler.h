@@ -0,0 +1,105 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Descomentar para medir cada etapa del bucle. Desactivado, PROFILE_SCOPE
+// no genera código y Profiler no existe.
+// #define ENABLE_PROFILING
+
+#ifdef ENABLE_PROFILING
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+// Etapas medidas. Cada una se registra siempre desde el mismo núcleo, así
+// que cada histograma tiene un único escritor.
+enum ProfileStage : uint8_t {
+  PROF_PPG,        // lectura MAX30102 + algoritmo
+  PROF_IMU,        // lectura MPU6050 + detección de caídas
+  PROF_HX711,      // HX711: lectura bit a bit por sondeo, o vaciado de la
+                   // cola en modo interrupción (la ISR no se mide)
+  PROF_BP,         // detector de pulsos / calibración
+  PROF_ALERTS,
+  PROF_REPORT,
+  PROF_DISPLAY,    // envío del framebuffer al OLED
+  PROF_BLE,        // codificación + notify
+  PROF_ENCODE,     // solo la codificación (trama binaria o JSON)
+  PROF_STAGE_COUNT
+};
+
+// Histograma en potencias de dos sobre ticks (ciclos de CPU en el ESP32,
+// nanosegundos en el host). Memoria fija; los percentiles se resuelven
+// al límite superior del cubo, acotado por el máximo observado.
+class Profiler {
+public:
+  static const uint8_t BUCKETS = 24;   // 2^24 ciclos ≈ 70 ms a 240 MHz; el último acumula el resto
+
+  struct StageStats {
+    uint32_t count;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+    uint32_t buckets[BUCKETS];
+  };
+
+  static inline uint32_t now() {
+#ifdef ARDUINO
+    return ESP.getCycleCount();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  static void record(ProfileStage stage, uint32_t ticks);
+  static void reset();
+  // Solo desde el núcleo que registra esa etapa
+  static void reset(ProfileStage stage);
+
+  static const StageStats& getStats(ProfileStage stage) { return _stats[stage]; }
+  static uint32_t percentile(ProfileStage stage, uint8_t pct);
+  static uint32_t ticksPerUs();
+  static const char* stageName(ProfileStage stage);
+
+  // Una línea por etapa: "nombre n min p50 p95 p99 max" en microsegundos.
+  // Devuelve la longitud escrita (truncada a len - 1).
+  static size_t format(char* buf, size_t len);
+#ifdef ARDUINO
+  static void printReport(Print& out);
+#endif
+
+private:
+  static StageStats _stats[PROF_STAGE_COUNT];
+
+  static uint8_t bucketFor(uint32_t ticks);
+};
+
+class ProfileScope {
+public:
+  explicit ProfileScope(ProfileStage stage) : _stage(stage), _start(Profiler::now()) {}
+  ~ProfileScope() { Profiler::record(_stage, Profiler::now() - _start); }
+
+private:
+  ProfileScope(const ProfileScope&);
+  ProfileScope& operator=(const ProfileScope&);
+
+  ProfileStage _stage;
+  uint32_t _start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(stage)
+
+#else
+
+#define PROFILE_SCOPE(stage) do {} while (0)
+
+#endif
+
+#endif
@@ -1,206 +1,217 @@
-#include <Pulseoximeter.h>
-#include <Wire.h>
-#include <limits.h>
-
-
-static int calculateSpO2FromBuffers(long *redBuf, long *irBuf, byte len) {
-  if (len == 0) return -1;
-
-  long minR = LONG_MAX, maxR = LONG_MIN;
-  long minIR = LONG_MAX, maxIR = LONG_MIN;
-  long sumR = 0, sumIR = 0;
-
-  for (byte i = 0; i < len; i++) {
-    long r = redBuf[i];
-    long ir = irBuf[i];
-    sumR += r;
-    sumIR += ir;
-    if (r < minR) minR = r;
-    if (r > maxR) maxR = r;
-    if (ir < minIR) minIR = ir;
-    if (ir > maxIR) maxIR = ir;
-  }
-
-  float dcR = (float)sumR / len;
-  float dcIR = (float)sumIR / len;
-  float acR = (float)(maxR - minR);
-  float acIR = (float)(maxIR - minIR);
-
-  if (dcR <= 0.0f || dcIR <= 0.0f || acIR <= 0.0f) return -1;
-
-  float ratio = (acR / dcR) / (acIR / dcIR);
-  float spo2 = 110.0f - 25.0f * ratio;
-
-  if (spo2 > 100.0f) spo2 = 100.0f;
-  if (spo2 < 0.0f) spo2 = 0.0f;
-
-  return (int)round(spo2);
-}
-
-
-Pulseoximeter::Pulseoximeter(): particleSensor() {
-  this->fingerPreviouslyDetected = false;
-  this->FINGER_THRESHOLD = 50000;
-
-  this->rateSpot = 0;
-  this->lastBeat = 0;
-  this->beatsPerMinute = 0;
-  this->beatAvg = 0;
-  this->SAMPLE_INTERVAL_MS = 10;   
-  this->PRINT_INTERVAL_MS = 5000; 
-  this->lastSampleMillis = 0;
-  this->lastPrintMillis = 0;
-  this->lastIRvalue = 0;
-  this->didPrint = false;
-
-  this->spo2Index = 0;
-  this->spo2Ready = false;
-  this->spo2Value = -1;
-  for (byte i = 0; i < SPO2_WINDOW; i++) {
-    this->redBuffer[i] = 0;
-    this->irBuffer[i] = 0;
-  }
-}
-
-
-void Pulseoximeter::begin() {
-  Serial.println("Iniciando Pulseoximeter...");
-  Wire.begin();
-
-  if (!particleSensor.begin(Wire, I2C_SPEED_FAST)) {
-    Serial.println("MAX30102 no encontrado. Verifica wiring.");
-    while (1) delay(1000);
-  }
-
-  particleSensor.setup();
-  particleSensor.setPulseAmplitudeRed(0x1E);
-  particleSensor.setPulseAmplitudeGreen(0);
-
-  resetMeasurements();
-
-  this->lastSampleMillis = millis();
-  this->lastPrintMillis = millis();
-  this->lastBeat = millis();
-}
-
-void Pulseoximeter::resetMeasurements() {
-  for (byte i = 0; i < RATE_SIZE; i++) this->rates[i] = 0;
-  this->rateSpot = 0;
-  this->beatAvg = 0;
-  this->lastBeat = millis();
-}
-
-
-bool Pulseoximeter::isFingerDetected(long lastIRvalue) {
-  if (lastIRvalue >= FINGER_THRESHOLD)  {
-    return true;
-  }
-  return false; 
-}
-
-void Pulseoximeter::detectAndSetTransition(bool fingerDetected) {
-  if (fingerDetected && !fingerPreviouslyDetected) {
-    resetMeasurements();
-    Serial.println("Nuevo dedo detectado → reiniciando medición…");
-    this->fingerPreviouslyDetected = fingerDetected;
-  }
-  if (!fingerDetected && fingerPreviouslyDetected) {
-    this->fingerPreviouslyDetected = fingerDetected;
-  }
-}
-
-void Pulseoximeter::processData(bool fingerDetected, long irValue, unsigned long now) {
-  if (fingerDetected) {
-
-    if (now - lastSampleMillis >= SAMPLE_INTERVAL_MS) {
-      lastSampleMillis += SAMPLE_INTERVAL_MS;
-
-      long redValue = particleSensor.getRed(); 
-      irBuffer[spo2Index] = irValue;
-      redBuffer[spo2Index] = redValue;
-      spo2Index++;
-      if (spo2Index >= SPO2_WINDOW) {
-        spo2Index = 0;
-        spo2Ready = true;
-        spo2Value = calculateSpO2FromBuffers(redBuffer, irBuffer, SPO2_WINDOW);
-      }
-
-      if (checkForBeat(irValue)) {
-        long delta = now - lastBeat;
-        lastBeat = now;
-
-        if (delta > 0) {
-          float instantBPM = 60.0f / (delta / 1000.0f);
-
-          if (instantBPM > 20 && instantBPM < 250) {
-            rates[rateSpot++] = (byte)instantBPM;
-            rateSpot %= RATE_SIZE;
-
-            long sum = 0;
-            byte cnt = 0;
-            for (byte x = 0; x < RATE_SIZE; x++) {
-              if (rates[x] > 0) { sum += rates[x]; cnt++; }
-            }
-            if (cnt > 0) beatAvg = sum / cnt;
-          }
-        }
-      }
-    }
-  }
-  else {
-    beatAvg = 0;
-    spo2Value = -1;
-  }
-
-}
-
-
-int Pulseoximeter::getAverageBPM() { 
-  return beatAvg; 
-}
-
-
-void Pulseoximeter::setPrintStatus(bool status) {
-  this->didPrint = status;
-}
-
-bool Pulseoximeter::getPrintStatus() {
-  return didPrint;
-}
-
-int Pulseoximeter::getSpO2() {
-  return spo2Value;
-}
-
-
-void Pulseoximeter::on() {
-
-  unsigned long now = millis();
-  long irValue = particleSensor.getIR();
-  this->lastIRvalue = irValue;
-
-  bool fingerDetected = isFingerDetected(lastIRvalue);
-
-  detectAndSetTransition(fingerDetected);
-
-  processData(fingerDetected, irValue, now);
-
-  if (now - lastPrintMillis >= PRINT_INTERVAL_MS) {
-    lastPrintMillis += PRINT_INTERVAL_MS;
-
-    if (fingerDetected) {
-      if (beatAvg > 0) {
-        // setPrintStatus(true);
-        if (spo2Value >= 0) {
-          setPrintStatus(true);
-          // Serial.print("SpO2: "); Serial.println(spo2Value);
-        }
-      }
-    } else {
-      Serial.println("Sin dedo, no se imprime BPM.");
-    }
-
-    // setPrintStatus(false);
-  }
-  
+#include <Pulseoximeter.h>
+#include <Clock.h>
+#include <SensorTrace.h>
+#include <WaveformStreamer.h>
+#include <I2CBus.h>
+#include <Log.h>
+#include <Wire.h>
+
+
+Pulseoximeter::Pulseoximeter(): particleSensor(), spo2Estimator(SPO2_HOP) {
+  this->fingerPreviouslyDetected = false;
+  this->FINGER_THRESHOLD = 50000;
+
+  this->lastBeat = 0;
+  this->beatsPerMinute = 0;
+  this->beatAvg = 0;
+  this->SAMPLE_INTERVAL_MS = 10;   
+  this->PRINT_INTERVAL_MS = 5000; 
+  this->lastPrintMillis = 0;
+  this->lastIRvalue = 0;
+  this->didPrint = false;
+
+  this->spo2Value = -1;
+  this->droppedSamples = 0;
+  this->traceWriter = nullptr;
+  this->waveformStreamer = nullptr;
+}
+
+
+void Pulseoximeter::begin() {
+  Serial.println("Iniciando Pulseoximeter...");
+  i2cBus.begin();
+
+  if (!particleSensor.begin(Wire, I2CBus::CLOCK_HZ)) {
+    Serial.println("MAX30102 no encontrado. Verifica wiring.");
+    while (1) delay(1000);
+  }
+
+  particleSensor.setup(0x1F, SAMPLE_AVERAGE, LED_MODE_RED_IR, SAMPLE_RATE, 411, 4096);
+  particleSensor.setPulseAmplitudeRed(0x1E);
+
+  resetMeasurements();
+
+  this->lastPrintMillis = Clock::millis();
+  this->lastBeat = Clock::millis();
+}
+
+void Pulseoximeter::startSampling() {
+  I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+  particleSensor.clearFIFO();
+}
+
+void Pulseoximeter::resetMeasurements() {
+  this->rates.reset();
+  this->beatAvg = 0;
+  this->lastBeat = Clock::millis();
+}
+
+
+bool Pulseoximeter::isFingerDetected(long lastIRvalue) {
+  if (lastIRvalue >= FINGER_THRESHOLD)  {
+    return true;
+  }
+  return false; 
+}
+
+void Pulseoximeter::detectAndSetTransition(bool fingerDetected) {
+  if (fingerDetected && !fingerPreviouslyDetected) {
+    resetMeasurements();
+    LOG_INFO("Nuevo dedo detectado → reiniciando medición…");
+    this->fingerPreviouslyDetected = fingerDetected;
+  }
+  if (!fingerDetected && fingerPreviouslyDetected) {
+    this->fingerPreviouslyDetected = fingerDetected;
+  }
+}
+
+void Pulseoximeter::processData(bool fingerDetected, long irValue, long redValue, unsigned long now) {
+  if (fingerDetected) {
+
+    if (spo2Estimator.push(redValue, irValue)) {
+      spo2Value = spo2Estimator.getValue();
+    }
+
+    if (checkForBeat(irValue)) {
+      long delta = now - lastBeat;
+      lastBeat = now;
+
+      if (delta > 0) {
+        float instantBPM = 60.0f / (delta / 1000.0f);
+
+        if (instantBPM > 20 && instantBPM < 250) {
+          rates.push((byte)instantBPM);
+          beatAvg = rates.average();
+        }
+      }
+    }
+  }
+  else {
+    beatAvg = 0;
+    spo2Value = -1;
+  }
+
+}
+
+
+int Pulseoximeter::getAverageBPM() { 
+  return beatAvg; 
+}
+
+
+void Pulseoximeter::setPrintStatus(bool status) {
+  this->didPrint = status;
+}
+
+bool Pulseoximeter::getPrintStatus() {
+  return didPrint;
+}
+
+int Pulseoximeter::getSpO2() {
+  return spo2Value;
+}
+
+void Pulseoximeter::setSpO2Hop(uint16_t samples) {
+  spo2Estimator.setHop(samples);
+}
+
+
+bool Pulseoximeter::ingestSample(long redValue, long irValue, unsigned long sampleTime) {
+  this->lastIRvalue = irValue;
+  bool fingerDetected = isFingerDetected(irValue);
+  detectAndSetTransition(fingerDetected);
+  processData(fingerDetected, irValue, redValue, sampleTime);
+  return fingerDetected;
+}
+
+void Pulseoximeter::setTraceWriter(SensorTraceWriter* writer) {
+  this->traceWriter = writer;
+}
+
+void Pulseoximeter::setWaveformStreamer(WaveformStreamer* streamer) {
+  this->waveformStreamer = streamer;
+}
+
+
+void Pulseoximeter::drainLibrary(uint16_t read) {
+  // El anillo se vacía entero en cada pasada, así que lo que falte de lo
+  // leído es lo que la librería pisó
+  uint8_t pending = particleSensor.available();
+  if (read > pending) {
+    droppedSamples += read - pending;
+  }
+
+  unsigned long now = Clock::millis();
+  uint32_t nowUs = Clock::micros();
+  while (particleSensor.available()) {
+    long redValue = particleSensor.getFIFORed();
+    long irValue = particleSensor.getFIFOIR();
+    particleSensor.nextSample();
+    pending--;
+
+    // Las muestras del lote están espaciadas SAMPLE_INTERVAL_MS; la última es "ahora"
+    unsigned long sampleTime = now - (unsigned long)pending * SAMPLE_INTERVAL_MS;
+
+    if (traceWriter) {
+      int32_t values[2] = { (int32_t)redValue, (int32_t)irValue };
+      uint32_t sampleUs = nowUs - (uint32_t)pending * SAMPLE_INTERVAL_MS * 1000UL;
+      traceWriter->record(TRACE_PPG, sampleUs, values);
+    }
+    if (waveformStreamer) {
+      waveformStreamer->push(WAVE_PPG, (int32_t)irValue, sampleTime);
+    }
+
+    ingestSample(redValue, irValue, sampleTime);
+  }
+}
+
+void Pulseoximeter::on() {
+
+  bool fingerDetected = fingerPreviouslyDetected;
+
+  // check() copia TODO el FIFO del chip al anillo de la librería, que solo
+  // guarda 3 muestras sin leer (STORAGE_SIZE 4) y pisa el resto sin avisar.
+  // A 100 Hz, llamando en cada pasada de la tarea (10 ms) llega 1 muestra,
+  // a veces 2; se repite hasta que el chip no tenga nada nuevo.
+  for (;;) {
+    uint16_t read;
+    {
+      // Solo check() toca el bus; el resto lee el buffer de la librería
+      I2CBus::Lock lock(i2cBus, I2CBus::PRIORITY_SENSOR);
+      read = particleSensor.check();
+    }
+    if (read == 0) break;
+    drainLibrary(read);
+    fingerDetected = fingerPreviouslyDetected;
+  }
+
+  unsigned long now = Clock::millis();
+  if (now - lastPrintMillis >= PRINT_INTERVAL_MS) {
+    lastPrintMillis += PRINT_INTERVAL_MS;
+
+    if (fingerDetected) {
+      if (beatAvg > 0) {
+        // setPrintStatus(true);
+        if (spo2Value >= 0) {
+          setPrintStatus(true);
+          // Serial.print("SpO2: "); Serial.println(spo2Value);
+        }
+      }
+    } else {
+      LOG_DEBUG("Sin dedo, no se imprime BPM.");
+    }
+
+    // setPrintStatus(false);
+  }
+  
 }
\ No newline at end of file
@@ -1,47 +1,70 @@
-#ifndef PULSEOXIMETER_H
-#define PULSEOXIMETER_H
-
-#include <Arduino.h>
-#include "MAX30105.h"
-#include "heartRate.h"
-
-class Pulseoximeter {
-  private:
-    MAX30105 particleSensor;
-    bool fingerPreviouslyDetected;
-    uint32_t FINGER_THRESHOLD;
-
-    static const byte RATE_SIZE = 4;
-    byte rates[RATE_SIZE];
-    byte rateSpot;
-    long lastBeat;
-    float beatsPerMinute;
-    int beatAvg;
-    long SAMPLE_INTERVAL_MS;   
-    long PRINT_INTERVAL_MS; 
-    long lastSampleMillis;
-    long lastPrintMillis;
-    uint32_t lastIRvalue;
-    bool didPrint;
-
-    static const byte SPO2_WINDOW = 100;     
-    long redBuffer[SPO2_WINDOW];
-    long irBuffer[SPO2_WINDOW];
-    byte spo2Index;
-    bool spo2Ready;
-    int spo2Value;
-  public:
-    Pulseoximeter();
-    void begin();
-    void on();
-    bool isFingerDetected(long lastIRvalue);
-    void detectAndSetTransition(bool fingerDetected);
-    void processData(bool fingerDetected, long irValue, unsigned long now);
-    void setPrintStatus(bool status);
-    int getAverageBPM();
-    bool getPrintStatus();
-    void resetMeasurements();
-    int getSpO2();
-};
-
+#ifndef PULSEOXIMETER_H
+#define PULSEOXIMETER_H
+
+#include <Arduino.h>
+#include "MAX30105.h"
+#include "heartRate.h"
+#include "RingBuffer.h"
+#include "SpO2Estimator.h"
+
+class SensorTraceWriter;
+class WaveformStreamer;
+
+class Pulseoximeter {
+  private:
+    MAX30105 particleSensor;
+    bool fingerPreviouslyDetected;
+    uint32_t FINGER_THRESHOLD;
+
+    static const byte RATE_SIZE = 4;
+    SummingRingBuffer<byte, RATE_SIZE, long> rates;
+    long lastBeat;
+    float beatsPerMinute;
+    int beatAvg;
+    long SAMPLE_INTERVAL_MS;   
+    unsigned long PRINT_INTERVAL_MS;
+    unsigned long lastPrintMillis;
+    uint32_t lastIRvalue;
+    bool didPrint;
+
+    // 400 Hz con promedio de 4 en el chip → 100 Hz efectivos, solo rojo + IR
+    static const byte SAMPLE_AVERAGE = 4;
+    static const byte LED_MODE_RED_IR = 2;
+    static const int SAMPLE_RATE = 400;
+
+    static const uint16_t SPO2_HOP = 10;
+    SpO2Estimator spo2Estimator;
+    int spo2Value;
+
+    // Muestras que check() trajo del chip y la librería pisó en su anillo
+    uint32_t droppedSamples;
+
+    SensorTraceWriter* traceWriter;
+    WaveformStreamer* waveformStreamer;
+
+    void drainLibrary(uint16_t read);
+  public:
+    Pulseoximeter();
+    void begin();
+    // Descarta lo acumulado en el FIFO desde begin(); llamar justo antes de
+    // la primera pasada de on() si entre medias hubo esperas bloqueantes
+    void startSampling();
+    void on();
+    bool isFingerDetected(long lastIRvalue);
+    void detectAndSetTransition(bool fingerDetected);
+    void processData(bool fingerDetected, long irValue, long redValue, unsigned long now);
+    // Una muestra cruda rojo/IR con su instante; on() la usa por cada
+    // muestra del FIFO y la reproducción de trazas la llama directamente.
+    bool ingestSample(long redValue, long irValue, unsigned long sampleTime);
+    void setTraceWriter(SensorTraceWriter* writer);
+    void setWaveformStreamer(WaveformStreamer* streamer);
+    void setPrintStatus(bool status);
+    int getAverageBPM();
+    bool getPrintStatus();
+    void resetMeasurements();
+    int getSpO2();
+    void setSpO2Hop(uint16_t samples);
+    uint32_t getDroppedSamples() const { return droppedSamples; }
+};
+
 #endif
\ No newline at end of file
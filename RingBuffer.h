@@ -0,0 +1,123 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+
+// Menor potencia de dos >= n; dimensiona los anillos en compilación.
+static constexpr size_t ringStorageFor(size_t n, size_t p = 1) {
+  return (p >= n) ? p : ringStorageFor(n, p << 1);
+}
+
+// Buffer circular de capacidad fija con las últimas N muestras. El
+// almacenamiento se redondea a potencia de dos para indexar con una
+// máscara; la ventana lógica sigue siendo exactamente N. Sin heap.
+template <typename T, size_t N>
+class RingBuffer {
+public:
+  static const size_t CAPACITY = N;
+  static const size_t STORAGE = ringStorageFor(N);
+
+  RingBuffer() : _head(0), _count(0) {}
+
+  // Añade una muestra; lleno, pisa la más antigua.
+  void push(const T& value) {
+    _items[_head & MASK] = value;
+    _head++;
+    if (_count < N) {
+      _count++;
+    }
+  }
+
+  // Llena toda la ventana con un valor (p. ej. tras una calibración).
+  void fill(const T& value) {
+    for (size_t i = 0; i < N; ++i) {
+      push(value);
+    }
+  }
+
+  void reset() {
+    _head = 0;
+    _count = 0;
+  }
+
+  size_t size() const { return _count; }
+  bool isEmpty() const { return _count == 0; }
+  bool isFull() const { return _count == N; }
+
+  // i = 0 es la muestra más antigua que sigue en la ventana.
+  const T& operator[](size_t i) const { return _items[(_head - _count + i) & MASK]; }
+  const T& oldest() const { return (*this)[0]; }
+  const T& newest() const { return _items[(_head - 1) & MASK]; }
+
+  // Muestra que echará el próximo push() (solo tiene sentido lleno).
+  const T& evictionCandidate() const { return _items[(_head - N) & MASK]; }
+
+private:
+  static_assert(N > 0, "RingBuffer needs at least one slot");
+  static const uint32_t MASK = STORAGE - 1;
+
+  T _items[STORAGE];
+  uint32_t _head;
+  size_t _count;
+};
+
+template <typename T, size_t N> const size_t RingBuffer<T, N>::CAPACITY;
+template <typename T, size_t N> const size_t RingBuffer<T, N>::STORAGE;
+template <typename T, size_t N> const uint32_t RingBuffer<T, N>::MASK;
+
+// RingBuffer que además lleva la suma de la ventana en O(1). SumT permite
+// acumular muestras estrechas en un tipo más ancho. Las sumas en coma
+// flotante se rehacen una vez por ventana para que el redondeo de sumar y
+// restar no derive.
+template <typename T, size_t N, typename SumT = T>
+class SummingRingBuffer : public RingBuffer<T, N> {
+public:
+  SummingRingBuffer() : _sum(0), _sinceResync(0) {}
+
+  void push(const T& value) {
+    if (this->isFull()) {
+      _sum -= (SumT)this->evictionCandidate();
+    }
+    RingBuffer<T, N>::push(value);
+    _sum += (SumT)value;
+    
+    if (std::is_floating_point<SumT>::value && ++_sinceResync >= N) {
+      resync();
+    }
+  }
+
+  void fill(const T& value) {
+    for (size_t i = 0; i < N; ++i) {
+      push(value);
+    }
+  }
+
+  void reset() {
+    RingBuffer<T, N>::reset();
+    _sum = 0;
+    _sinceResync = 0;
+  }
+
+  SumT sum() const { return _sum; }
+
+  SumT average() const {
+    return this->isEmpty() ? (SumT)0 : _sum / (SumT)this->size();
+  }
+
+private:
+  SumT _sum;
+  size_t _sinceResync;
+
+  void resync() {
+    SumT sum = 0;
+    for (size_t i = 0; i < this->size(); ++i) {
+      sum += (SumT)(*this)[i];
+    }
+    _sum = sum;
+    _sinceResync = 0;
+  }
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "SensorReplay.h"
+#include "Clock.h"
+
+SensorReplay::SensorReplay(Pulseoximeter* pulseoximeter, FallDetector* fallDetector,
+                           BloodPressureReader* bpReader, BPPulseDetector* pulseDetector)
+  : _pulseoximeter(pulseoximeter),
+    _fallDetector(fallDetector),
+    _bpReader(bpReader),
+    _pulseDetector(pulseDetector),
+    _records(0),
+    _skipped(0)
+{
+}
+
+bool SensorReplay::run(SensorTraceReader& reader) {
+  if (!begin(reader)) {
+    return false;
+  }
+
+  while (step(reader)) {}
+
+  return !reader.isCorrupt();
+}
+
+bool SensorReplay::begin(SensorTraceReader& reader) {
+  _records = 0;
+  _skipped = 0;
+
+  if (!reader.begin()) {
+    return false;
+  }
+
+  if (_bpReader) {
+    _bpReader->setReplayMode(true);
+  }
+  return true;
+}
+
+bool SensorReplay::step(SensorTraceReader& reader) {
+  TraceRecord rec;
+  if (!reader.next(rec)) {
+    return false;
+  }
+
+  if (!Clock::isVirtual()) {
+    Clock::useVirtual(rec.timestampUs);
+  }
+  Clock::setMicros(rec.timestampUs);
+
+  dispatch(rec);
+  _records++;
+  return true;
+}
+
+void SensorReplay::dispatch(const TraceRecord& rec) {
+  switch (rec.channel) {
+    case TRACE_PPG:
+      if (_pulseoximeter) {
+        _pulseoximeter->ingestSample(rec.values[0], rec.values[1], Clock::millis());
+        return;
+      }
+      break;
+
+    case TRACE_IMU:
+      if (_fallDetector) {
+        _fallDetector->processSample((int16_t)rec.values[0], (int16_t)rec.values[1],
+                                     (int16_t)rec.values[2], (int16_t)rec.values[3],
+                                     (int16_t)rec.values[4], (int16_t)rec.values[5],
+                                     Clock::millis());
+        return;
+      }
+      break;
+
+    case TRACE_HX711:
+      if (_bpReader) {
+        _bpReader->injectSample(rec.values[0]);
+        if (_pulseDetector) {
+          _pulseDetector->update();
+        } else {
+          _bpReader->update();
+        }
+        return;
+      }
+      break;
+  }
+
+  _skipped++;
+}
@@ -0,0 +1,44 @@
+#ifndef SENSOR_REPLAY_H
+#define SENSOR_REPLAY_H
+
+#include "SensorTrace.h"
+#include "Pulseoximeter.h"
+#include "FallDetector.h"
+#include "BloodPressureReader.h"
+#include "BPPulseDetector.h"
+
+// Reproduce una traza a través de las clases de procesamiento sin tocar el
+// hardware. Pasa Clock a modo virtual y lo coloca en el instante de cada
+// registro antes de entregarlo, así que dos reproducciones de la misma
+// traza dan exactamente los mismos resultados. Al terminar el reloj sigue
+// virtual, parado en el último registro. Cualquier puntero puede ser nulo
+// para ignorar ese canal.
+class SensorReplay {
+public:
+  SensorReplay(Pulseoximeter* pulseoximeter, FallDetector* fallDetector,
+               BloodPressureReader* bpReader, BPPulseDetector* pulseDetector);
+
+  // Traza completa. false si la cabecera no es válida o está corrupta.
+  bool run(SensorTraceReader& reader);
+
+  // Registro a registro, para consultar resultados intermedios: begin()
+  // valida la cabecera y step() devuelve false al final de la traza.
+  bool begin(SensorTraceReader& reader);
+  bool step(SensorTraceReader& reader);
+
+  uint32_t getRecordCount() const { return _records; }
+  uint32_t getSkippedCount() const { return _skipped; }
+
+private:
+  Pulseoximeter* _pulseoximeter;
+  FallDetector* _fallDetector;
+  BloodPressureReader* _bpReader;
+  BPPulseDetector* _pulseDetector;
+
+  uint32_t _records;
+  uint32_t _skipped;
+
+  void dispatch(const TraceRecord& rec);
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "SensorTrace.h"
+#include <string.h>
+
+static const uint8_t TRACE_MAGIC[4] = { 'A', 'V', 'T', 'R' };
+static const uint8_t FIELD_COUNTS[TRACE_CHANNEL_COUNT] = { 2, 6, 1 };
+
+static inline uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t putVarint(uint8_t* out, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+SensorTraceWriter::SensorTraceWriter()
+  : _out(nullptr),
+    _hasTime(false),
+    _lastTimeUs(0),
+    _newestUs(0),
+    _pendingCount(0),
+    _records(0),
+    _bytes(0),
+    _dropped(0),
+    _clamped(0)
+{
+  memset(_last, 0, sizeof(_last));
+}
+
+uint8_t SensorTraceWriter::fieldCount(TraceChannel channel) {
+  return channel < TRACE_CHANNEL_COUNT ? FIELD_COUNTS[channel] : 0;
+}
+
+void SensorTraceWriter::begin(Print& out) {
+  _out = &out;
+  _hasTime = false;
+  _lastTimeUs = 0;
+  _pendingCount = 0;
+  _records = 0;
+  _dropped = 0;
+  _clamped = 0;
+  memset(_last, 0, sizeof(_last));
+
+  uint8_t header[4 + 2 + TRACE_CHANNEL_COUNT * 2];
+  size_t n = 0;
+  memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  n += sizeof(TRACE_MAGIC);
+  header[n++] = TRACE_VERSION;
+  header[n++] = TRACE_CHANNEL_COUNT;
+  for (uint8_t ch = 0; ch < TRACE_CHANNEL_COUNT; ch++) {
+    header[n++] = ch;
+    header[n++] = FIELD_COUNTS[ch];
+  }
+  _bytes = _out->write(header, n);
+}
+
+void SensorTraceWriter::end() {
+  if (!_out) return;
+  while (_pendingCount > 0) {
+    emitPending(oldestPending());
+  }
+  _out->flush();
+  _out = nullptr;
+}
+
+void SensorTraceWriter::record(TraceChannel channel, uint32_t timestampUs, const int32_t* values) {
+  if (!_out || channel >= TRACE_CHANNEL_COUNT) return;
+
+  if (_pendingCount == REORDER_CAPACITY) {
+    emitPending(oldestPending());
+  }
+  Pending& rec = _pending[_pendingCount++];
+  rec.channel = channel;
+  rec.timestampUs = timestampUs;
+  memcpy(rec.values, values, FIELD_COUNTS[channel] * sizeof(int32_t));
+
+  if (_pendingCount == 1 || before(_newestUs, timestampUs)) {
+    _newestUs = timestampUs;
+  }
+
+  // Lo que tenga más de REORDER_US respecto a lo último visto ya no puede
+  // quedar detrás de nada que esté por llegar
+  while (_pendingCount > 0) {
+    uint8_t oldest = oldestPending();
+    if (_newestUs - _pending[oldest].timestampUs < REORDER_US) break;
+    emitPending(oldest);
+  }
+}
+
+uint8_t SensorTraceWriter::oldestPending() const {
+  uint8_t oldest = 0;
+  for (uint8_t i = 1; i < _pendingCount; i++) {
+    if (before(_pending[i].timestampUs, _pending[oldest].timestampUs)) {
+      oldest = i;
+    }
+  }
+  return oldest;
+}
+
+void SensorTraceWriter::emitPending(uint8_t index) {
+  emit(_pending[index]);
+  _pending[index] = _pending[--_pendingCount];
+}
+
+void SensorTraceWriter::emit(const Pending& rec) {
+  uint8_t buf[MAX_RECORD_SIZE];
+  size_t n = 0;
+  buf[n++] = rec.channel;
+
+  // El primer registro lleva el tiempo absoluto (delta contra 0); uno que
+  // llegó tarde sale con el tiempo del anterior para no volver atrás
+  uint32_t timeUs = rec.timestampUs;
+  if (_hasTime && before(timeUs, _lastTimeUs)) {
+    timeUs = _lastTimeUs;
+    _clamped++;
+  }
+  int32_t dt = _hasTime ? (int32_t)(timeUs - _lastTimeUs) : (int32_t)timeUs;
+  n += putVarint(buf + n, zigzag(dt));
+
+  const int32_t* last = _last[rec.channel];
+  for (uint8_t i = 0; i < FIELD_COUNTS[rec.channel]; i++) {
+    int32_t delta = (int32_t)((uint32_t)rec.values[i] - (uint32_t)last[i]);
+    n += putVarint(buf + n, zigzag(delta));
+  }
+
+  // Si no cabe entero, el estado delta se queda como estaba y el
+  // siguiente registro se codifica contra el último que sí salió
+  if (_out->write(buf, n) != n) {
+    _dropped++;
+    return;
+  }
+
+  _lastTimeUs = timeUs;
+  _hasTime = true;
+  memcpy(_last[rec.channel], rec.values, FIELD_COUNTS[rec.channel] * sizeof(int32_t));
+  _bytes += n;
+  _records++;
+}
+
+size_t TraceBuffer::write(const uint8_t* buffer, size_t size) {
+  // Solo el productor llena, así que el hueco libre no puede encoger
+  if (SIZE - _bytes.size() < size) {
+    return 0;
+  }
+  for (size_t i = 0; i < size; i++) {
+    _bytes.push(buffer[i]);
+  }
+  return size;
+}
+
+size_t TraceBuffer::read(uint8_t* out, size_t max) {
+  size_t n = 0;
+  while (n < max && _bytes.pop(out[n])) {
+    n++;
+  }
+  return n;
+}
+
+SensorTraceReader::SensorTraceReader(TraceSource& in)
+  : _in(in),
+    _corrupt(false),
+    _hasTime(false),
+    _timeUs(0)
+{
+  memset(_fieldCounts, 0, sizeof(_fieldCounts));
+  memset(_last, 0, sizeof(_last));
+}
+
+bool SensorTraceReader::readVarint(uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    int c = _in.read();
+    if (c < 0) return false;
+    value |= (uint32_t)(c & 0x7F) << shift;
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+bool SensorTraceReader::begin() {
+  _corrupt = true;
+  _hasTime = false;
+  _timeUs = 0;
+  memset(_fieldCounts, 0, sizeof(_fieldCounts));
+  memset(_last, 0, sizeof(_last));
+
+  for (uint8_t i = 0; i < sizeof(TRACE_MAGIC); i++) {
+    if (_in.read() != TRACE_MAGIC[i]) return false;
+  }
+  if (_in.read() != TRACE_VERSION) return false;
+
+  int channels = _in.read();
+  if (channels <= 0 || channels > TRACE_MAX_CHANNELS) return false;
+
+  for (int i = 0; i < channels; i++) {
+    int id = _in.read();
+    int fields = _in.read();
+    if (id < 0 || id >= TRACE_MAX_CHANNELS || fields <= 0 || fields > TRACE_MAX_FIELDS) {
+      return false;
+    }
+    _fieldCounts[id] = (uint8_t)fields;
+  }
+
+  _corrupt = false;
+  return true;
+}
+
+bool SensorTraceReader::next(TraceRecord& rec) {
+  if (_corrupt) return false;
+
+  int ch = _in.read();
+  if (ch < 0) return false;   // fin limpio de la traza
+
+  _corrupt = true;
+  if (ch >= TRACE_MAX_CHANNELS || _fieldCounts[ch] == 0) return false;
+
+  uint32_t raw;
+  if (!readVarint(raw)) return false;
+  if (_hasTime) {
+    _timeUs += (int64_t)unzigzag(raw);
+  } else {
+    _timeUs = (uint32_t)unzigzag(raw);
+    _hasTime = true;
+  }
+
+  rec.channel = (uint8_t)ch;
+  rec.fieldCount = _fieldCounts[ch];
+  rec.timestampUs = _timeUs;
+
+  int32_t* last = _last[ch];
+  for (uint8_t i = 0; i < rec.fieldCount; i++) {
+    if (!readVarint(raw)) return false;
+    last[i] = (int32_t)((uint32_t)last[i] + (uint32_t)unzigzag(raw));
+    rec.values[i] = last[i];
+  }
+
+  _corrupt = false;
+  return true;
+}
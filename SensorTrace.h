@@ -0,0 +1,168 @@
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "SpscRing.h"
+
+// Traza binaria de muestras crudas para ajustar umbrales fuera del equipo.
+//
+//   cabecera: "AVTR" | versión u8 | nº canales u8 | { id u8, nº campos u8 }...
+//   registro: canal u8 | Δt µs | Δcampo...
+//
+// Δt y cada Δcampo son varint zigzag (1-5 bytes) respecto al registro
+// anterior: el tiempo contra cualquier canal (el primero lleva el tiempo
+// absoluto), los campos contra el último registro del mismo canal. El
+// escritor guarda solo los últimos valores, así que la RAM es fija.
+//
+// Cada muestra lleva el instante en que la tomó el sensor, en µs de
+// Clock::micros(). Los sensores se vacían por lotes y cada uno fecha su
+// lote hacia atrás, así que entre canales llegan desordenadas: el escritor
+// las retiene REORDER_US y las emite por orden de tiempo, de modo que en
+// la traza Δt nunca es negativo y la reproducción solo avanza el reloj.
+enum TraceChannel : uint8_t {
+  TRACE_PPG = 0,     // rojo, IR
+  TRACE_IMU = 1,     // ax, ay, az, gx, gy, gz (cuentas)
+  TRACE_HX711 = 2,   // cuentas
+  TRACE_CHANNEL_COUNT
+};
+
+static const uint8_t TRACE_VERSION = 1;
+static const uint8_t TRACE_MAX_FIELDS = 6;
+static const uint8_t TRACE_MAX_CHANNELS = 8;
+
+struct TraceRecord {
+  uint8_t channel;
+  uint8_t fieldCount;
+  uint64_t timestampUs;
+  int32_t values[TRACE_MAX_FIELDS];
+};
+
+class SensorTraceWriter {
+public:
+  SensorTraceWriter();
+
+  // Escribe la cabecera y reinicia el estado delta.
+  void begin(Print& out);
+  // Emite lo que quede retenido, en orden, y suelta la salida.
+  void end();
+  bool isActive() const { return _out != nullptr; }
+
+  // values debe tener tantos campos como el canal declara.
+  void record(TraceChannel channel, uint32_t timestampUs, const int32_t* values);
+
+  uint32_t getRecordCount() const { return _records; }
+  uint32_t getBytesWritten() const { return _bytes; }
+  // Registros que la salida no aceptó enteros; no rompen la traza porque
+  // el estado delta solo avanza con lo escrito
+  uint32_t getDropped() const { return _dropped; }
+  // Registros que llegaron más de REORDER_US tarde y salen con el tiempo
+  // del anterior
+  uint32_t getClamped() const { return _clamped; }
+
+  static uint8_t fieldCount(TraceChannel channel);
+
+  // Registro más largo posible: canal + Δt + 6 campos
+  static const size_t MAX_RECORD_SIZE = 1 + 5 + TRACE_MAX_FIELDS * 5;
+
+  // Lo más que un lote se fecha hacia atrás: varias pasadas de 10 ms
+  static const uint32_t REORDER_US = 50000;
+  // ~280 muestras/s entre los tres sensores caben de sobra en REORDER_US
+  static const uint8_t REORDER_CAPACITY = 32;
+
+private:
+  struct Pending {
+    uint8_t channel;
+    uint32_t timestampUs;
+    int32_t values[TRACE_MAX_FIELDS];
+  };
+
+  Print* _out;
+  bool _hasTime;
+  uint32_t _lastTimeUs;
+  uint32_t _newestUs;
+  int32_t _last[TRACE_CHANNEL_COUNT][TRACE_MAX_FIELDS];
+  Pending _pending[REORDER_CAPACITY];
+  uint8_t _pendingCount;
+  uint32_t _records;
+  uint32_t _bytes;
+  uint32_t _dropped;
+  uint32_t _clamped;
+
+  uint8_t oldestPending() const;
+  void emitPending(uint8_t index);
+  void emit(const Pending& rec);
+
+  static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+};
+
+// Cola de bytes entre el escritor, en la adquisición, y quien vuelca la
+// traza a su destino desde comunicaciones, para que la adquisición no
+// espere nunca a la flash ni comparta Serial con el log. Un registro entra
+// entero o no entra.
+class TraceBuffer : public Print {
+public:
+  // Productor
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+
+  // Consumidor: copia hasta max bytes y devuelve cuántos
+  size_t read(uint8_t* out, size_t max);
+  bool empty() const { return _bytes.empty(); }
+
+  static const size_t SIZE = 4096;
+
+private:
+  SpscRing<uint8_t, SIZE> _bytes;
+};
+
+// Origen de bytes para el lector; read() devuelve -1 al terminar.
+class TraceSource {
+public:
+  virtual ~TraceSource() {}
+  virtual int read() = 0;
+};
+
+// Serial o un fichero de LittleFS/SD.
+class StreamTraceSource : public TraceSource {
+public:
+  explicit StreamTraceSource(Stream& in) : _in(in) {}
+  int read() override { return _in.read(); }
+
+private:
+  Stream& _in;
+};
+
+class FileTraceSource : public TraceSource {
+public:
+  explicit FileTraceSource(FILE* in) : _in(in) {}
+  int read() override { return fgetc(_in); }
+
+private:
+  FILE* _in;
+};
+
+class SensorTraceReader {
+public:
+  explicit SensorTraceReader(TraceSource& in);
+
+  // Valida la cabecera. Los canales desconocidos se decodifican igual
+  // (con su nº de campos de la cabecera) para que el consumidor los ignore.
+  bool begin();
+
+  // false al final de la traza o si está corrupta (ver isCorrupt()).
+  bool next(TraceRecord& rec);
+  bool isCorrupt() const { return _corrupt; }
+
+private:
+  TraceSource& _in;
+  bool _corrupt;
+  bool _hasTime;
+  uint8_t _fieldCounts[TRACE_MAX_CHANNELS];
+  uint64_t _timeUs;
+  int32_t _last[TRACE_MAX_CHANNELS][TRACE_MAX_FIELDS];
+
+  bool readVarint(uint32_t& value);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// Seqlock de un solo escritor para un valor pequeño y copiable tal cual.
+// El escritor nunca espera; el lector copia el valor y repite si una
+// escritura se solapó con la copia (secuencia impar o cambiada). Nadie
+// retiene nunca un cerrojo, así que los lectores del otro núcleo no pueden
+// frenar al escritor.
+template <typename T>
+class SeqLock {
+public:
+  static const uint8_t DEFAULT_ATTEMPTS = 8;
+
+  SeqLock() : _seq(0), _value() {}
+
+  // Solo el escritor.
+  void write(const T& value) {
+    uint32_t seq = _seq.load(std::memory_order_relaxed);
+    _seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&_value, &value, sizeof(T));
+    _seq.store(seq + 2, std::memory_order_release);
+  }
+
+  // Cualquier lado. Se rinde tras `attempts` copias a medias y deja `out`
+  // sin especificar; si no, un escritor expulsado a mitad de escritura en
+  // el mismo núcleo que el lector lo dejaría girando para siempre.
+  bool read(T& out, uint8_t attempts = DEFAULT_ATTEMPTS) const {
+    for (uint8_t i = 0; i < attempts; i++) {
+      uint32_t before = _seq.load(std::memory_order_acquire);
+      if (before & 1) continue;
+      memcpy(&out, &_value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_seq.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+  }
+
+  // Escrituras completadas; el lector puede saltarse lo que ya ha visto.
+  uint32_t version() const { return _seq.load(std::memory_order_acquire) >> 1; }
+
+private:
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+  std::atomic<uint32_t> _seq;
+  T _value;
+};
+
+#endif
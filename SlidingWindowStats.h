@@ -0,0 +1,83 @@
+#ifndef SLIDING_WINDOW_STATS_H
+#define SLIDING_WINDOW_STATS_H
+
+#include "RingBuffer.h"
+
+// Máximo, mínimo y media de las últimas N muestras, sobre la marcha.
+// Máximo y mínimo salen de colas monótonas y la media de una suma móvil:
+// push() es O(1) amortizado y las consultas O(1).
+template <typename T, size_t N, typename SumT = T>
+class SlidingWindowStats {
+public:
+  void push(const T& value) {
+    // La muestra que sale de la ventana solo puede estar al frente de una cola
+    if (_values.isFull()) {
+      const T& evicted = _values.evictionCandidate();
+      _maxDeque.expire(evicted);
+      _minDeque.expire(evicted);
+    }
+    _values.push(value);
+    _maxDeque.push(value, true);
+    _minDeque.push(value, false);
+  }
+
+  void reset() {
+    _values.reset();
+    _maxDeque.reset();
+    _minDeque.reset();
+  }
+
+  size_t getCount() const { return _values.size(); }
+  bool isFull() const { return _values.isFull(); }
+
+  T getMax() const { return _maxDeque.front(); }
+  T getMin() const { return _minDeque.front(); }
+  SumT getSum() const { return _values.sum(); }
+  SumT getAverage() const { return _values.average(); }
+
+private:
+  // Valores monótonos (no crecientes para el máximo, no decrecientes para
+  // el mínimo): el frente es siempre el extremo de la ventana. Los iguales
+  // se conservan, así expire() reconoce la muestra que sale solo por valor.
+  class MonotonicDeque {
+  public:
+    MonotonicDeque() : _head(0), _len(0) {}
+
+    void push(const T& value, bool keepMax) {
+      while (_len > 0) {
+        const T& back = _items[(_head + _len - 1) & MASK];
+        if (keepMax ? !(back < value) : !(value < back)) break;
+        _len--;
+      }
+      _items[(_head + _len) & MASK] = value;
+      _len++;
+    }
+
+    void expire(const T& evicted) {
+      if (_len > 0 && _items[_head & MASK] == evicted) {
+        _head++;
+        _len--;
+      }
+    }
+
+    T front() const { return (_len > 0) ? _items[_head & MASK] : T(); }
+
+    void reset() {
+      _head = 0;
+      _len = 0;
+    }
+
+  private:
+    static const uint32_t MASK = RingBuffer<T, N>::STORAGE - 1;
+
+    T _items[RingBuffer<T, N>::STORAGE];
+    uint32_t _head;
+    uint32_t _len;
+  };
+
+  SummingRingBuffer<T, N, SumT> _values;
+  MonotonicDeque _maxDeque;
+  MonotonicDeque _minDeque;
+};
+
+#endif
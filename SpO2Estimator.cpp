@@ -0,0 +1,60 @@
+#include "SpO2Estimator.h"
+#include <math.h>
+
+SpO2Estimator::SpO2Estimator(uint16_t hop)
+  : _hop((hop >= 1) ? hop : 1),
+    _sinceLast(0),
+    _value(-1)
+{
+}
+
+void SpO2Estimator::setHop(uint16_t hop) {
+  _hop = (hop >= 1) ? hop : 1;
+}
+
+void SpO2Estimator::reset() {
+  _red.reset();
+  _ir.reset();
+  _sinceLast = 0;
+  _value = -1;
+}
+
+bool SpO2Estimator::push(long red, long ir) {
+  _red.push(red);
+  _ir.push(ir);
+  
+  // Sin ventana completa todavía no hay DC/AC fiables
+  if (!_ir.isFull()) return false;
+  
+  // La primera ventana completa publica siempre; luego cada `hop` muestras
+  if (_sinceLast != 0 && _sinceLast < _hop) {
+    _sinceLast++;
+    return false;
+  }
+  _sinceLast = 1;
+  
+  _value = compute(_red.getSum(), _ir.getSum(),
+                   _red.getMax() - _red.getMin(),
+                   _ir.getMax() - _ir.getMin(),
+                   WINDOW);
+  return true;
+}
+
+int SpO2Estimator::compute(long sumR, long sumIR, long acR, long acIR, size_t len) {
+  if (len == 0) return -1;
+
+  float dcR = (float)sumR / len;
+  float dcIR = (float)sumIR / len;
+  float acRf = (float)acR;
+  float acIRf = (float)acIR;
+
+  if (dcR <= 0.0f || dcIR <= 0.0f || acIRf <= 0.0f) return -1;
+
+  float ratio = (acRf / dcR) / (acIRf / dcIR);
+  float spo2 = 110.0f - 25.0f * ratio;
+
+  if (spo2 > 100.0f) spo2 = 100.0f;
+  if (spo2 < 0.0f) spo2 = 0.0f;
+
+  return (int)round(spo2);
+}
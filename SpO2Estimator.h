@@ -0,0 +1,37 @@
+#ifndef SPO2_ESTIMATOR_H
+#define SPO2_ESTIMATOR_H
+
+#include <Arduino.h>
+#include "SlidingWindowStats.h"
+
+// SpO2 por cociente de cocientes sobre las últimas WINDOW muestras rojo/IR,
+// sobre la marcha. La DC sale de sumas móviles y la AC de máximo/mínimo
+// deslizantes: cada muestra es O(1) y se puede publicar cada `hop` muestras.
+class SpO2Estimator {
+public:
+  static const size_t WINDOW = 100;
+
+  SpO2Estimator(uint16_t hop = 10);
+
+  // true si con esta muestra se ha publicado un SpO2 nuevo.
+  bool push(long red, long ir);
+  void reset();
+
+  void setHop(uint16_t hop);
+  uint16_t getHop() const { return _hop; }
+
+  int getValue() const { return _value; }
+  bool isReady() const { return _ir.isFull(); }
+
+  // La misma fórmula que el cálculo por lotes, con los agregados de la ventana.
+  static int compute(long sumR, long sumIR, long acR, long acIR, size_t len);
+
+private:
+  SlidingWindowStats<long, WINDOW, long> _red;
+  SlidingWindowStats<long, WINDOW, long> _ir;
+  uint16_t _hop;
+  uint16_t _sinceLast;
+  int _value;
+};
+
+#endif
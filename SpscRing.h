@@ -0,0 +1,77 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Anillo sin bloqueos para un único productor (p. ej. una ISR) y un único
+// consumidor. N debe ser potencia de dos; los índices corren libres y se
+// enmascaran al acceder.
+template <typename T, size_t N>
+class SpscRing {
+public:
+  SpscRing() : _head(0), _tail(0), _dropped(0) {}
+
+  // Lado productor. Nunca espera: si está lleno descarta el elemento y lo cuenta.
+  bool push(const T& item) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t tail = _tail.load(std::memory_order_acquire);
+    if (head - tail >= N) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _items[head & MASK] = item;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Lado consumidor.
+  bool pop(T& item) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t head = _head.load(std::memory_order_acquire);
+    if (head == tail) {
+      return false;
+    }
+    item = _items[tail & MASK];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Lado consumidor: mira el elemento más antiguo sin sacarlo.
+  bool peek(T& item) const {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t head = _head.load(std::memory_order_acquire);
+    if (head == tail) {
+      return false;
+    }
+    item = _items[tail & MASK];
+    return true;
+  }
+
+  // Solo el consumidor: descarta todo lo que haya en cola.
+  void clear() {
+    _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  size_t size() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  static constexpr size_t capacity() { return N; }
+
+private:
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+  static const uint32_t MASK = N - 1;
+
+  T _items[N];
+  std::atomic<uint32_t> _head;
+  std::atomic<uint32_t> _tail;
+  std::atomic<uint32_t> _dropped;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "TaskScheduler.h"
+
+TaskScheduler::TaskScheduler(ClockFn clock)
+  : _count(0),
+    _clock(clock ? clock : defaultClock),
+    _idleUs(0),
+    _busyUs(0),
+    _idleSinceUs(0),
+    _idle(false)
+{
+}
+
+int8_t TaskScheduler::addTask(const char* name, TaskFn fn, void* ctx, uint32_t periodUs, uint32_t budgetUs) {
+  if (_count >= MAX_TASKS || !fn || periodUs == 0) {
+    return -1;
+  }
+  
+  Task& task = _tasks[_count];
+  task.fn = fn;
+  task.ctx = ctx;
+  task.releaseUs = _clock();
+  task.stats.name = name;
+  task.stats.periodUs = periodUs;
+  task.stats.budgetUs = budgetUs;
+  task.stats.runs = 0;
+  task.stats.deadlineMisses = 0;
+  task.stats.budgetOverruns = 0;
+  task.stats.maxRunUs = 0;
+  
+  return (int8_t)_count++;
+}
+
+bool TaskScheduler::runOnce() {
+  uint32_t now = _clock();
+  
+  // Plazo más cercano primero entre las tareas ya liberadas
+  int8_t next = -1;
+  uint32_t nextDeadline = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    const Task& task = _tasks[i];
+    if (before(now, task.releaseUs)) continue;
+    
+    uint32_t deadline = task.releaseUs + task.stats.periodUs;
+    if (next < 0 || before(deadline, nextDeadline)) {
+      next = (int8_t)i;
+      nextDeadline = deadline;
+    }
+  }
+  
+  if (next < 0) {
+    if (!_idle) {
+      _idle = true;
+      _idleSinceUs = now;
+    }
+    return false;
+  }
+  
+  if (_idle) {
+    _idleUs += now - _idleSinceUs;
+    _idle = false;
+  }
+  
+  Task& task = _tasks[next];
+  uint32_t start = now;
+  task.fn(task.ctx);
+  uint32_t end = _clock();
+  
+  uint32_t runUs = end - start;
+  _busyUs += runUs;
+  task.stats.runs++;
+  if (runUs > task.stats.maxRunUs) task.stats.maxRunUs = runUs;
+  if (runUs > task.stats.budgetUs) task.stats.budgetOverruns++;
+  if (before(nextDeadline, end)) task.stats.deadlineMisses++;
+  
+  // La siguiente liberación es un periodo después; si la tarea se retrasó
+  // un periodo entero, se saltan las liberaciones atrasadas en vez de
+  // ejecutarla varias veces seguidas.
+  task.releaseUs += task.stats.periodUs;
+  if (before(task.releaseUs + task.stats.periodUs, end)) {
+    task.releaseUs = end;
+  }
+  
+  return true;
+}
+
+void TaskScheduler::resetStats() {
+  for (uint8_t i = 0; i < _count; i++) {
+    _tasks[i].stats.runs = 0;
+    _tasks[i].stats.deadlineMisses = 0;
+    _tasks[i].stats.budgetOverruns = 0;
+    _tasks[i].stats.maxRunUs = 0;
+  }
+  _idleUs = 0;
+  _busyUs = 0;
+  _idleSinceUs = _clock();
+}
+
+void TaskScheduler::getReport(Report& report) const {
+  report.count = _count;
+  for (uint8_t i = 0; i < _count; i++) {
+    report.tasks[i] = _tasks[i].stats;
+  }
+  report.busyUs = _busyUs;
+  report.idleUs = _idleUs;
+}
+
+void TaskScheduler::printStats(Print& out) const {
+  Report report;
+  getReport(report);
+  printReport(report, out);
+}
+
+void TaskScheduler::printReport(const Report& report, Print& out) {
+  out.println("Tarea      periodo  budget  ejec.  plazos perdidos  excesos  max(us)");
+  for (uint8_t i = 0; i < report.count; i++) {
+    const TaskStats& st = report.tasks[i];
+    out.printf("%-10s %7lu %7lu %6lu %16lu %8lu %8lu\n",
+               st.name, (unsigned long)st.periodUs, (unsigned long)st.budgetUs,
+               (unsigned long)st.runs, (unsigned long)st.deadlineMisses,
+               (unsigned long)st.budgetOverruns, (unsigned long)st.maxRunUs);
+  }
+  out.print("Ocupado (us): ");
+  out.print((unsigned long)report.busyUs);
+  out.print("  Ocioso (us): ");
+  out.println((unsigned long)report.idleUs);
+}
@@ -0,0 +1,79 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <Arduino.h>
+#include "Clock.h"
+
+// Planificador cooperativo estático. Cada tarea declara un periodo y un
+// presupuesto de peor caso; cada llamada a runOnce() ejecuta, de las tareas
+// liberadas, la de plazo más cercano (liberación + periodo). Se cuentan los
+// plazos incumplidos, los presupuestos excedidos y el tiempo ocioso. El
+// reloj se inyecta para poder moverlo con un tiempo virtual.
+class TaskScheduler {
+public:
+  typedef void (*TaskFn)(void* ctx);
+  typedef uint32_t (*ClockFn)();
+
+  static const uint8_t MAX_TASKS = 8;
+
+  struct TaskStats {
+    const char* name;
+    uint32_t periodUs;
+    uint32_t budgetUs;
+    uint32_t runs;
+    uint32_t deadlineMisses;
+    uint32_t budgetOverruns;
+    uint32_t maxRunUs;
+  };
+
+  // Copia de todas las estadísticas, para imprimirlas lejos del núcleo
+  // que ejecuta las tareas
+  struct Report {
+    TaskStats tasks[MAX_TASKS];
+    uint8_t count;
+    uint32_t busyUs;
+    uint32_t idleUs;
+  };
+
+  TaskScheduler(ClockFn clock = defaultClock);
+
+  // Devuelve el índice de la tarea, o -1 si la tabla está llena.
+  int8_t addTask(const char* name, TaskFn fn, void* ctx, uint32_t periodUs, uint32_t budgetUs);
+
+  // Ejecuta como mucho una tarea. false si no tocaba ninguna.
+  bool runOnce();
+
+  uint8_t getTaskCount() const { return _count; }
+  const TaskStats& getStats(uint8_t index) const { return _tasks[index].stats; }
+  uint32_t getIdleUs() const { return _idleUs; }
+  uint32_t getBusyUs() const { return _busyUs; }
+  void resetStats();
+  void getReport(Report& report) const;
+
+  void printStats(Print& out) const;
+  static void printReport(const Report& report, Print& out);
+
+  static uint32_t defaultClock() { return Clock::micros(); }
+
+private:
+  struct Task {
+    TaskFn fn;
+    void* ctx;
+    uint32_t releaseUs;
+    TaskStats stats;
+  };
+
+  Task _tasks[MAX_TASKS];
+  uint8_t _count;
+  ClockFn _clock;
+
+  uint32_t _idleUs;
+  uint32_t _busyUs;
+  uint32_t _idleSinceUs;
+  bool _idle;
+
+  // "a va antes que b" en contadores de microsegundos que desbordan.
+  static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+};
+
+#endif
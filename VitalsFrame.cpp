@@ -0,0 +1,70 @@
+#include "VitalsFrame.h"
+#include <string.h>
+
+static inline void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void putU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t encodeVitalsFrame(const VitalsFrame& frame, uint8_t* out, size_t len) {
+  size_t size = frame.type == VitalsFrame::VITALS ? VITALS_FRAME_VITALS_SIZE
+                                                  : VITALS_FRAME_HEADER_SIZE;
+  if (len < size) return 0;
+
+  out[0] = VITALS_FRAME_VERSION;
+  out[1] = frame.type;
+  putU16(out + 2, frame.sequence);
+  putU32(out + 4, frame.timestampMs);
+
+  if (frame.type == VitalsFrame::VITALS) {
+    out[8] = frame.bpm;
+    out[9] = frame.spo2;
+    putU16(out + 10, (uint16_t)frame.systolic);
+    putU16(out + 12, (uint16_t)frame.diastolic);
+    out[14] = frame.flags;
+  }
+  return size;
+}
+
+bool decodeVitalsFrame(const uint8_t* in, size_t len, VitalsFrame& frame) {
+  if (len < VITALS_FRAME_HEADER_SIZE || in[0] != VITALS_FRAME_VERSION) {
+    return false;
+  }
+
+  memset(&frame, 0, sizeof(frame));
+  frame.type = in[1];
+  frame.sequence = getU16(in + 2);
+  frame.timestampMs = getU32(in + 4);
+
+  switch (frame.type) {
+    case VitalsFrame::VITALS:
+      if (len < VITALS_FRAME_VITALS_SIZE) return false;
+      frame.bpm = in[8];
+      frame.spo2 = in[9];
+      frame.systolic = (int16_t)getU16(in + 10);
+      frame.diastolic = (int16_t)getU16(in + 12);
+      frame.flags = in[14];
+      return true;
+
+    case VitalsFrame::FALL_ALERT:
+      return true;
+
+    default:
+      return false;
+  }
+}
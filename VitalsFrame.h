@@ -0,0 +1,53 @@
+#ifndef VITALS_FRAME_H
+#define VITALS_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Trama binaria de signos vitales para BLE. Formato fijo, little-endian,
+// sin dependencias de Arduino para poder decodificarla en el host.
+//
+//   off  tam  campo
+//     0    1  versión (VITALS_FRAME_VERSION)
+//     1    1  tipo (VitalsFrame::Type)
+//     2    2  secuencia
+//     4    4  marca de tiempo (ms desde el arranque)
+//  -- solo VITALS --
+//     8    1  BPM (0-255, saturado)
+//     9    1  SpO2 % (0xFF = sin lectura)
+//    10    2  sistólica mmHg (int16)
+//    12    2  diastólica mmHg (int16)
+//    14    1  flags (VitalsFrame::Flags)
+//
+// 15 bytes de vitales y 8 de alerta de caída: caben en una notificación
+// con el MTU por defecto (23 → 20 bytes útiles).
+static const uint8_t VITALS_FRAME_VERSION = 1;
+static const size_t VITALS_FRAME_HEADER_SIZE = 8;
+static const size_t VITALS_FRAME_VITALS_SIZE = 15;
+static const size_t VITALS_FRAME_MAX_SIZE = VITALS_FRAME_VITALS_SIZE;
+static const uint8_t VITALS_FRAME_NO_SPO2 = 0xFF;
+
+struct VitalsFrame {
+  enum Type : uint8_t { VITALS = 0, FALL_ALERT = 1 };
+  enum Flags : uint8_t {
+    FLAG_ALERT = 0x01,      // fuera de rango (BPM o SpO2)
+    FLAG_BP_VALID = 0x02    // ya se detectaron pulsos de presión
+  };
+
+  uint8_t type;
+  uint16_t sequence;
+  uint32_t timestampMs;
+  uint8_t bpm;
+  uint8_t spo2;
+  int16_t systolic;
+  int16_t diastolic;
+  uint8_t flags;
+};
+
+// Devuelve los bytes escritos, o 0 si out no tiene espacio suficiente.
+size_t encodeVitalsFrame(const VitalsFrame& frame, uint8_t* out, size_t len);
+
+// Rechaza versiones desconocidas, tipos desconocidos y tramas cortas.
+bool decodeVitalsFrame(const uint8_t* in, size_t len, VitalsFrame& frame);
+
+#endif
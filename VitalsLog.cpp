@@ -0,0 +1,368 @@
+#include "VitalsLog.h"
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const size_t CRC_OFFSET = VitalsLog::RECORD_SIZE - 4;
+static const size_t SCAN_CHUNK = 16;   // registros por lectura al arrancar
+static const char SEGMENT_SUFFIX[] = ".seg";
+
+static inline void putU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Secuencia del registro, o 0 si está borrado, a medias o corrupto
+static uint32_t validSeq(const uint8_t* rec) {
+  uint32_t seq = getU32(rec);
+  if (seq == 0 || seq == 0xFFFFFFFF) return 0;
+  if (rec[4] > VitalsLog::MAX_PAYLOAD) return 0;
+  if (getU32(rec + CRC_OFFSET) != calibrationCrc32(rec, CRC_OFFSET)) return 0;
+  return seq;
+}
+
+FileLogStorage::FileLogStorage(const char* dir)
+  : _dir(dir),
+    _writeFile(nullptr),
+    _writeId(0),
+    _dirty(false),
+    _readFile(nullptr),
+    _readId(0)
+{
+}
+
+FileLogStorage::~FileLogStorage() {
+  closeReader();
+  if (_writeFile) fclose(_writeFile);
+}
+
+void FileLogStorage::pathOf(uint32_t id, char* path, size_t len) const {
+  snprintf(path, len, "%s/%08lx%s", _dir, (unsigned long)id, SEGMENT_SUFFIX);
+}
+
+bool FileLogStorage::begin() {
+  struct stat st;
+  if (stat(_dir, &st) == 0) return S_ISDIR(st.st_mode);
+  return mkdir(_dir, 0755) == 0;
+}
+
+size_t FileLogStorage::listSegments(uint32_t* ids, size_t max) {
+  DIR* dir = opendir(_dir);
+  if (!dir) return 0;
+
+  size_t count = 0;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    char* end;
+    unsigned long id = strtoul(entry->d_name, &end, 16);
+    if (end == entry->d_name || strcmp(end, SEGMENT_SUFFIX) != 0) continue;
+
+    // Inserción ordenada quedándose con los `max` mayores
+    if (count == max) {
+      if (max == 0 || id <= ids[0]) continue;
+      memmove(ids, ids + 1, (count - 1) * sizeof(uint32_t));
+      count--;
+    }
+    size_t i = count;
+    while (i > 0 && ids[i - 1] > id) {
+      ids[i] = ids[i - 1];
+      i--;
+    }
+    ids[i] = (uint32_t)id;
+    count++;
+  }
+  closedir(dir);
+  return count;
+}
+
+bool FileLogStorage::create(uint32_t id) {
+  if (_writeFile) {
+    fclose(_writeFile);
+    _writeFile = nullptr;
+  }
+  if (_readFile && _readId == id) closeReader();
+
+  char path[64];
+  pathOf(id, path, sizeof(path));
+  _writeFile = fopen(path, "wb");
+  if (!_writeFile) return false;
+  _writeId = id;
+  _dirty = false;
+  return true;
+}
+
+bool FileLogStorage::append(const void* data, size_t len) {
+  if (!_writeFile) return false;
+  _dirty = true;
+  return fwrite(data, 1, len, _writeFile) == len;
+}
+
+void FileLogStorage::flushWriter() {
+  if (_writeFile && _dirty) {
+    fflush(_writeFile);
+    _dirty = false;
+  }
+}
+
+bool FileLogStorage::sync() {
+  if (!_writeFile) return false;
+  flushWriter();
+  return fsync(fileno(_writeFile)) == 0;
+}
+
+size_t FileLogStorage::size(uint32_t id) {
+  // Lo que sigue en el buffer de stdio también cuenta
+  if (_writeFile && id == _writeId) flushWriter();
+
+  char path[64];
+  pathOf(id, path, sizeof(path));
+  struct stat st;
+  if (stat(path, &st) != 0) return 0;
+  return (size_t)st.st_size;
+}
+
+bool FileLogStorage::read(uint32_t id, size_t offset, void* data, size_t len) {
+  if (_writeFile && id == _writeId) flushWriter();
+
+  if (!_readFile || _readId != id) {
+    closeReader();
+    char path[64];
+    pathOf(id, path, sizeof(path));
+    _readFile = fopen(path, "rb");
+    if (!_readFile) return false;
+    _readId = id;
+  }
+  if (fseek(_readFile, (long)offset, SEEK_SET) != 0) return false;
+  return fread(data, 1, len, _readFile) == len;
+}
+
+bool FileLogStorage::remove(uint32_t id) {
+  if (_readFile && _readId == id) closeReader();
+
+  char path[64];
+  pathOf(id, path, sizeof(path));
+  return ::remove(path) == 0;
+}
+
+void FileLogStorage::closeReader() {
+  if (_readFile) {
+    fclose(_readFile);
+    _readFile = nullptr;
+  }
+}
+
+VitalsLog::VitalsLog(LogStorage& storage, uint32_t segmentRecords, uint8_t maxSegments,
+                     uint32_t syncInterval, CalibrationStore* cursorStore, const char* cursorKey)
+  : _storage(storage),
+    _cursorStore(cursorStore),
+    _cursorKey(cursorKey),
+    _segmentRecords(segmentRecords > 0 ? segmentRecords : 1),
+    _maxSegments(maxSegments < 2 ? 2 : (maxSegments > MAX_SEGMENTS ? MAX_SEGMENTS : maxSegments)),
+    _syncInterval(syncInterval > 0 ? syncInterval : 1),
+    _ready(false),
+    _segmentCount(0),
+    _segmentBroken(false),
+    _unsynced(0),
+    _nextSeq(1),
+    _readSeq(1),
+    _sentSeq(1),
+    _corruptSeq(0),
+    _savedSeq(0),
+    _overwritten(0),
+    _corrupt(0)
+{
+}
+
+uint32_t VitalsLog::lastValidSeq(uint32_t segment) {
+  uint32_t records = (uint32_t)(_storage.size(segment) / RECORD_SIZE);
+  uint32_t lastSeq = 0;
+  uint8_t chunk[SCAN_CHUNK * RECORD_SIZE];
+  for (uint32_t first = 0; first < records; first += SCAN_CHUNK) {
+    uint32_t count = records - first < SCAN_CHUNK ? records - first : SCAN_CHUNK;
+    if (!_storage.read(segment, (size_t)first * RECORD_SIZE, chunk, count * RECORD_SIZE)) break;
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t seq = validSeq(chunk + i * RECORD_SIZE);
+      if (seq != 0 && seq == segment + first + i) lastSeq = seq;
+    }
+  }
+  return lastSeq;
+}
+
+bool VitalsLog::begin() {
+  _ready = false;
+  _unsynced = 0;
+  _segmentBroken = false;
+  if (!_storage.begin()) return false;
+
+  _segmentCount = (uint8_t)_storage.listSegments(_segments, _maxSegments);
+
+  // El último registro válido está en el segmento más reciente que tenga
+  // alguno; los posteriores (vacíos o ilegibles) sobran
+  uint32_t lastSeq = 0;
+  while (_segmentCount > 0) {
+    uint32_t newest = _segments[_segmentCount - 1];
+    lastSeq = lastValidSeq(newest);
+    if (lastSeq != 0) break;
+    _storage.remove(newest);
+    _segmentCount--;
+  }
+  _nextSeq = lastSeq + 1;
+  _readSeq = _nextSeq;
+
+  // Se sigue siempre en un segmento nuevo
+  if (!openSegment()) return false;
+
+  uint32_t oldest = _segments[0];
+  uint32_t delivered = 0;
+  CursorRecord cursor;
+  if (_cursorStore && _cursorKey && loadCalibrationRecord(*_cursorStore, _cursorKey, cursor)) {
+    delivered = cursor.deliveredSeq;
+  }
+
+  // Un cursor por delante del registro es de un registro anterior
+  bool stale = delivered >= _nextSeq;
+  if (stale) delivered = _nextSeq - 1;
+
+  _readSeq = delivered + 1 > oldest ? delivered + 1 : oldest;
+  _sentSeq = _readSeq;
+  _savedSeq = delivered;
+  _ready = true;
+
+  if (stale) saveCursor();
+  return true;
+}
+
+bool VitalsLog::openSegment() {
+  // Lo que quede del segmento anterior, a flash antes de dejarlo
+  if (_unsynced > 0) _storage.sync();
+  if (!_storage.create(_nextSeq)) return false;
+  _segments[_segmentCount++] = _nextSeq;
+  _segmentBroken = false;
+  _unsynced = 0;
+
+  // Lleno: se borra el segmento más antiguo con lo que quedara sin entregar
+  if (_segmentCount > _maxSegments) {
+    _storage.remove(_segments[0]);
+    memmove(_segments, _segments + 1, (_segmentCount - 1) * sizeof(uint32_t));
+    _segmentCount--;
+  }
+  uint32_t oldest = _segments[0];
+  if (_readSeq < oldest) {
+    _overwritten += oldest - _readSeq;
+    _readSeq = oldest;
+  }
+  if (_sentSeq < oldest) _sentSeq = oldest;
+  return true;
+}
+
+bool VitalsLog::append(const uint8_t* payload, size_t len) {
+  if (!_ready || len > MAX_PAYLOAD) return false;
+
+  // create() deja a flash lo que quedara del segmento anterior
+  uint32_t current = _segments[_segmentCount - 1];
+  if (_segmentBroken || _nextSeq - current >= _segmentRecords) {
+    if (!openSegment()) return false;
+  }
+
+  uint8_t rec[RECORD_SIZE];
+  memset(rec, 0, sizeof(rec));
+  putU32(rec, _nextSeq);
+  rec[4] = (uint8_t)len;
+  memcpy(rec + 5, payload, len);
+  putU32(rec + CRC_OFFSET, calibrationCrc32(rec, CRC_OFFSET));
+
+  // Un registro a medias dejaría mal colocados los siguientes: la
+  // secuencia se reintenta al principio de otro segmento
+  if (!_storage.append(rec, sizeof(rec))) {
+    _segmentBroken = true;
+    return false;
+  }
+  _nextSeq++;
+
+  if (++_unsynced >= _syncInterval) {
+    return sync();
+  }
+  return true;
+}
+
+bool VitalsLog::sync() {
+  if (!_ready || _unsynced == 0) return true;
+  _unsynced = 0;
+  return _storage.sync();
+}
+
+bool VitalsLog::readRecord(uint32_t seq, uint8_t* payload, uint8_t& len) {
+  uint8_t i = _segmentCount;
+  while (i > 0 && _segments[i - 1] > seq) i--;
+  if (i == 0) return false;
+  uint32_t segment = _segments[i - 1];
+
+  uint8_t rec[RECORD_SIZE];
+  if (!_storage.read(segment, (size_t)(seq - segment) * RECORD_SIZE, rec, sizeof(rec))) return false;
+  if (validSeq(rec) != seq) return false;
+
+  len = rec[4];
+  memcpy(payload, rec + 5, len);
+  return true;
+}
+
+size_t VitalsLog::peekBatch(uint8_t* out, size_t maxLen, uint32_t& lastSeq) {
+  if (!_ready || maxLen < MIN_BATCH_SIZE) return 0;
+
+  size_t used = 0;
+  while (_sentSeq != _nextSeq) {
+    uint8_t payload[MAX_PAYLOAD];
+    uint8_t len;
+    if (!readRecord(_sentSeq, payload, len)) {
+      // Tras un rewind() se vuelve a pasar por él: se cuenta una vez
+      if (_sentSeq > _corruptSeq) {
+        _corrupt++;
+        _corruptSeq = _sentSeq;
+      }
+      // Sin nada pendiente delante, no hay nada que esperar para saltarlo
+      if (_readSeq == _sentSeq) _readSeq++;
+      _sentSeq++;
+      continue;
+    }
+    if (used + ENTRY_OVERHEAD + len > maxLen) break;
+
+    putU32(out + used, _sentSeq);
+    out[used + 4] = len;
+    memcpy(out + used + ENTRY_OVERHEAD, payload, len);
+    used += ENTRY_OVERHEAD + len;
+    _sentSeq++;
+  }
+  // Incluye los ilegibles saltados detrás del último empaquetado
+  if (used > 0) lastSeq = _sentSeq - 1;
+  return used;
+}
+
+void VitalsLog::commit(uint32_t lastSeq) {
+  // Solo lo ya enviado; lo pisado mientras tanto ya no cuenta
+  if (!_ready || lastSeq < _readSeq || lastSeq >= _sentSeq) return;
+  _readSeq = lastSeq + 1;
+
+  if (_readSeq - 1 - _savedSeq >= CURSOR_SAVE_INTERVAL ||
+      (_readSeq == _nextSeq && _savedSeq != _readSeq - 1)) {
+    saveCursor();
+  }
+}
+
+void VitalsLog::saveCursor() {
+  if (!_cursorStore || !_cursorKey) return;
+
+  CursorRecord cursor = {};
+  cursor.deliveredSeq = _readSeq - 1;
+  if (saveCalibrationRecord(*_cursorStore, _cursorKey, cursor)) {
+    _savedSeq = cursor.deliveredSeq;
+  }
+}
@@ -0,0 +1,163 @@
+#ifndef VITALS_LOG_H
+#define VITALS_LOG_H
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "CalibrationStore.h"
+
+// Almacenamiento del registro en segmentos de solo-añadir, identificados
+// por un número creciente (fichero en LittleFS en el equipo, fichero normal
+// en el host). Solo el segmento abierto con create() crece; los demás solo
+// se leen o se borran enteros, así que nunca se reescribe nada en su sitio.
+class LogStorage {
+public:
+  virtual ~LogStorage() {}
+
+  virtual bool begin() = 0;
+  // Los `max` segmentos más recientes, de menor a mayor; devuelve cuántos
+  virtual size_t listSegments(uint32_t* ids, size_t max) = 0;
+  // Crea (vacío) el segmento id y lo deja abierto para append()
+  virtual bool create(uint32_t id) = 0;
+  virtual bool append(const void* data, size_t len) = 0;
+  // Lo añadido queda en flash al volver (un corte de luz no lo pierde)
+  virtual bool sync() = 0;
+  virtual size_t size(uint32_t id) = 0;
+  virtual bool read(uint32_t id, size_t offset, void* data, size_t len) = 0;
+  virtual bool remove(uint32_t id) = 0;
+};
+
+// Un fichero por segmento en `dir` (dir/0000002a.seg). Con LittleFS
+// montado en /littlefs se accede por stdio igual que en el host.
+class FileLogStorage : public LogStorage {
+public:
+  explicit FileLogStorage(const char* dir);
+  ~FileLogStorage();
+
+  bool begin() override;
+  size_t listSegments(uint32_t* ids, size_t max) override;
+  bool create(uint32_t id) override;
+  bool append(const void* data, size_t len) override;
+  bool sync() override;
+  size_t size(uint32_t id) override;
+  bool read(uint32_t id, size_t offset, void* data, size_t len) override;
+  bool remove(uint32_t id) override;
+
+private:
+  const char* _dir;
+  FILE* _writeFile;
+  uint32_t _writeId;
+  bool _dirty;          // hay bytes en el buffer de stdio sin pasar al fichero
+  FILE* _readFile;
+  uint32_t _readId;
+
+  void pathOf(uint32_t id, char* path, size_t len) const;
+  void flushWriter();
+  void closeReader();
+};
+
+// Registro de tramas (VitalsFrame codificadas) para cuando no hay cliente
+// BLE, en segmentos de `segmentRecords` registros. Cada segmento se llama
+// como la secuencia de su primer registro; al llenarse se abre otro y, si
+// ya hay `maxSegments`, se borra el más antiguo entero. Cada arranque abre
+// un segmento nuevo, así que nunca se añade detrás de un registro que un
+// corte de luz dejara a medias.
+//
+//   registro (RECORD_SIZE bytes): secuencia u32 | longitud u8 |
+//                                 trama (relleno hasta 15) | CRC-32 u32
+//
+// La secuencia empieza en 1 y nunca vuelve atrás; el registro de secuencia
+// s vive en el segmento de mayor número ≤ s. Un registro a medio escribir
+// falla el CRC y se salta.
+//
+// append() sincroniza cada `syncInterval` registros: un corte de luz pierde
+// como mucho los que vayan desde el último sync().
+//
+// Empaquetar un lote no lo da por entregado: peekBatch() avanza solo la
+// posición de envío y commit() confirma lo que se sabe recibido. Si el
+// enlace cae antes, rewind() vuelve a lo último confirmado y se reenvía.
+//
+// Lo confirmado se recuerda en `cursorStore` cada CURSOR_SAVE_INTERVAL
+// registros: tras un reinicio se reenvían como mucho esos (el cliente los
+// reconoce por la secuencia).
+//
+//   lote: { secuencia u32 | longitud u8 | trama }... hasta llenar la
+//         notificación (con MTU 23 cabe justo un registro de vitales)
+class VitalsLog {
+public:
+  static const size_t RECORD_SIZE = 24;
+  static const size_t MAX_PAYLOAD = 15;
+  static const size_t ENTRY_OVERHEAD = 5;      // secuencia + longitud en el lote
+  static const size_t MIN_BATCH_SIZE = ENTRY_OVERHEAD + MAX_PAYLOAD;
+  static const uint32_t CURSOR_SAVE_INTERVAL = 64;
+  static const uint8_t MAX_SEGMENTS = 32;
+
+  VitalsLog(LogStorage& storage, uint32_t segmentRecords, uint8_t maxSegments,
+            uint32_t syncInterval, CalibrationStore* cursorStore = nullptr,
+            const char* cursorKey = nullptr);
+
+  // Busca el último registro válido y abre un segmento nuevo tras él.
+  bool begin();
+
+  // false si len > MAX_PAYLOAD o no se pudo grabar. Lleno, borra el
+  // segmento más antiguo.
+  bool append(const uint8_t* payload, size_t len);
+
+  // Pasa a flash lo añadido desde el último sync().
+  bool sync();
+
+  // Empaqueta en out los siguientes sin enviar que quepan, sin darlos por
+  // entregados; lastSeq es la secuencia del último. Devuelve 0 si no queda
+  // nada o maxLen < MIN_BATCH_SIZE.
+  size_t peekBatch(uint8_t* out, size_t maxLen, uint32_t& lastSeq);
+  // Da por entregado todo hasta lastSeq (incluida) y guarda el cursor.
+  void commit(uint32_t lastSeq);
+  // Lo enviado sin confirmar se vuelve a enviar.
+  void rewind() { _sentSeq = _readSeq; }
+
+  // Sin confirmar, enviado o no
+  uint32_t pending() const { return _nextSeq - _readSeq; }
+  // Registros que se conservan como mínimo
+  uint32_t capacity() const { return (uint32_t)(_maxSegments - 1) * _segmentRecords; }
+  uint32_t getOverwritten() const { return _overwritten; }
+  uint32_t getCorrupt() const { return _corrupt; }
+
+private:
+  struct CursorRecord {
+    static const uint32_t MAGIC = 0x4C474356;   // "VCGL"
+    static const uint16_t VERSION = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t deliveredSeq;
+    uint32_t crc;
+  };
+
+  LogStorage& _storage;
+  CalibrationStore* _cursorStore;
+  const char* _cursorKey;
+  uint32_t _segmentRecords;
+  uint8_t _maxSegments;
+  uint32_t _syncInterval;
+  bool _ready;
+
+  uint32_t _segments[MAX_SEGMENTS];   // de menor a mayor; el último es el abierto
+  uint8_t _segmentCount;
+  bool _segmentBroken;                // un append falló: seguir en otro segmento
+  uint32_t _unsynced;
+
+  uint32_t _nextSeq;      // la que llevará el próximo append
+  uint32_t _readSeq;      // la primera sin confirmar
+  uint32_t _sentSeq;      // la próxima a empaquetar (>= _readSeq)
+  uint32_t _corruptSeq;   // hasta aquí ya contados en _corrupt
+  uint32_t _savedSeq;     // última entregada que consta en cursorStore
+  uint32_t _overwritten;
+  uint32_t _corrupt;
+
+  uint32_t lastValidSeq(uint32_t segment);
+  bool openSegment();
+  bool readRecord(uint32_t seq, uint8_t* payload, uint8_t& len);
+  void saveCursor();
+};
+
+#endif
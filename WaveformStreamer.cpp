@@ -0,0 +1,109 @@
+#include "WaveformStreamer.h"
+
+static inline uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static size_t putVarint(uint8_t* out, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+static inline void putU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+WaveformStreamer::WaveformStreamer()
+  : _nextChannel(0),
+    _sequence(0),
+    _samplesSent(0),
+    _framesSent(0),
+    _bytesSent(0)
+{
+  for (uint8_t ch = 0; ch < WAVE_CHANNEL_COUNT; ch++) {
+    _nextIndex[ch] = 0;
+  }
+}
+
+void WaveformStreamer::push(WaveChannel channel, int32_t value, unsigned long timeMs) {
+  Sample sample;
+  sample.index = _nextIndex[channel]++;
+  sample.timeMs = (uint32_t)timeMs;
+  sample.value = value;
+  _queues[channel].push(sample);
+}
+
+void WaveformStreamer::discardPending() {
+  for (uint8_t ch = 0; ch < WAVE_CHANNEL_COUNT; ch++) {
+    _queues[ch].clear();
+  }
+}
+
+size_t WaveformStreamer::nextFrame(uint8_t* out, size_t maxLen, unsigned long nowMs) {
+  if (maxLen > MAX_FRAME_SIZE) maxLen = MAX_FRAME_SIZE;
+  if (maxLen < HEADER_SIZE + 5) return 0;
+
+  for (uint8_t i = 0; i < WAVE_CHANNEL_COUNT; i++) {
+    uint8_t ch = (_nextChannel + i) % WAVE_CHANNEL_COUNT;
+    Sample oldest;
+    if (!_queues[ch].peek(oldest)) continue;
+
+    // Esperar a tener un lote razonable, salvo que la muestra más antigua
+    // ya lleve FLUSH_MS esperando
+    if (_queues[ch].size() < MIN_BATCH && nowMs - oldest.timeMs < FLUSH_MS) continue;
+
+    size_t len = encodeFrame(ch, out, maxLen);
+    if (len == 0) continue;
+    _nextChannel = (ch + 1) % WAVE_CHANNEL_COUNT;
+    return len;
+  }
+  return 0;
+}
+
+size_t WaveformStreamer::encodeFrame(uint8_t channel, uint8_t* out, size_t maxLen) {
+  SpscRing<Sample, QUEUE_SIZE>& queue = _queues[channel];
+
+  Sample sample;
+  if (!queue.pop(sample)) {
+    return 0;
+  }
+
+  out[0] = FRAME_VERSION;
+  out[1] = (uint8_t)_sequence;
+  out[2] = (uint8_t)(_sequence >> 8);
+  out[3] = channel;
+  putU32(out + 5, sample.index);
+  putU32(out + 9, sample.timeMs);
+
+  size_t used = HEADER_SIZE;
+  used += putVarint(out + used, zigzag(sample.value));
+  uint8_t count = 1;
+
+  int32_t previous = sample.value;
+  uint32_t expected = sample.index + 1;
+
+  // Cortar la trama si no cabe otra muestra o si falta alguna (índice
+  // no consecutivo): la siguiente trama arranca con su propio índice.
+  while (count < 255 && used + 5 <= maxLen && queue.peek(sample) && sample.index == expected) {
+    if (!queue.pop(sample)) break;
+    used += putVarint(out + used, zigzag((int32_t)((uint32_t)sample.value - (uint32_t)previous)));
+    previous = sample.value;
+    expected++;
+    count++;
+  }
+
+  out[4] = count;
+  _sequence++;
+  _samplesSent += count;
+  _framesSent++;
+  _bytesSent += used;
+  return used;
+}
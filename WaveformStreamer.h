@@ -0,0 +1,70 @@
+#ifndef WAVEFORM_STREAMER_H
+#define WAVEFORM_STREAMER_H
+
+#include <Arduino.h>
+#include "SpscRing.h"
+
+// Curvas en bruto por BLE: IR del PPG (100 Hz) y presión del brazalete.
+// La adquisición encola muestras sin bloquear; comunicaciones las empaqueta
+// en tramas del tamaño del MTU negociado.
+//
+//   trama: versión u8 | secuencia u16 | canal u8 | nº muestras u8 |
+//          índice de la 1ª muestra u32 | tiempo de la 1ª muestra ms u32 |
+//          1ª muestra (varint zigzag) | Δ con la anterior (varint zigzag)...
+//
+// Todo little-endian. La secuencia es común a todas las tramas y delata
+// notificaciones perdidas; el índice es por canal y delata muestras que
+// la adquisición tuvo que descartar porque el enlace no daba abasto.
+enum WaveChannel : uint8_t {
+  WAVE_PPG = 0,        // IR, cuentas del ADC
+  WAVE_PRESSURE = 1,   // presión filtrada, décimas de mmHg
+  WAVE_CHANNEL_COUNT
+};
+
+class WaveformStreamer {
+public:
+  static const uint8_t FRAME_VERSION = 1;
+  static const size_t HEADER_SIZE = 13;
+  static const size_t MAX_FRAME_SIZE = 244;   // MTU 247 - 3 de cabecera ATT
+  static const size_t QUEUE_SIZE = 128;       // 1,28 s de PPG a 100 Hz
+  static const uint8_t MIN_BATCH = 32;
+  static const unsigned long FLUSH_MS = 250;  // espera máxima de la muestra más antigua
+
+  WaveformStreamer();
+
+  // Productor (adquisición). Si la cola del canal está llena la muestra
+  // se descarta y se cuenta; nunca espera al enlace.
+  void push(WaveChannel channel, int32_t value, unsigned long timeMs);
+
+  // Consumidor (comunicaciones). Construye como mucho una trama en out,
+  // turnándose entre canales. Devuelve 0 si todavía no toca enviar.
+  size_t nextFrame(uint8_t* out, size_t maxLen, unsigned long nowMs);
+
+  // Consumidor: sin cliente conectado se tira lo pendiente.
+  void discardPending();
+
+  uint32_t getDropped(WaveChannel channel) const { return _queues[channel].dropped(); }
+  uint32_t getSamplesSent() const { return _samplesSent; }
+  uint32_t getFramesSent() const { return _framesSent; }
+  uint32_t getBytesSent() const { return _bytesSent; }
+
+private:
+  struct Sample {
+    uint32_t index;
+    uint32_t timeMs;
+    int32_t value;
+  };
+
+  SpscRing<Sample, QUEUE_SIZE> _queues[WAVE_CHANNEL_COUNT];
+  uint32_t _nextIndex[WAVE_CHANNEL_COUNT];      // solo el productor
+  uint8_t _nextChannel;
+  uint16_t _sequence;
+
+  uint32_t _samplesSent;
+  uint32_t _framesSent;
+  uint32_t _bytesSent;
+
+  size_t encodeFrame(uint8_t channel, uint8_t* out, size_t maxLen);
+};
+
+#endif
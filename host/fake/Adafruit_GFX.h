@@ -0,0 +1,41 @@
+#ifndef FAKE_ADAFRUIT_GFX_H
+#define FAKE_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+// Adafruit_GFX reducido: cursor, tamaño de texto, rectángulos y mapas de
+// bits. Los caracteres ocupan la celda de 6x8 de la fuente clásica
+// escalada por el tamaño; el dibujo de cada glifo es sintético, solo tiene
+// que cambiar píxeles cuando cambia el texto.
+class Adafruit_GFX : public Print {
+public:
+  Adafruit_GFX(int16_t w, int16_t h);
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color);
+
+  void setCursor(int16_t x, int16_t y) { _cursorX = x; _cursorY = y; }
+  void setTextSize(uint8_t size) { _textSize = size > 0 ? size : 1; }
+  void setTextColor(uint16_t color) { _textColor = color; }
+  void setTextWrap(bool wrap) { _wrap = wrap; }
+  int16_t getCursorX() const { return _cursorX; }
+  int16_t getCursorY() const { return _cursorY; }
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+protected:
+  int16_t _width;
+  int16_t _height;
+  int16_t _cursorX;
+  int16_t _cursorY;
+  uint8_t _textSize;
+  uint16_t _textColor;
+  bool _wrap;
+};
+
+#endif
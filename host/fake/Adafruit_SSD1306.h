@@ -0,0 +1,38 @@
+#ifndef FAKE_ADAFRUIT_SSD1306_H
+#define FAKE_ADAFRUIT_SSD1306_H
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+// Búfer de 1 bit por píxel organizado en páginas de 8 filas, como el de la
+// librería. display() manda la pantalla entera por Wire, así el modelo del
+// bus ve el mismo tráfico que con el controlador real.
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+  Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi = &Wire, int8_t rstPin = -1,
+                   uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL);
+  ~Adafruit_SSD1306();
+
+  bool begin(uint8_t switchVcc = SSD1306_SWITCHCAPVCC, uint8_t i2cAddr = 0,
+             bool reset = true, bool periphBegin = true);
+  void display();
+  void clearDisplay();
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  bool getPixel(int16_t x, int16_t y) const;
+  uint8_t* getBuffer() { return _buffer; }
+
+private:
+  TwoWire* _wire;
+  uint8_t _address;
+  uint8_t* _buffer;
+};
+
+#endif
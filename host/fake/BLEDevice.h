@@ -0,0 +1,73 @@
+#ifndef FAKE_BLE_DEVICE_H
+#define FAKE_BLE_DEVICE_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+// Pila BLE del host. No hay radio: el estado de la conexión y la MTU del
+// cliente los fija la prueba con FakeHal::setBleConnected() y
+// FakeHal::setBlePeerMtu(), y cada característica cuenta lo que notifica.
+class BLECharacteristic {
+public:
+  static const uint32_t PROPERTY_READ = 1 << 0;
+  static const uint32_t PROPERTY_WRITE = 1 << 1;
+  static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+  static const uint32_t PROPERTY_INDICATE = 1 << 3;
+  static const uint32_t PROPERTY_WRITE_NR = 1 << 4;
+
+  BLECharacteristic(const char* uuid, uint32_t properties);
+
+  void setValue(uint8_t* data, size_t size);
+  void setValue(const std::string& value);
+  std::string getValue() const;
+  void notify(bool isNotification = true);
+
+  const std::string& getUUID() const { return _uuid; }
+  uint32_t getNotifyCount() const;
+  uint32_t getNotifyBytes() const;
+
+private:
+  std::string _uuid;
+  uint32_t _properties;
+  std::vector<uint8_t> _value;
+  uint32_t _notifies;
+  uint32_t _notifyBytes;
+};
+
+class BLEService {
+public:
+  explicit BLEService(const char* uuid) : _uuid(uuid) {}
+  BLECharacteristic* createCharacteristic(const char* uuid, uint32_t properties);
+  void start() {}
+
+private:
+  std::string _uuid;
+};
+
+class BLEServer {
+public:
+  BLEService* createService(const char* uuid);
+  uint32_t getConnectedCount();
+  uint16_t getPeerMTU(uint16_t connId);
+  uint16_t getConnId() { return 0; }
+  void startAdvertising() {}
+};
+
+class BLEAdvertising {
+public:
+  void addServiceUUID(const char* uuid) { (void)uuid; }
+  void start() {}
+};
+
+class BLEDevice {
+public:
+  static void init(const std::string& name);
+  static int setMTU(uint16_t mtu);
+  static uint16_t getMTU();
+  static BLEServer* createServer();
+  static BLEAdvertising* getAdvertising();
+  static void startAdvertising() {}
+};
+
+#endif
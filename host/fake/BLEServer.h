@@ -0,0 +1,6 @@
+#ifndef FAKE_BLE_SERVER_H
+#define FAKE_BLE_SERVER_H
+
+#include <BLEDevice.h>
+
+#endif
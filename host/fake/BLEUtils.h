@@ -0,0 +1,6 @@
+#ifndef FAKE_BLE_UTILS_H
+#define FAKE_BLE_UTILS_H
+
+#include <BLEDevice.h>
+
+#endif
@@ -0,0 +1,512 @@
+#include "FakeDevices.h"
+#include <MAX30105.h>
+#include <heartRate.h>
+#include <math.h>
+
+// ---------------------------------------------------------------------------
+// HX711
+
+FakeHx711::FakeHx711(uint8_t doutPin, uint8_t sckPin)
+  : _dout(doutPin), _sck(sckPin), _nextUs(FakeHal::nowMicros() + PERIOD_US),
+    _source(valueAt), _ready(false), _deferred(false), _pulses(0), _sckLevel(LOW),
+    _word(0), _conversions(0), _reads(0), _overwritten(0), _lastRead(0) {
+  FakeHal::drivePin(_dout, HIGH);
+  FakeHal::attachPin(_sck, this);
+  FakeHal::attachTimed(this);
+}
+
+FakeHx711::~FakeHx711() {
+  FakeHal::detachTimed(this);
+  FakeHal::attachPin(_sck, nullptr);
+}
+
+int32_t FakeHx711::valueAt(uint32_t index) {
+  // Recorre todo el rango con signo para que el signo también se pruebe
+  return (int32_t)((index * 104729UL) & 0xFFFFFFUL) - 0x800000L;
+}
+
+void FakeHx711::convert() {
+  if (_ready && _pulses == 0) _overwritten++;
+  _word = (uint32_t)_source(_conversions) & 0xFFFFFFUL;
+  _conversions++;
+  _ready = true;
+  _pulses = 0;
+  FakeHal::drivePin(_dout, LOW);
+}
+
+void FakeHx711::onTime(uint64_t nowUs) {
+  _nextUs += PERIOD_US;
+  if (_nextUs <= nowUs) _nextUs = nowUs + PERIOD_US;
+  if (_ready && _pulses > 0) {
+    _deferred = true;
+    return;
+  }
+  convert();
+}
+
+void FakeHx711::onPinWrite(uint8_t pin, uint8_t level) {
+  if (pin != _sck) return;
+  bool rising = _sckLevel == LOW && level == HIGH;
+  _sckLevel = level;
+  if (!rising || !_ready) return;
+
+  _pulses++;
+  if (_pulses <= 24) {
+    FakeHal::drivePin(_dout, (_word >> (24 - _pulses)) & 1 ? HIGH : LOW);
+    return;
+  }
+  if (_pulses == 25) {
+    _reads++;
+    _lastRead = (int32_t)(_word << 8) >> 8;
+    FakeHal::drivePin(_dout, HIGH);
+    return;
+  }
+  if (_pulses == 27) {
+    _ready = false;
+    _pulses = 0;
+    if (_deferred) {
+      _deferred = false;
+      convert();
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// MPU6050
+
+#define MPU_SMPLRT_DIV   0x19
+#define MPU_CONFIG       0x1A
+#define MPU_ACCEL_CONFIG 0x1C
+#define MPU_FF_THR       0x1D
+#define MPU_FF_DUR       0x1E
+#define MPU_MOT_THR      0x1F
+#define MPU_MOT_DUR      0x20
+#define MPU_FIFO_EN      0x23
+#define MPU_INT_PIN_CFG  0x37
+#define MPU_INT_ENABLE   0x38
+#define MPU_INT_STATUS   0x3A
+#define MPU_ACCEL_XOUT_H 0x3B
+#define MPU_USER_CTRL    0x6A
+#define MPU_PWR_MGMT_1   0x6B
+#define MPU_PWR_MGMT_2   0x6C
+#define MPU_FIFO_COUNT_H 0x72
+#define MPU_FIFO_COUNT_L 0x73
+#define MPU_FIFO_R_W     0x74
+#define MPU_WHO_AM_I     0x75
+
+static const double ACCEL_LSB_PER_G = 16384.0;
+static const double GYRO_LSB_PER_DPS = 131.0;
+static const size_t MPU_FIFO_SIZE = 1024;
+
+FakeMpu6050::FakeMpu6050(int8_t intPin, uint8_t address)
+  : _intPin(intPin), _address(address), _pointer(0), _motion(atRest), _nextUs(0),
+    _ffMs(0), _motMs(0), _samples(0), _fifoBytesRead(0), _fifoLost(0),
+    _freefallEvents(0), _motionEvents(0) {
+  memset(_regs, 0, sizeof(_regs));
+  _regs[MPU_PWR_MGMT_1] = 0x40;   // arranca dormido
+  _regs[MPU_WHO_AM_I] = 0x68;
+  for (uint8_t i = 0; i < 3; i++) {
+    _hpfIn[i] = 0;
+    _hpfOut[i] = 0;
+    _held[i] = 0;
+  }
+  FakeHal::attachI2c(_address, this);
+  FakeHal::attachTimed(this);
+  if (_intPin >= 0) FakeHal::drivePin((uint8_t)_intPin, LOW);
+}
+
+FakeMpu6050::~FakeMpu6050() {
+  FakeHal::detachTimed(this);
+  FakeHal::detachI2c(_address);
+}
+
+MotionSample FakeMpu6050::atRest(double t) {
+  // Plano y quieto, con un poco de ruido determinista
+  double n = sin(t * 377.0) * 0.004;
+  MotionSample s = { n, -n, 1.0 + n, 0.0, 0.0, 0.0 };
+  return s;
+}
+
+bool FakeMpu6050::isCycling() const {
+  return (_regs[MPU_PWR_MGMT_1] & 0x20) && !(_regs[MPU_PWR_MGMT_1] & 0x40);
+}
+
+uint32_t FakeMpu6050::periodUs() const {
+  if (isCycling()) {
+    static const uint32_t WAKE_HZ[4] = { 1, 5, 20, 40 };   // 1,25 Hz redondeado
+    return 1000000UL / WAKE_HZ[_regs[MPU_PWR_MGMT_2] >> 6];
+  }
+  // Con DLPF el reloj de muestreo es 1 kHz; sin él, 8 kHz
+  uint32_t base = (_regs[MPU_CONFIG] & 0x07) ? 1000 : 8000;
+  return 1000000UL * (1 + _regs[MPU_SMPLRT_DIV]) / base;
+}
+
+uint64_t FakeMpu6050::nextEventUs() const {
+  if (_regs[MPU_PWR_MGMT_1] & 0x40) return UINT64_MAX;
+  return _nextUs;
+}
+
+void FakeMpu6050::onTime(uint64_t nowUs) {
+  sample(nowUs);
+  _nextUs = nowUs + periodUs();
+}
+
+static void putWord(uint8_t* p, int16_t v) {
+  p[0] = (uint8_t)((uint16_t)v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static int16_t clampCounts(double v) {
+  if (v > 32767.0) return 32767;
+  if (v < -32768.0) return -32768;
+  return (int16_t)lround(v);
+}
+
+void FakeMpu6050::sample(uint64_t nowUs) {
+  MotionSample m = _motion(nowUs / 1e6);
+  int16_t accel[3] = {
+    clampCounts(m.ax * ACCEL_LSB_PER_G),
+    clampCounts(m.ay * ACCEL_LSB_PER_G),
+    clampCounts(m.az * ACCEL_LSB_PER_G)
+  };
+  int16_t gyro[3] = {
+    clampCounts(m.gx * GYRO_LSB_PER_DPS),
+    clampCounts(m.gy * GYRO_LSB_PER_DPS),
+    clampCounts(m.gz * GYRO_LSB_PER_DPS)
+  };
+
+  for (uint8_t i = 0; i < 3; i++) putWord(&_regs[MPU_ACCEL_XOUT_H + 2 * i], accel[i]);
+  putWord(&_regs[0x41], 0);
+  for (uint8_t i = 0; i < 3; i++) putWord(&_regs[0x43 + 2 * i], gyro[i]);
+
+  if (isCycling()) {
+    detect(accel, periodUs() / 1000);
+    return;
+  }
+
+  uint8_t fifoEn = _regs[MPU_FIFO_EN];
+  if ((_regs[MPU_USER_CTRL] & 0x40) && fifoEn) {
+    uint8_t bytes[14];
+    size_t n = 0;
+    if (fifoEn & 0x08) { memcpy(bytes + n, &_regs[MPU_ACCEL_XOUT_H], 6); n += 6; }
+    if (fifoEn & 0x80) { memcpy(bytes + n, &_regs[0x41], 2); n += 2; }
+    if (fifoEn & 0x40) { memcpy(bytes + n, &_regs[0x43], 2); n += 2; }
+    if (fifoEn & 0x20) { memcpy(bytes + n, &_regs[0x45], 2); n += 2; }
+    if (fifoEn & 0x10) { memcpy(bytes + n, &_regs[0x47], 2); n += 2; }
+    for (size_t i = 0; i < n; i++) {
+      if (_fifo.size() >= MPU_FIFO_SIZE) {
+        _fifo.pop_front();
+        _fifoLost++;
+      }
+      _fifo.push_back(bytes[i]);
+    }
+    _samples++;
+  }
+  detect(accel, periodUs() / 1000);
+  raise(0x01);
+}
+
+void FakeMpu6050::detect(const int16_t* accel, uint32_t periodMs) {
+  // Salida del DHPF según ACCEL_HPF (ACCEL_CONFIG[2:0])
+  uint8_t hpf = _regs[MPU_ACCEL_CONFIG] & 0x07;
+  double filtered[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    double in = accel[i];
+    if (hpf == 0) {
+      filtered[i] = in;
+    } else if (hpf == 7) {
+      filtered[i] = in - _held[i];
+    } else {
+      static const double CUTOFF_HZ[5] = { 0, 5.0, 2.5, 1.25, 0.63 };
+      double cutoff = hpf < 5 ? CUTOFF_HZ[hpf] : 5.0;
+      double rc = 1.0 / (2 * PI * cutoff);
+      double dt = periodMs / 1000.0;
+      double alpha = rc / (rc + dt);
+      _hpfOut[i] = alpha * (_hpfOut[i] + in - _hpfIn[i]);
+      filtered[i] = _hpfOut[i];
+    }
+    _hpfIn[i] = in;
+  }
+
+  // Umbrales en LSB de 2 mg → cuentas a ±2 g (8 cuentas por LSB)
+  double ffThr = _regs[MPU_FF_THR] * 2e-3 * ACCEL_LSB_PER_G;
+  double motThr = _regs[MPU_MOT_THR] * 2e-3 * ACCEL_LSB_PER_G;
+  bool ff = ffThr > 0;
+  bool mot = false;
+  for (uint8_t i = 0; i < 3; i++) {
+    if (fabs(filtered[i]) >= ffThr) ff = false;
+    if (motThr > 0 && fabs(filtered[i]) > motThr) mot = true;
+  }
+
+  _ffMs = ff ? _ffMs + periodMs : 0;
+  _motMs = mot ? _motMs + periodMs : 0;
+
+  uint8_t status = 0;
+  if (ff && _ffMs >= _regs[MPU_FF_DUR] && _ffMs - periodMs < _regs[MPU_FF_DUR]) {
+    status |= 0x80;
+    _freefallEvents++;
+  }
+  if (mot && _motMs >= _regs[MPU_MOT_DUR] && _motMs - periodMs < _regs[MPU_MOT_DUR]) {
+    status |= 0x40;
+    _motionEvents++;
+  }
+  if (status) raise(status);
+}
+
+void FakeMpu6050::raise(uint8_t status) {
+  _regs[MPU_INT_STATUS] |= status;
+  if (_intPin < 0 || !(_regs[MPU_INT_ENABLE] & status)) return;
+  // Pulso de 50 us (sin LATCH_INT_EN)
+  FakeHal::drivePin((uint8_t)_intPin, HIGH);
+  FakeHal::drivePin((uint8_t)_intPin, LOW);
+}
+
+void FakeMpu6050::writeRegister(uint8_t reg, uint8_t value) {
+  reg &= 0x7F;
+  if (reg == MPU_FIFO_R_W) return;
+  if (reg == MPU_PWR_MGMT_1 && (value & 0x80)) {
+    memset(_regs, 0, sizeof(_regs));
+    _regs[MPU_PWR_MGMT_1] = 0x40;
+    _regs[MPU_WHO_AM_I] = 0x68;
+    _fifo.clear();
+    return;
+  }
+  if (reg == MPU_USER_CTRL && (value & 0x04)) {
+    _fifo.clear();
+    value &= (uint8_t)~0x04;
+  }
+  if (reg == MPU_ACCEL_CONFIG && (value & 0x07) == 7) {
+    // Hold retiene la muestra actual como referencia
+    for (uint8_t i = 0; i < 3; i++) {
+      _held[i] = (int16_t)(_regs[MPU_ACCEL_XOUT_H + 2 * i] << 8 | _regs[MPU_ACCEL_XOUT_H + 2 * i + 1]);
+    }
+  }
+  bool wasAsleep = _regs[MPU_PWR_MGMT_1] & 0x40;
+  bool wasCycling = isCycling();
+  _regs[reg] = value;
+  if (reg == MPU_PWR_MGMT_1 || reg == MPU_PWR_MGMT_2 || reg == MPU_SMPLRT_DIV || reg == MPU_CONFIG) {
+    if (wasAsleep || wasCycling != isCycling() || reg == MPU_SMPLRT_DIV) {
+      _nextUs = FakeHal::nowMicros() + periodUs();
+    }
+    _ffMs = 0;
+    _motMs = 0;
+  }
+}
+
+uint8_t FakeMpu6050::readRegister(uint8_t reg) {
+  switch (reg) {
+    case MPU_FIFO_COUNT_H: return (uint8_t)(_fifo.size() >> 8);
+    case MPU_FIFO_COUNT_L: return (uint8_t)_fifo.size();
+    case MPU_FIFO_R_W: {
+      if (_fifo.empty()) return 0;
+      uint8_t b = _fifo.front();
+      _fifo.pop_front();
+      _fifoBytesRead++;
+      return b;
+    }
+    default: return _regs[reg & 0x7F];
+  }
+}
+
+void FakeMpu6050::onWrite(const uint8_t* data, size_t len) {
+  if (len == 0) return;
+  _pointer = data[0] & 0x7F;
+  for (size_t i = 1; i < len; i++) {
+    writeRegister(_pointer, data[i]);
+    if (_pointer != MPU_FIFO_R_W) _pointer = (_pointer + 1) & 0x7F;
+  }
+}
+
+size_t FakeMpu6050::onRead(uint8_t* data, size_t len) {
+  bool statusRead = false;
+  for (size_t i = 0; i < len; i++) {
+    if (_pointer == MPU_INT_STATUS) statusRead = true;
+    data[i] = readRegister(_pointer);
+    if (_pointer != MPU_FIFO_R_W) _pointer = (_pointer + 1) & 0x7F;
+  }
+  // INT_RD_CLEAR: cualquier lectura limpia el estado; si no, solo leerlo
+  if (statusRead || (_regs[MPU_INT_PIN_CFG] & 0x10)) _regs[MPU_INT_STATUS] = 0;
+  return len;
+}
+
+// ---------------------------------------------------------------------------
+// MAX30102
+
+FakeMax30102& FakeMax30102::instance() {
+  static FakeMax30102 sensor;
+  return sensor;
+}
+
+FakeMax30102::FakeMax30102() {
+  reset();
+}
+
+void FakeMax30102::reset() {
+  _periodUs = 0;
+  _nextUs = 0;
+  _fifo.clear();
+  _finger = true;
+  _bpm = 72.0;
+  _spo2 = 97.0;
+  _produced = 0;
+  _overflows = 0;
+  _libraryOverwrites = 0;
+}
+
+void FakeMax30102::configure(uint32_t samplePeriodUs) {
+  _periodUs = samplePeriodUs;
+  _fifo.clear();
+  _nextUs = FakeHal::nowMicros() + _periodUs;
+}
+
+void FakeMax30102::produceUntil(uint64_t nowUs) {
+  if (_periodUs == 0) return;
+  while (_nextUs <= nowUs) {
+    if (_fifo.size() >= FIFO_DEPTH) {
+      _fifo.pop_front();
+      _overflows++;
+    }
+    _fifo.push_back(_nextUs);
+    _produced++;
+    _nextUs += _periodUs;
+  }
+}
+
+uint8_t FakeMax30102::pending(uint64_t nowUs) {
+  produceUntil(nowUs);
+  return (uint8_t)_fifo.size();
+}
+
+void FakeMax30102::clear(uint64_t nowUs) {
+  produceUntil(nowUs);
+  _fifo.clear();
+}
+
+bool FakeMax30102::pop(uint32_t& red, uint32_t& ir) {
+  if (_fifo.empty()) return false;
+  double t = _fifo.front() / 1e6;
+  _fifo.pop_front();
+
+  if (!_finger) {
+    red = 1200;
+    ir = 1500;
+    return true;
+  }
+
+  // Pulso con subida rápida y bajada lenta; la fase va de 0 a 1 por latido
+  double phase = fmod(t * _bpm / 60.0, 1.0);
+  double pulse = phase < 0.15 ? phase / 0.15 : exp(-(phase - 0.15) * 5.0);
+
+  // SpO2 = 110 − 25·R, con R = (ACr/DCr) / (ACir/DCir)
+  double ratio = (110.0 - _spo2) / 25.0;
+  const double DC_IR = 120000.0, AC_IR = 1500.0, DC_RED = 100000.0;
+  double acRed = ratio * (AC_IR / DC_IR) * DC_RED;
+  ir = (uint32_t)(DC_IR + AC_IR * pulse);
+  red = (uint32_t)(DC_RED + acRed * pulse);
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Librería de SparkFun sobre el modelo
+
+MAX30105::MAX30105() {
+  memset(&sense, 0, sizeof(sense));
+}
+
+boolean MAX30105::begin(TwoWire& wirePort, uint32_t i2cSpeed, uint8_t i2caddr) {
+  (void)wirePort;
+  (void)i2cSpeed;
+  (void)i2caddr;
+  return true;
+}
+
+void MAX30105::setup(byte powerLevel, byte sampleAverage, byte ledMode, int sampleRate,
+                     int pulseWidth, int adcRange) {
+  (void)powerLevel;
+  (void)ledMode;
+  (void)pulseWidth;
+  (void)adcRange;
+  if (sampleAverage == 0) sampleAverage = 1;
+  FakeMax30102::instance().configure((uint32_t)(1000000UL * sampleAverage / sampleRate));
+  clearFIFO();
+}
+
+void MAX30105::clearFIFO() {
+  FakeMax30102::instance().clear(FakeHal::nowMicros());
+  sense.head = 0;
+  sense.tail = 0;
+}
+
+// Como la original: lee todo el FIFO del chip y avanza head por cada
+// muestra, aunque dé la vuelta al anillo y pise las no leídas
+uint16_t MAX30105::check() {
+  FakeMax30102& chip = FakeMax30102::instance();
+  uint8_t before = available();
+  uint16_t numberOfSamples = chip.pending(FakeHal::nowMicros());
+
+  uint32_t red, ir;
+  for (uint16_t i = 0; i < numberOfSamples && chip.pop(red, ir); i++) {
+    sense.head++;
+    sense.head %= STORAGE_SIZE;
+    sense.red[sense.head] = red;
+    sense.IR[sense.head] = ir;
+  }
+
+  uint16_t delivered = available();
+  for (uint16_t i = delivered; i < before + numberOfSamples; i++) chip.countLibraryOverwrite();
+  return numberOfSamples;
+}
+
+uint8_t MAX30105::available() {
+  int8_t numberOfSamples = sense.head - sense.tail;
+  if (numberOfSamples < 0) numberOfSamples += STORAGE_SIZE;
+  return (uint8_t)numberOfSamples;
+}
+
+void MAX30105::nextSample() {
+  if (available()) {
+    sense.tail++;
+    sense.tail %= STORAGE_SIZE;
+  }
+}
+
+uint32_t MAX30105::getFIFORed() {
+  return sense.red[sense.tail];
+}
+
+uint32_t MAX30105::getFIFOIR() {
+  return sense.IR[sense.tail];
+}
+
+uint32_t MAX30105::getRed() {
+  check();
+  return sense.red[sense.head];
+}
+
+uint32_t MAX30105::getIR() {
+  check();
+  return sense.IR[sense.head];
+}
+
+// ---------------------------------------------------------------------------
+// Detector de latidos
+
+bool checkForBeat(int32_t sample) {
+  static double dc = 0;
+  static double previous = 0;
+  static uint32_t sinceBeat = 0;
+  static const uint32_t REFRACTORY_SAMPLES = 25;
+
+  if (dc == 0) dc = sample;
+  dc += (sample - dc) / 32.0;
+  double ac = sample - dc;
+
+  bool beat = previous <= 0 && ac > 0 && sinceBeat >= REFRACTORY_SAMPLES;
+  previous = ac;
+  if (beat) {
+    sinceBeat = 0;
+  } else if (sinceBeat < REFRACTORY_SAMPLES) {
+    sinceBeat++;
+  }
+  return beat;
+}
@@ -0,0 +1,166 @@
+#ifndef FAKE_DEVICES_H
+#define FAKE_DEVICES_H
+
+#include "FakeHal.h"
+#include <stdint.h>
+#include <deque>
+#include <functional>
+
+// Modelos de los periféricos del equipo sobre el tiempo virtual de FakeHal.
+// Cada uno cuenta lo que produce y lo que el firmware llega a leer, así una
+// prueba puede comprobar que no se pierde nada.
+
+// HX711 a 80 SPS. DOUT baja cuando hay conversión; cada flanco de subida de
+// SCK saca un bit (MSB primero) y tras el 25.º DOUT vuelve a alto. Una
+// conversión nueva sin haber leído la anterior la sustituye y se cuenta
+// como perdida. La que termina a mitad de una lectura espera a que acabe.
+class FakeHx711 : public FakeHal::TimedDevice, public FakeHal::PinListener {
+public:
+  static const uint32_t PERIOD_US = 12500;
+
+  FakeHx711(uint8_t doutPin, uint8_t sckPin);
+  ~FakeHx711();
+
+  // Valor de la conversión n (24 bits con signo); por defecto una rampa
+  void setSource(std::function<int32_t(uint32_t)> source) { _source = source; }
+  static int32_t valueAt(uint32_t index);
+
+  uint32_t getConversions() const { return _conversions; }
+  uint32_t getReads() const { return _reads; }
+  uint32_t getOverwritten() const { return _overwritten; }
+  int32_t getLastRead() const { return _lastRead; }
+
+  uint64_t nextEventUs() const override { return _nextUs; }
+  void onTime(uint64_t nowUs) override;
+  void onPinWrite(uint8_t pin, uint8_t level) override;
+
+private:
+  uint8_t _dout;
+  uint8_t _sck;
+  uint64_t _nextUs;
+  std::function<int32_t(uint32_t)> _source;
+
+  bool _ready;        // conversión sin leer, DOUT bajo
+  bool _deferred;     // terminó otra durante una lectura
+  uint8_t _pulses;
+  uint8_t _sckLevel;
+  uint32_t _word;
+
+  uint32_t _conversions;
+  uint32_t _reads;
+  uint32_t _overwritten;
+  int32_t _lastRead;
+
+  void convert();
+};
+
+// Movimiento del portador: aceleración en g y giro en °/s en el instante t.
+struct MotionSample {
+  double ax, ay, az;
+  double gx, gy, gz;
+};
+typedef std::function<MotionSample(double)> MotionSource;
+
+// MPU6050 por registros: reloj de muestreo a 1 kHz / (1 + SMPLRT_DIV), FIFO
+// de 1024 bytes que pierde lo más antiguo al desbordar, pulso en INT por
+// dato listo, y modo ciclo de solo acelerómetro con los detectores de
+// caída libre y movimiento. Los detectores miran la salida del DHPF de
+// ACCEL_CONFIG: en reset es la aceleración tal cual, con un corte (5 Hz ...
+// 0,63 Hz) desaparece la gravedad y en hold es la diferencia con la muestra
+// retenida. Con INT_RD_CLEAR cualquier lectura borra INT_STATUS, pero
+// después de devolver los bytes pedidos.
+class FakeMpu6050 : public FakeHal::TimedDevice, public FakeHal::I2cDevice {
+public:
+  FakeMpu6050(int8_t intPin, uint8_t address = 0x68);
+  ~FakeMpu6050();
+
+  void setMotion(MotionSource source) { _motion = source; }
+  static MotionSample atRest(double t);
+
+  uint32_t getSamples() const { return _samples; }           // muestras al FIFO
+  uint32_t getFifoBytesRead() const { return _fifoBytesRead; }
+  uint32_t getFifoLost() const { return _fifoLost; }
+  uint32_t getFreefallEvents() const { return _freefallEvents; }
+  uint32_t getMotionEvents() const { return _motionEvents; }
+  bool isCycling() const;
+  uint8_t reg(uint8_t r) const { return _regs[r & 0x7F]; }
+
+  uint64_t nextEventUs() const override;
+  void onTime(uint64_t nowUs) override;
+  void onWrite(const uint8_t* data, size_t len) override;
+  size_t onRead(uint8_t* data, size_t len) override;
+
+private:
+  int8_t _intPin;
+  uint8_t _address;
+  uint8_t _regs[128];
+  uint8_t _pointer;
+  std::deque<uint8_t> _fifo;
+  MotionSource _motion;
+  uint64_t _nextUs;
+
+  double _hpfIn[3];
+  double _hpfOut[3];
+  double _held[3];
+  uint32_t _ffMs;
+  uint32_t _motMs;
+
+  uint32_t _samples;
+  uint32_t _fifoBytesRead;
+  uint32_t _fifoLost;
+  uint32_t _freefallEvents;
+  uint32_t _motionEvents;
+
+  uint32_t periodUs() const;
+  void writeRegister(uint8_t reg, uint8_t value);
+  uint8_t readRegister(uint8_t reg);
+  void sample(uint64_t nowUs);
+  void detect(const int16_t* accel, uint32_t periodMs);
+  void raise(uint8_t status);
+};
+
+// Sensor MAX30102: FIFO de 32 muestras rojo/IR a la cadencia de setup()
+// (400 Hz con promedio de 4 → 100 Hz), con desbordamiento por vuelta como
+// deja configurado la librería. La señal es un pulso sintético a `bpm` con
+// la relación rojo/IR que da `spo2` en la fórmula del firmware.
+class FakeMax30102 {
+public:
+  static const uint8_t FIFO_DEPTH = 32;
+
+  static FakeMax30102& instance();
+  void reset();
+
+  void setFinger(bool present) { _finger = present; }
+  void setHeartRate(double bpm) { _bpm = bpm; }
+  void setSpO2(double spo2) { _spo2 = spo2; }
+
+  // Para la librería falsa
+  void configure(uint32_t samplePeriodUs);
+  bool isConfigured() const { return _periodUs != 0; }
+  uint8_t pending(uint64_t nowUs);
+  bool pop(uint32_t& red, uint32_t& ir);
+  void clear(uint64_t nowUs);
+
+  uint32_t getProduced() const { return _produced; }
+  uint32_t getChipOverflows() const { return _overflows; }
+  // Las que la librería recibe y luego pisa en su anillo de 4
+  uint32_t getLibraryOverwrites() const { return _libraryOverwrites; }
+  void countLibraryOverwrite() { _libraryOverwrites++; }
+
+private:
+  FakeMax30102();
+  void produceUntil(uint64_t nowUs);
+
+  uint32_t _periodUs;
+  uint64_t _nextUs;
+  std::deque<uint64_t> _fifo;   // instante de cada muestra pendiente
+  bool _finger;
+  double _bpm;
+  double _spo2;
+
+  uint32_t _produced;
+  uint32_t _overflows;
+  uint32_t _libraryOverwrites;
+};
+
+#endif
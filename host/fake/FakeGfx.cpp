@@ -0,0 +1,112 @@
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include <stdlib.h>
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h)
+  : _width(w), _height(h), _cursorX(0), _cursorY(0), _textSize(1),
+    _textColor(1), _wrap(true) {
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  for (int16_t j = y; j < y + h; j++) {
+    for (int16_t i = x; i < x + w; i++) drawPixel(i, j, color);
+  }
+}
+
+void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h,
+                              uint16_t color) {
+  int16_t byteWidth = (w + 7) / 8;
+  for (int16_t j = 0; j < h; j++) {
+    for (int16_t i = 0; i < w; i++) {
+      if (bitmap[j * byteWidth + i / 8] & (0x80 >> (i & 7))) drawPixel(x + i, y + j, color);
+    }
+  }
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+  if (c == '\n') {
+    _cursorX = 0;
+    _cursorY += 8 * _textSize;
+    return 1;
+  }
+  if (c == '\r') return 1;
+
+  if (_wrap && _cursorX + 6 * _textSize > _width) {
+    _cursorX = 0;
+    _cursorY += 8 * _textSize;
+  }
+  // Glifo sintético de 5x7: cada columna sale del código del carácter
+  for (int16_t col = 0; col < 5; col++) {
+    uint8_t bits = c == ' ' ? 0 : (uint8_t)((c * 37 + col * 11) | 0x01) & 0x7F;
+    for (int16_t row = 0; row < 7; row++) {
+      if (bits & (1 << row)) {
+        fillRect(_cursorX + col * _textSize, _cursorY + row * _textSize, _textSize, _textSize, _textColor);
+      }
+    }
+  }
+  _cursorX += 6 * _textSize;
+  return 1;
+}
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t rstPin,
+                                   uint32_t clkDuring, uint32_t clkAfter)
+  : Adafruit_GFX(w, h), _wire(twi), _address(0), _buffer(nullptr) {
+  (void)rstPin;
+  (void)clkDuring;
+  (void)clkAfter;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+  free(_buffer);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t switchVcc, uint8_t i2cAddr, bool reset, bool periphBegin) {
+  (void)switchVcc;
+  (void)reset;
+  (void)periphBegin;
+  if (!_buffer) _buffer = (uint8_t*)malloc((size_t)_width * ((_height + 7) / 8));
+  if (!_buffer) return false;
+  _address = i2cAddr;
+  clearDisplay();
+  return true;
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+  if (_buffer) memset(_buffer, 0, (size_t)_width * ((_height + 7) / 8));
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (!_buffer || x < 0 || y < 0 || x >= _width || y >= _height) return;
+  uint8_t& b = _buffer[x + (y / 8) * _width];
+  uint8_t mask = (uint8_t)(1 << (y & 7));
+  switch (color) {
+    case SSD1306_WHITE: b |= mask; break;
+    case SSD1306_BLACK: b &= (uint8_t)~mask; break;
+    case SSD1306_INVERSE: b ^= mask; break;
+  }
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) const {
+  if (!_buffer || x < 0 || y < 0 || x >= _width || y >= _height) return false;
+  return _buffer[x + (y / 8) * _width] & (1 << (y & 7));
+}
+
+void Adafruit_SSD1306::display() {
+  size_t size = (size_t)_width * ((_height + 7) / 8);
+  _wire->beginTransmission(_address);
+  _wire->write((uint8_t)0x00);
+  _wire->write((uint8_t)SSD1306_PAGEADDR);
+  _wire->write((uint8_t)0);
+  _wire->write((uint8_t)0xFF);
+  _wire->write((uint8_t)SSD1306_COLUMNADDR);
+  _wire->write((uint8_t)0);
+  _wire->write((uint8_t)(_width - 1));
+  _wire->endTransmission();
+  for (size_t i = 0; i < size; i += 31) {
+    size_t n = size - i < 31 ? size - i : 31;
+    _wire->beginTransmission(_address);
+    _wire->write((uint8_t)0x40);
+    _wire->write(_buffer + i, n);
+    _wire->endTransmission();
+  }
+}
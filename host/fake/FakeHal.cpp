@@ -0,0 +1,616 @@
+#include "FakeHal.h"
+#include <Wire.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <BLEDevice.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire;
+LittleFSFS LittleFS;
+
+// ---------------------------------------------------------------------------
+// Tiempo virtual
+
+namespace {
+  std::atomic<uint64_t> nowUs(0);
+  std::vector<FakeHal::TimedDevice*> timedDevices;
+  int advancing = 0;
+
+  struct PinState {
+    uint8_t level = LOW;
+    FakeHal::PinListener* listener = nullptr;
+    void (*isr)(void*) = nullptr;
+    void (*isrNoArg)(void) = nullptr;
+    void* arg = nullptr;
+    int mode = 0;
+    bool pending = false;
+    uint32_t interrupts = 0;
+  };
+  PinState pins[64];
+  bool isrRunning = false;
+
+  FakeHal::I2cDevice* i2cDevices[128];
+  std::atomic<uint32_t> i2cByteCount(0);
+
+  std::mutex serialMutex;
+  std::deque<char> serialIn;
+  bool serialCapture = false;
+  std::string serialOut;
+
+  std::atomic<bool> bleConnected(false);
+  std::atomic<uint16_t> blePeerMtu(23);
+  std::mutex bleMutex;
+  std::vector<BLECharacteristic*> bleCharacteristics;
+
+  std::map<std::string, std::vector<uint8_t>> nvs;
+
+  void runIsr(uint8_t pin) {
+    PinState& p = pins[pin];
+    p.interrupts++;
+    isrRunning = true;
+    if (p.isr) p.isr(p.arg);
+    else if (p.isrNoArg) p.isrNoArg();
+    isrRunning = false;
+  }
+
+  // Atiende los flancos que quedaron pendientes durante una ISR
+  void servicePending() {
+    bool again = true;
+    while (again) {
+      again = false;
+      for (uint8_t pin = 0; pin < 64; pin++) {
+        if (pins[pin].pending) {
+          pins[pin].pending = false;
+          runIsr(pin);
+          again = true;
+        }
+      }
+    }
+  }
+
+  void edge(uint8_t pin, uint8_t from, uint8_t to) {
+    PinState& p = pins[pin];
+    if (!p.isr && !p.isrNoArg) return;
+    bool rising = from == LOW && to == HIGH;
+    bool falling = from == HIGH && to == LOW;
+    bool match = (p.mode == CHANGE && (rising || falling)) ||
+                 (p.mode == RISING && rising) ||
+                 (p.mode == FALLING && falling);
+    if (!match) return;
+    if (isrRunning) {
+      p.pending = true;
+      return;
+    }
+    runIsr(pin);
+    servicePending();
+  }
+}
+
+namespace FakeHal {
+
+void reset() {
+  nowUs.store(0);
+  timedDevices.clear();
+  advancing = 0;
+  for (uint8_t i = 0; i < 64; i++) pins[i] = PinState();
+  isrRunning = false;
+  for (uint8_t i = 0; i < 128; i++) i2cDevices[i] = nullptr;
+  i2cByteCount.store(0);
+  {
+    std::lock_guard<std::mutex> lock(serialMutex);
+    serialIn.clear();
+    serialOut.clear();
+    serialCapture = false;
+  }
+  bleConnected.store(false);
+  blePeerMtu.store(23);
+  nvs.clear();
+}
+
+uint64_t nowMicros() {
+  return nowUs.load(std::memory_order_relaxed);
+}
+
+void advanceMicros(uint64_t us) {
+  uint64_t target = nowUs.load() + us;
+  // Una ISR que espera dentro de un evento solo mueve el reloj; los eventos
+  // que venzan mientras tanto los atiende el bucle de fuera
+  if (advancing > 0) {
+    nowUs.store(target);
+    return;
+  }
+
+  advancing++;
+  for (;;) {
+    TimedDevice* next = nullptr;
+    uint64_t when = UINT64_MAX;
+    for (TimedDevice* d : timedDevices) {
+      uint64_t t = d->nextEventUs();
+      if (t < when) {
+        when = t;
+        next = d;
+      }
+    }
+    if (!next || when > target) break;
+    if (when > nowUs.load()) nowUs.store(when);
+    next->onTime(nowUs.load());
+    // Lo que una ISR haya esperado puede pasar del objetivo
+    if (nowUs.load() > target) target = nowUs.load();
+  }
+  nowUs.store(target);
+  advancing--;
+}
+
+void attachTimed(TimedDevice* device) {
+  timedDevices.push_back(device);
+}
+
+void detachTimed(TimedDevice* device) {
+  for (size_t i = 0; i < timedDevices.size(); i++) {
+    if (timedDevices[i] == device) {
+      timedDevices.erase(timedDevices.begin() + i);
+      return;
+    }
+  }
+}
+
+void attachPin(uint8_t pin, PinListener* listener) {
+  pins[pin].listener = listener;
+}
+
+void drivePin(uint8_t pin, uint8_t level) {
+  uint8_t old = pins[pin].level;
+  pins[pin].level = level ? HIGH : LOW;
+  if (old != pins[pin].level) edge(pin, old, pins[pin].level);
+}
+
+uint8_t pinLevel(uint8_t pin) {
+  return pins[pin].level;
+}
+
+uint32_t interruptCount(uint8_t pin) {
+  return pins[pin].interrupts;
+}
+
+bool inInterrupt() {
+  return isrRunning;
+}
+
+void attachI2c(uint8_t address, I2cDevice* device) {
+  i2cDevices[address & 0x7F] = device;
+}
+
+void detachI2c(uint8_t address) {
+  i2cDevices[address & 0x7F] = nullptr;
+}
+
+I2cDevice* i2cDevice(uint8_t address) {
+  return i2cDevices[address & 0x7F];
+}
+
+uint32_t i2cBytes() {
+  return i2cByteCount.load();
+}
+
+void serialInput(const char* text) {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  while (*text) serialIn.push_back(*text++);
+}
+
+void captureSerial(bool enabled) {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  serialCapture = enabled;
+}
+
+std::string takeSerialOutput() {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  std::string out;
+  out.swap(serialOut);
+  return out;
+}
+
+void setBleConnected(bool connected) {
+  bleConnected.store(connected);
+}
+
+void setBlePeerMtu(uint16_t mtu) {
+  blePeerMtu.store(mtu);
+}
+
+BLECharacteristic* bleCharacteristic(const char* uuid) {
+  // La más reciente: cada init() del firmware crea las suyas
+  std::lock_guard<std::mutex> lock(bleMutex);
+  for (size_t i = bleCharacteristics.size(); i > 0; i--) {
+    if (bleCharacteristics[i - 1]->getUUID() == uuid) return bleCharacteristics[i - 1];
+  }
+  return nullptr;
+}
+
+}
+
+unsigned long millis() {
+  return (unsigned long)(FakeHal::nowMicros() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)FakeHal::nowMicros();
+}
+
+void delay(uint32_t ms) {
+  FakeHal::advanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+  FakeHal::advanceMicros(us);
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server) {
+  (void)gmtOffsetSec;
+  (void)daylightOffsetSec;
+  (void)server;
+}
+
+// ---------------------------------------------------------------------------
+// GPIO
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (mode == INPUT_PULLUP && !pins[pin].listener) pins[pin].level = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  uint8_t level = val ? HIGH : LOW;
+  uint8_t old = pins[pin].level;
+  pins[pin].level = level;
+  if (pins[pin].listener) pins[pin].listener->onPinWrite(pin, level);
+  if (old != level) edge(pin, old, level);
+}
+
+int digitalRead(uint8_t pin) {
+  return pins[pin].level;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  pins[pin].isrNoArg = isr;
+  pins[pin].isr = nullptr;
+  pins[pin].mode = mode;
+  pins[pin].pending = false;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+  pins[pin].isr = isr;
+  pins[pin].isrNoArg = nullptr;
+  pins[pin].arg = arg;
+  pins[pin].mode = mode;
+  pins[pin].pending = false;
+}
+
+void detachInterrupt(uint8_t pin) {
+  pins[pin].isr = nullptr;
+  pins[pin].isrNoArg = nullptr;
+  pins[pin].pending = false;
+}
+
+// ---------------------------------------------------------------------------
+// Print y serie
+
+size_t Print::printf(const char* format, ...) {
+  char small[128];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(small, sizeof(small), format, args);
+  va_end(args);
+  if (n < 0) return 0;
+  if ((size_t)n < sizeof(small)) return write((const uint8_t*)small, (size_t)n);
+
+  std::vector<char> big((size_t)n + 1);
+  va_start(args, format);
+  vsnprintf(big.data(), big.size(), format, args);
+  va_end(args);
+  return write((const uint8_t*)big.data(), (size_t)n);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == DEC) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%ld", n);
+    return write((const uint8_t*)buf, (size_t)len);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[8 * sizeof(long) + 1];
+  char* p = buf + sizeof(buf);
+  if (base < 2) base = DEC;
+  do {
+    unsigned long digit = n % (unsigned long)base;
+    *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    n /= (unsigned long)base;
+  } while (n);
+  return write((const uint8_t*)p, (size_t)(buf + sizeof(buf) - p));
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[40];
+  int len = snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write((const uint8_t*)buf, (size_t)len);
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  if (serialCapture) {
+    serialOut.append((const char*)buffer, size);
+  } else {
+    fwrite(buffer, 1, size, stdout);
+  }
+  return size;
+}
+
+int HardwareSerial::available() {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  return (int)serialIn.size();
+}
+
+int HardwareSerial::read() {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  if (serialIn.empty()) return -1;
+  char c = serialIn.front();
+  serialIn.pop_front();
+  return (uint8_t)c;
+}
+
+int HardwareSerial::peek() {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  return serialIn.empty() ? -1 : (uint8_t)serialIn.front();
+}
+
+// ---------------------------------------------------------------------------
+// ESP y FreeRTOS
+
+uint32_t EspClass::getCycleCount() {
+  using namespace std::chrono;
+  uint64_t ns = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  return (uint32_t)(ns * getCpuFreqMHz() / 1000);
+}
+
+// El host no tiene un montículo de 320 KB; se informan los valores típicos
+// del equipo para que los informes tengan la misma forma
+uint32_t EspClass::getFreeHeap() { return 180000; }
+uint32_t EspClass::getMinFreeHeap() { return 170000; }
+uint32_t EspClass::getMaxAllocHeap() { return 110000; }
+
+namespace {
+  thread_local BaseType_t currentCore = 1;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* params, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core) {
+  (void)name;
+  (void)stackDepth;
+  (void)priority;
+  std::thread* task = new std::thread([fn, params, core]() {
+    currentCore = core;
+    fn(params);
+  });
+  task->detach();
+  if (handle) *handle = task;
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+BaseType_t xPortGetCoreID() {
+  return currentCore;
+}
+
+void fakeTaskYield() {
+  std::this_thread::yield();
+}
+
+// ---------------------------------------------------------------------------
+// Wire
+
+void TwoWire::beginTransmission(uint16_t address) {
+  _txAddress = address;
+  _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t c) {
+  if (_txLength >= sizeof(_tx)) return 0;
+  _tx[_txLength++] = c;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size) {
+  size_t n = 0;
+  while (n < size && write(data[n])) n++;
+  return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  FakeHal::I2cDevice* device = FakeHal::i2cDevice((uint8_t)_txAddress);
+  i2cByteCount.fetch_add(1 + (uint32_t)_txLength);
+  if (!device) return 2;
+  device->onWrite(_tx, _txLength);
+  _txLength = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint16_t address, uint8_t size, bool sendStop) {
+  (void)sendStop;
+  _rxIndex = 0;
+  _rxLength = 0;
+  FakeHal::I2cDevice* device = FakeHal::i2cDevice((uint8_t)address);
+  if (!device) return 0;
+  if (size > sizeof(_rx)) size = sizeof(_rx);
+  _rxLength = device->onRead(_rx, size);
+  i2cByteCount.fetch_add(1 + (uint32_t)_rxLength);
+  return (uint8_t)_rxLength;
+}
+
+// ---------------------------------------------------------------------------
+// Preferences
+
+static std::string nvsKey(const char* nameSpace, const char* key) {
+  return std::string(nameSpace) + "/" + key;
+}
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  _nameSpace = name;
+  _readOnly = readOnly;
+  return true;
+}
+
+void Preferences::end() {
+  _nameSpace = nullptr;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (!_nameSpace || _readOnly) return 0;
+  const uint8_t* bytes = static_cast<const uint8_t*>(value);
+  nvs[nvsKey(_nameSpace, key)] = std::vector<uint8_t>(bytes, bytes + len);
+  return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  if (!_nameSpace) return 0;
+  auto it = nvs.find(nvsKey(_nameSpace, key));
+  if (it == nvs.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!_nameSpace) return 0;
+  auto it = nvs.find(nvsKey(_nameSpace, key));
+  return it == nvs.end() ? 0 : it->second.size();
+}
+
+bool Preferences::remove(const char* key) {
+  if (!_nameSpace || _readOnly) return false;
+  return nvs.erase(nvsKey(_nameSpace, key)) > 0;
+}
+
+bool Preferences::clear() {
+  if (!_nameSpace || _readOnly) return false;
+  std::string prefix = std::string(_nameSpace) + "/";
+  for (auto it = nvs.begin(); it != nvs.end();) {
+    if (it->first.compare(0, prefix.size(), prefix) == 0) it = nvs.erase(it);
+    else ++it;
+  }
+  return true;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles,
+                       const char* partitionLabel) {
+  (void)formatOnFail;
+  (void)basePath;
+  (void)maxOpenFiles;
+  (void)partitionLabel;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// BLE
+
+BLECharacteristic::BLECharacteristic(const char* uuid, uint32_t properties)
+  : _uuid(uuid), _properties(properties), _notifies(0), _notifyBytes(0) {
+}
+
+void BLECharacteristic::setValue(uint8_t* data, size_t size) {
+  std::lock_guard<std::mutex> lock(bleMutex);
+  _value.assign(data, data + size);
+}
+
+void BLECharacteristic::setValue(const std::string& value) {
+  std::lock_guard<std::mutex> lock(bleMutex);
+  _value.assign(value.begin(), value.end());
+}
+
+std::string BLECharacteristic::getValue() const {
+  std::lock_guard<std::mutex> lock(bleMutex);
+  return std::string(_value.begin(), _value.end());
+}
+
+void BLECharacteristic::notify(bool isNotification) {
+  (void)isNotification;
+  std::lock_guard<std::mutex> lock(bleMutex);
+  if (!bleConnected.load() || !(_properties & PROPERTY_NOTIFY)) return;
+  _notifies++;
+  _notifyBytes += (uint32_t)_value.size();
+}
+
+uint32_t BLECharacteristic::getNotifyCount() const {
+  std::lock_guard<std::mutex> lock(bleMutex);
+  return _notifies;
+}
+
+uint32_t BLECharacteristic::getNotifyBytes() const {
+  std::lock_guard<std::mutex> lock(bleMutex);
+  return _notifyBytes;
+}
+
+BLECharacteristic* BLEService::createCharacteristic(const char* uuid, uint32_t properties) {
+  BLECharacteristic* c = new BLECharacteristic(uuid, properties);
+  std::lock_guard<std::mutex> lock(bleMutex);
+  bleCharacteristics.push_back(c);
+  return c;
+}
+
+BLEService* BLEServer::createService(const char* uuid) {
+  return new BLEService(uuid);
+}
+
+uint32_t BLEServer::getConnectedCount() {
+  return bleConnected.load() ? 1 : 0;
+}
+
+uint16_t BLEServer::getPeerMTU(uint16_t connId) {
+  (void)connId;
+  return blePeerMtu.load();
+}
+
+static uint16_t localMtu = 23;
+
+void BLEDevice::init(const std::string& name) {
+  (void)name;
+}
+
+int BLEDevice::setMTU(uint16_t mtu) {
+  localMtu = mtu;
+  return 0;
+}
+
+uint16_t BLEDevice::getMTU() {
+  return localMtu;
+}
+
+BLEServer* BLEDevice::createServer() {
+  return new BLEServer();
+}
+
+BLEAdvertising* BLEDevice::getAdvertising() {
+  static BLEAdvertising advertising;
+  return &advertising;
+}
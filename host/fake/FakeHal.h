@@ -0,0 +1,78 @@
+#ifndef FAKE_HAL_H
+#define FAKE_HAL_H
+
+#include <Arduino.h>
+#include <string>
+
+class BLECharacteristic;
+
+// Control del hardware simulado desde las pruebas y la simulación. El
+// firmware no incluye este fichero: ve las mismas funciones de Arduino que
+// en el equipo.
+namespace FakeHal {
+
+  // Deja tiempo, pines, bus, NVS, serie y BLE como recién encendido.
+  void reset();
+
+  // ---- Tiempo virtual ----
+  // millis() y micros() leen este contador; delay() y delayMicroseconds()
+  // lo avanzan. Los modelos con eventos propios (conversiones del HX711,
+  // muestras del MPU6050) se disparan en orden al avanzar.
+  uint64_t nowMicros();
+  void advanceMicros(uint64_t us);
+  inline void advanceMillis(uint32_t ms) { advanceMicros((uint64_t)ms * 1000); }
+
+  class TimedDevice {
+  public:
+    virtual ~TimedDevice() {}
+    // Instante absoluto del próximo evento; UINT64_MAX si no hay ninguno
+    virtual uint64_t nextEventUs() const = 0;
+    virtual void onTime(uint64_t nowUs) = 0;
+  };
+  void attachTimed(TimedDevice* device);
+  void detachTimed(TimedDevice* device);
+
+  // ---- GPIO ----
+  // Un modelo conectado a un pin recibe lo que el firmware escribe en él y
+  // fija con drivePin() el nivel que el firmware lee. Un flanco que casa con
+  // la interrupción armada llama a su ISR; si llega mientras otra ISR corre
+  // se queda pendiente y se atiende al salir, como el bit de estado del
+  // GPIO del ESP32.
+  class PinListener {
+  public:
+    virtual ~PinListener() {}
+    virtual void onPinWrite(uint8_t pin, uint8_t level) = 0;
+  };
+  void attachPin(uint8_t pin, PinListener* listener);
+  void drivePin(uint8_t pin, uint8_t level);
+  uint8_t pinLevel(uint8_t pin);
+  uint32_t interruptCount(uint8_t pin);
+  bool inInterrupt();
+
+  // ---- I2C ----
+  // write recibe los bytes de una transmisión (registro incluido); read
+  // rellena una lectura de `len` bytes y devuelve cuántos dio.
+  class I2cDevice {
+  public:
+    virtual ~I2cDevice() {}
+    virtual void onWrite(const uint8_t* data, size_t len) = 0;
+    virtual size_t onRead(uint8_t* data, size_t len) = 0;
+  };
+  void attachI2c(uint8_t address, I2cDevice* device);
+  void detachI2c(uint8_t address);
+  I2cDevice* i2cDevice(uint8_t address);
+  uint32_t i2cBytes();
+
+  // ---- Serie ----
+  void serialInput(const char* text);
+  // Con captura activa la salida se guarda en vez de ir a stdout
+  void captureSerial(bool enabled);
+  std::string takeSerialOutput();
+
+  // ---- BLE ----
+  void setBleConnected(bool connected);
+  void setBlePeerMtu(uint16_t mtu);
+  BLECharacteristic* bleCharacteristic(const char* uuid);
+}
+
+#endif
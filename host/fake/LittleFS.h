@@ -0,0 +1,17 @@
+#ifndef FAKE_LITTLEFS_H
+#define FAKE_LITTLEFS_H
+
+#include <Arduino.h>
+
+// En el host los ficheros van al sistema de ficheros normal y montar no
+// hace nada; quien escribe crea sus directorios.
+class LittleFSFS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+             uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+  void end() {}
+};
+
+extern LittleFSFS LittleFS;
+
+#endif
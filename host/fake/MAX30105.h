@@ -0,0 +1,52 @@
+#ifndef FAKE_MAX30105_H
+#define FAKE_MAX30105_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define MAX30105_ADDRESS 0x57
+#define I2C_SPEED_STANDARD 100000
+#define I2C_SPEED_FAST 400000
+
+// Igual que la librería de SparkFun: check() copia al anillo todo lo que
+// tenga el FIFO del chip, y el anillo solo tiene STORAGE_SIZE huecos.
+#define STORAGE_SIZE 4
+
+// Interfaz de la librería de SparkFun sobre el modelo FakeMax30102. El
+// anillo, check(), available() y nextSample() reproducen el código original
+// (incluido que head apunta a la última muestra escrita), así que también
+// se reproduce cómo se pierden muestras si se vacía tarde.
+class MAX30105 {
+public:
+  MAX30105();
+
+  boolean begin(TwoWire& wirePort = Wire, uint32_t i2cSpeed = I2C_SPEED_STANDARD,
+                uint8_t i2caddr = MAX30105_ADDRESS);
+  void setup(byte powerLevel = 0x1F, byte sampleAverage = 4, byte ledMode = 3,
+             int sampleRate = 400, int pulseWidth = 411, int adcRange = 4096);
+
+  void setPulseAmplitudeRed(uint8_t amplitude) { (void)amplitude; }
+  void setPulseAmplitudeIR(uint8_t amplitude) { (void)amplitude; }
+  void setPulseAmplitudeGreen(uint8_t amplitude) { (void)amplitude; }
+  void shutDown() {}
+  void wakeUp() {}
+  void clearFIFO();
+
+  uint16_t check();
+  uint8_t available();
+  void nextSample();
+  uint32_t getFIFORed();
+  uint32_t getFIFOIR();
+  uint32_t getRed();
+  uint32_t getIR();
+
+private:
+  struct Record {
+    uint32_t red[STORAGE_SIZE];
+    uint32_t IR[STORAGE_SIZE];
+    byte head;
+    byte tail;
+  } sense;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef FAKE_PREFERENCES_H
+#define FAKE_PREFERENCES_H
+
+#include <Arduino.h>
+
+// NVS en memoria: los espacios de nombres sobreviven a end()/begin() y a
+// otros objetos Preferences, como en el equipo, pero no al proceso.
+// FakeHal::reset() los borra.
+class Preferences {
+public:
+  Preferences() : _nameSpace(nullptr), _readOnly(false) {}
+
+  bool begin(const char* name, bool readOnly = false);
+  void end();
+
+  size_t putBytes(const char* key, const void* value, size_t len);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t getBytesLength(const char* key);
+  bool remove(const char* key);
+  bool clear();
+
+private:
+  const char* _nameSpace;
+  bool _readOnly;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef FAKE_WIRE_H
+#define FAKE_WIRE_H
+
+#include <Arduino.h>
+
+#define I2C_BUFFER_LENGTH 128
+
+// TwoWire del host. Cada transacción se entrega al modelo registrado en su
+// dirección con FakeHal::attachI2c(); sin modelo, la dirección no responde
+// (NACK), como en el bus real.
+class TwoWire : public Stream {
+public:
+  bool begin() { return true; }
+  bool setClock(uint32_t hz) { _clockHz = hz; return true; }
+  uint32_t getClock() const { return _clockHz; }
+
+  void beginTransmission(uint16_t address);
+  void beginTransmission(int address) { beginTransmission((uint16_t)address); }
+  uint8_t endTransmission(bool sendStop = true);
+
+  uint8_t requestFrom(uint16_t address, uint8_t size, bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t size, uint8_t sendStop) {
+    return requestFrom((uint16_t)address, size, sendStop != 0);
+  }
+  uint8_t requestFrom(int address, int size, int sendStop = 1) {
+    return requestFrom((uint16_t)address, (uint8_t)size, sendStop != 0);
+  }
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t size) override;
+  using Print::write;
+
+  int available() override { return (int)(_rxLength - _rxIndex); }
+  int read() override { return _rxIndex < _rxLength ? _rx[_rxIndex++] : -1; }
+  int peek() override { return _rxIndex < _rxLength ? _rx[_rxIndex] : -1; }
+
+private:
+  uint32_t _clockHz = 100000;
+  uint16_t _txAddress = 0;
+  uint8_t _tx[I2C_BUFFER_LENGTH];
+  size_t _txLength = 0;
+  uint8_t _rx[I2C_BUFFER_LENGTH];
+  size_t _rxLength = 0;
+  size_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef FAKE_HEART_RATE_H
+#define FAKE_HEART_RATE_H
+
+#include <stdint.h>
+
+// Sustituto del detector PBA de SparkFun: quita la continua con un filtro
+// IIR y marca latido en cada cruce por cero ascendente de la componente
+// alterna, con un periodo refractario de 250 ms a 100 Hz. Basta para las
+// señales sintéticas de FakeMax30102.
+bool checkForBeat(int32_t sample);
+
+#endif
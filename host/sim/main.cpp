@@ -0,0 +1,229 @@
+// Sesión completa del equipo en el host: DeviceManager entero sobre el HAL
+// falso, con los tres sensores modelados y el tiempo virtual avanzando más
+// rápido que el real. Al terminar informa, por cadena de adquisición, de
+// cuántas muestras produjo el sensor, cuántas procesó el firmware, cuántas
+// se perdieron y cuántas por segundo sostendría con el coste medido aquí.
+// Entre TRACE_START_S y TRACE_STOP_S graba la traza de sensores con 't' y
+// al final la relee: si el tiempo retrocede en algún registro, falla.
+// Entre LINK_DOWN_S y LINK_UP_S el cliente BLE se desconecta: los vitales
+// van al registro offline y salen como lotes al reconectar.
+//
+//   alertavital_sim [segundos virtuales] [velocidad]
+//
+// La velocidad limita cuánto se adelanta el tiempo virtual al real: la
+// tarea de comunicaciones duerme tiempo real, así que a velocidad infinita
+// sus colas se desbordarían por un motivo que en el equipo no existe.
+
+#include <DeviceManager.h>
+#include <BloodPressureReader.h>
+#include <SensorTrace.h>
+#include <CalibrationStore.h>
+#include <Profiler.h>
+#include <BLEDevice.h>
+#include "FakeHal.h"
+#include "FakeDevices.h"
+
+#include <sys/stat.h>
+#include <chrono>
+#include <thread>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Los mismos pines que DeviceManager.cpp
+static const uint8_t DOUT_PIN = 32;
+static const uint8_t SCK_PIN = 33;
+static const int8_t MPU_INT_PIN = 25;
+static const uint8_t OLED_ADDR = 0x3C;
+
+static const uint32_t STEP_US = 250;
+
+// Calibración sembrada en NVS para no pasar por la de 11 s
+static const float OFFSET_COUNTS = 52000.0f;
+static const float COUNTS_PER_KPA = 9000.0f;
+
+static const double FALL_AT_S = 40.0;
+// 't' arranca y para la traza de sensores en estos instantes
+static const double TRACE_START_S = 5.0;
+static const double TRACE_STOP_S = 15.0;
+// Cliente BLE fuera de alcance
+static const double LINK_DOWN_S = 25.0;
+static const double LINK_UP_S = 35.0;
+
+class OledSink : public FakeHal::I2cDevice {
+public:
+  void onWrite(const uint8_t* data, size_t len) override { (void)data; (void)len; }
+  size_t onRead(uint8_t* data, size_t len) override { memset(data, 0, len); return len; }
+};
+
+// Pulso arterial en el brazalete: 80/120 mmHg a 72 lpm
+static int32_t cuffCounts(uint32_t index) {
+  double t = index * (FakeHx711::PERIOD_US / 1e6);
+  double phase = fmod(t * 72.0 / 60.0, 1.0);
+  double pulse = phase < 0.2 ? phase / 0.2 : exp(-(phase - 0.2) * 4.0);
+  double mmHg = 80.0 + 40.0 * pulse;
+  return (int32_t)(OFFSET_COUNTS + mmHg / BloodPressureReader::KPA_TO_MMHG * COUNTS_PER_KPA);
+}
+
+// En reposo sobre la muñeca; a FALL_AT_S cae (0,35 s de caída libre,
+// impacto de 4 g) y se queda tumbado de lado diez segundos
+static MotionSample wearer(double t) {
+  double d = t - FALL_AT_S;
+  MotionSample s = FakeMpu6050::atRest(t);
+  if (d >= 0 && d < 0.35) {
+    s.ax = 0.02; s.ay = 0.03; s.az = 0.05;
+  } else if (d >= 0.35 && d < 0.38) {
+    s.ax = 2.3; s.ay = 2.3; s.az = 2.3;
+  } else if (d >= 0.38 && d < 10.0) {
+    s.ax = 1.0; s.ay = 0.01; s.az = 0.02;
+  }
+  return s;
+}
+
+// Relee la traza que dejó 't' y comprueba que el tiempo nunca retrocede
+static bool checkTrace() {
+  FILE* in = fopen(OFFLINE_LOG_DIR "/trace.bin", "rb");
+  if (!in) {
+    printf("Traza: no se grabó\n");
+    return false;
+  }
+  FileTraceSource source(in);
+  SensorTraceReader reader(source);
+  uint32_t counts[TRACE_CHANNEL_COUNT] = { 0 };
+  uint32_t backwards = 0;
+  uint64_t firstUs = 0;
+  uint64_t lastUs = 0;
+  uint32_t records = 0;
+  TraceRecord rec;
+  bool ok = reader.begin();
+  while (ok && reader.next(rec)) {
+    if (records == 0) firstUs = rec.timestampUs;
+    if (records > 0 && rec.timestampUs < lastUs) backwards++;
+    lastUs = rec.timestampUs;
+    if (rec.channel < TRACE_CHANNEL_COUNT) counts[rec.channel]++;
+    records++;
+  }
+  ok = ok && !reader.isCorrupt();
+  fclose(in);
+
+  printf("Traza: %lu registros en %.2f s (PPG %lu, IMU %lu, HX711 %lu), %lu hacia atrás%s\n",
+         (unsigned long)records, (lastUs - firstUs) / 1e6,
+         (unsigned long)counts[TRACE_PPG], (unsigned long)counts[TRACE_IMU],
+         (unsigned long)counts[TRACE_HX711], (unsigned long)backwards,
+         ok ? "" : ", CORRUPTA");
+  return ok && records > 0 && backwards == 0;
+}
+
+static double costUs(ProfileStage stage) {
+  const Profiler::StageStats& st = Profiler::getStats(stage);
+  return st.totalTicks / (double)Profiler::ticksPerUs();
+}
+
+static void reportLine(const char* name, uint32_t produced, uint32_t processed,
+                       uint32_t lost, double busyUs) {
+  double rate = busyUs > 0 ? processed / (busyUs / 1e6) : 0;
+  printf("%-6s %10lu %10lu %8lu %14.2f %16.0f\n", name,
+         (unsigned long)produced, (unsigned long)processed, (unsigned long)lost,
+         processed ? busyUs / processed : 0.0, rate);
+}
+
+int main(int argc, char** argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 60.0;
+  double speed = argc > 2 ? atof(argv[2]) : 20.0;
+
+  FakeHal::reset();
+  FakeHal::setBleConnected(true);
+  FakeHal::setBlePeerMtu(247);
+
+  OledSink oled;
+  FakeHal::attachI2c(OLED_ADDR, &oled);
+  FakeHx711 hx711(DOUT_PIN, SCK_PIN);
+  hx711.setSource(cuffCounts);
+  FakeMpu6050 mpu(MPU_INT_PIN);
+  mpu.setMotion(wearer);
+  FakeMax30102& ppg = FakeMax30102::instance();
+  ppg.reset();
+  mkdir(OFFLINE_LOG_DIR, 0755);
+
+  {
+    NvsCalibrationStore store;
+    store.begin();
+    BloodPressureReader seed(DOUT_PIN, SCK_PIN);
+    seed.setCalibration(OFFSET_COUNTS, COUNTS_PER_KPA);
+    seed.saveCalibration(store);
+  }
+
+  static DeviceManager device;
+  device.init();
+  Profiler::reset();
+
+  auto realStart = std::chrono::steady_clock::now();
+  uint64_t startUs = FakeHal::nowMicros();
+  uint64_t endUs = startUs + (uint64_t)(seconds * 1e6);
+  bool traceStarted = false;
+  bool traceStopped = false;
+  bool linkDropped = false;
+  bool linkRestored = false;
+  while (FakeHal::nowMicros() < endUs) {
+    device.manage();
+    FakeHal::advanceMicros(STEP_US);
+
+    double virtualS = (FakeHal::nowMicros() - startUs) / 1e6;
+    if (!traceStarted && virtualS >= TRACE_START_S) {
+      FakeHal::serialInput("t");
+      traceStarted = true;
+    }
+    if (!traceStopped && virtualS >= TRACE_STOP_S) {
+      FakeHal::serialInput("t");
+      traceStopped = true;
+    }
+    if (!linkDropped && virtualS >= LINK_DOWN_S) {
+      FakeHal::setBleConnected(false);
+      linkDropped = true;
+    }
+    if (!linkRestored && virtualS >= LINK_UP_S) {
+      FakeHal::setBleConnected(true);
+      linkRestored = true;
+    }
+    double realS = std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+    if (speed > 0 && virtualS > realS * speed) {
+      std::this_thread::sleep_for(std::chrono::duration<double>(virtualS / speed - realS));
+    }
+  }
+  double realS = std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+
+  // 's' lo recoge comunicaciones y la copia la toma la adquisición, así
+  // que el bucle sigue un poco; también deja vaciar lo pendiente
+  FakeHal::serialInput("s");
+  auto drainEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  while (std::chrono::steady_clock::now() < drainEnd) {
+    device.manage();
+    std::this_thread::sleep_for(std::chrono::microseconds(STEP_US));
+  }
+  fflush(stdout);
+
+  uint32_t imuRead = mpu.getFifoBytesRead() / 12;
+  BLECharacteristic* falls = FakeHal::bleCharacteristic("beb5483e-36e1-4688-b7f5-ea07361b26a9");
+  BLECharacteristic* vitals = FakeHal::bleCharacteristic("beb5483e-36e1-4688-b7f5-ea07361b26a8");
+  BLECharacteristic* backlog = FakeHal::bleCharacteristic("beb5483e-36e1-4688-b7f5-ea07361b26ac");
+
+  printf("\nSesión simulada: %.1f s virtuales en %.2f s reales\n", seconds, realS);
+  printf("Cadena  producidas procesadas perdidas  coste/muestra(us)  muestras/s en este host\n");
+  uint32_t ppgLost = ppg.getChipOverflows() + ppg.getLibraryOverwrites();
+  reportLine("PPG", ppg.getProduced(), ppg.getProduced() - ppgLost - ppg.pending(FakeHal::nowMicros()),
+             ppgLost, costUs(PROF_PPG));
+  reportLine("IMU", mpu.getSamples(), imuRead, mpu.getFifoLost() / 12, costUs(PROF_IMU));
+  reportLine("HX711", hx711.getConversions(), hx711.getReads(), hx711.getOverwritten(),
+             costUs(PROF_BP));
+  printf("IMU: %lu despertares por caída libre, %lu por movimiento\n",
+         (unsigned long)mpu.getFreefallEvents(), (unsigned long)mpu.getMotionEvents());
+  printf("BLE: %lu notificaciones de vitales, %lu de caída, %lu lotes del registro offline\n",
+         (unsigned long)(vitals ? vitals->getNotifyCount() : 0),
+         (unsigned long)(falls ? falls->getNotifyCount() : 0),
+         (unsigned long)(backlog ? backlog->getNotifyCount() : 0));
+  bool traceOk = !traceStopped || checkTrace();
+  fflush(stdout);
+
+  // Las tareas de FreeRTOS no terminan nunca
+  _Exit(traceOk ? 0 : 1);
+}
@@ -0,0 +1,102 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Pruebas del host sin dependencias. Cada fichero es un ejecutable: declara
+// sus casos con TEST(), termina con HOST_TEST_MAIN() y sale con 1 si algún
+// CHECK falla, que es lo que mira ctest. Las mediciones (BENCH) solo se
+// imprimen; no fallan nunca, porque dependen de la máquina.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+namespace HostTest {
+  struct Case {
+    const char* name;
+    void (*fn)();
+    Case* next;
+  };
+
+  inline Case*& cases() {
+    static Case* head = nullptr;
+    return head;
+  }
+
+  inline int& failures() {
+    static int count = 0;
+    return count;
+  }
+
+  struct Registrar {
+    Case entry;
+    Registrar(const char* name, void (*fn)()) {
+      entry.name = name;
+      entry.fn = fn;
+      entry.next = nullptr;
+      // Se ejecutan en el orden del fichero
+      Case** tail = &cases();
+      while (*tail) tail = &(*tail)->next;
+      *tail = &entry;
+    }
+  };
+
+  inline void fail(const char* file, int line, const char* expr) {
+    printf("  FALLO %s:%d: %s\n", file, line, expr);
+    failures()++;
+  }
+
+  inline int run() {
+    int failedCases = 0;
+    for (Case* c = cases(); c; c = c->next) {
+      int before = failures();
+      printf("[ caso ] %s\n", c->name);
+      fflush(stdout);
+      c->fn();
+      if (failures() != before) failedCases++;
+    }
+    printf("%s: %d casos con fallos\n", failedCases ? "FALLO" : "OK", failedCases);
+    return failedCases ? 1 : 0;
+  }
+
+  // Nanosegundos por iteración de fn(i) para i en [0, n)
+  template <typename F>
+  double nsPerIteration(size_t n, F fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) fn(i);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / n;
+  }
+
+  // Impide que el compilador descarte un resultado que solo se mide
+  template <typename T>
+  inline void keep(const T& value) {
+    static volatile T sink;
+    sink = value;
+    (void)sink;
+  }
+}
+
+#define TEST(name) \
+  static void name(); \
+  static HostTest::Registrar name##_registrar(#name, name); \
+  static void name()
+
+#define CHECK(cond) \
+  do { if (!(cond)) { HostTest::fail(__FILE__, __LINE__, #cond); return; } } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    long long _a = (long long)(a), _b = (long long)(b); \
+    if (_a != _b) { \
+      printf("  %s = %lld, %s = %lld\n", #a, _a, #b, _b); \
+      HostTest::fail(__FILE__, __LINE__, #a " == " #b); \
+      return; \
+    } \
+  } while (0)
+
+#define BENCH(...) printf("  [medida] " __VA_ARGS__)
+
+#define HOST_TEST_MAIN() \
+  int main() { return HostTest::run(); }
+
+#endif
@@ -0,0 +1,308 @@
+// Núcleo de caídas en cuentas frente al de coma flotante al que sustituyó.
+// Las mismas trazas pasan por una copia de aquel (sqrt y acos en float) y
+// por FallDetector::processSample(), y cada decisión debe coincidir. En el
+// límite exacto de 45° mandan las cuentas: allí el float redondea y se
+// equivoca, y la prueba comprueba que solo discrepan en ese margen.
+
+#include "HostTest.h"
+#include <FallDetector.h>
+#include <math.h>
+#include <vector>
+
+static const float S = 16384.0f;   // cuentas por g a ±2 g
+
+// Copia del processSample() en float anterior a las cuentas al cuadrado,
+// sin los mensajes. Devuelve true cuando decide caída.
+class FloatKernel {
+  public:
+    bool processSample(int16_t rawAx, int16_t rawAy, int16_t rawAz, unsigned long now) {
+      float ax = (float)rawAx / S;
+      float ay = (float)rawAy / S;
+      float az = (float)rawAz / S;
+
+      float mag = sqrt(ax*ax + ay*ay + az*az);
+
+      if (state == IDLE && mag > 0.85f && mag < 1.15f) {
+        lastStableAx = ax;
+        lastStableAy = ay;
+        lastStableAz = az;
+      }
+
+      bool fall = false;
+      switch (state) {
+        case IDLE:
+          if (mag < 0.30f) {
+            state = MAYBE_FREEFALL;
+            freefallStart = now;
+          }
+          break;
+
+        case MAYBE_FREEFALL:
+          if (mag > 3.0f) {
+            state = MAYBE_IMPACT;
+            impactTime = now;
+          } else if ((now - freefallStart) > 500) {
+            state = IDLE;
+          }
+          break;
+
+        case MAYBE_IMPACT:
+          if ((now - impactTime) >= 200) {
+            float angle = angleBetween(lastStableAx, lastStableAy, lastStableAz, ax, ay, az);
+            if (angle > 45.0f) {
+              fall = true;
+            } else {
+              smallAngles++;
+            }
+            state = IDLE;
+          }
+          else if (mag > 3.0f * 1.5f) {
+            state = IDLE;
+          }
+          break;
+      }
+      return fall;
+    }
+
+    uint32_t smallAngles = 0;   // impactos descartados por el ángulo
+
+  private:
+    enum State { IDLE, MAYBE_FREEFALL, MAYBE_IMPACT };
+    State state = IDLE;
+    unsigned long freefallStart = 0;
+    unsigned long impactTime = 0;
+    float lastStableAx = 0, lastStableAy = 0, lastStableAz = 1;
+
+    static float angleBetween(const float ax1, const float ay1, const float az1,
+                              const float ax2, const float ay2, const float az2) {
+      float dot = ax1*ax2 + ay1*ay2 + az1*az2;
+      float n1 = sqrt(ax1*ax1 + ay1*ay1 + az1*az1);
+      float n2 = sqrt(ax2*ax2 + ay2*ay2 + az2*az2);
+      if (n1==0 || n2==0) return 0.0f;
+      float cosv = dot / (n1*n2);
+      if (cosv > 1.0f) cosv = 1.0f;
+      if (cosv < -1.0f) cosv = -1.0f;
+      return acos(cosv) * 180.0f / PI;
+    }
+};
+
+struct Sample {
+  int16_t x, y, z;
+  uint32_t ms;
+};
+
+struct Vec {
+  double x, y, z;
+};
+
+// Generador determinista: las trazas son las mismas en cada ejecución
+static uint32_t rngState = 0x2545F491;
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+static double uniform(double lo, double hi) {
+  return lo + (hi - lo) * (nextRandom() / 4294967296.0);
+}
+
+static Vec randomUnit() {
+  for (;;) {
+    Vec v = { uniform(-1, 1), uniform(-1, 1), uniform(-1, 1) };
+    double n = sqrt(v.x*v.x + v.y*v.y + v.z*v.z);
+    if (n > 0.1 && n <= 1.0) {
+      Vec u = { v.x / n, v.y / n, v.z / n };
+      return u;
+    }
+  }
+}
+
+// a girado `deg` grados en una dirección al azar
+static Vec rotated(const Vec& a, double deg) {
+  Vec r = randomUnit();
+  double d = r.x*a.x + r.y*a.y + r.z*a.z;
+  Vec p = { r.x - d*a.x, r.y - d*a.y, r.z - d*a.z };
+  double n = sqrt(p.x*p.x + p.y*p.y + p.z*p.z);
+  double t = deg * M_PI / 180.0;
+  Vec b = { a.x*cos(t) + p.x/n*sin(t), a.y*cos(t) + p.y/n*sin(t), a.z*cos(t) + p.z/n*sin(t) };
+  return b;
+}
+
+static int16_t counts(double g) {
+  double c = lround(g * S);
+  if (c > 32767) c = 32767;
+  if (c < -32768) c = -32768;
+  return (int16_t)c;
+}
+
+// Un golpe de más de 3 g solo cabe a ±2 g por eje cerca de una diagonal
+static Vec diagonal() {
+  Vec d = { (nextRandom() & 1) ? 0.57735 : -0.57735,
+            (nextRandom() & 1) ? 0.57735 : -0.57735,
+            (nextRandom() & 1) ? 0.57735 : -0.57735 };
+  return d;
+}
+
+static void push(std::vector<Sample>& trace, uint32_t& ms, const Vec& g, double scale, double noise) {
+  Sample s = { counts(g.x * scale + uniform(-noise, noise)),
+               counts(g.y * scale + uniform(-noise, noise)),
+               counts(g.z * scale + uniform(-noise, noise)), ms };
+  trace.push_back(s);
+  ms += 10;
+}
+
+// Trazas a 100 Hz: reposo en posturas al azar, caídas con giros de 0 a 90°
+// (muchas cerca de 45°), caídas libres sin impacto, golpes sin caída libre
+// y sacudidas que siguen pasado el impacto
+static std::vector<Sample> makeTrace(size_t episodes) {
+  std::vector<Sample> trace;
+  uint32_t ms = 0;
+  Vec posture = { 0, 0, 1 };
+  for (size_t e = 0; e < episodes; e++) {
+    int restSamples = (int)uniform(50, 250);
+    for (int i = 0; i < restSamples; i++) push(trace, ms, posture, 1.0, 0.02);
+
+    uint32_t kind = nextRandom() % 8;
+    if (kind < 5) {
+      int freefall = (int)uniform(15, kind == 0 ? 70 : 45);
+      for (int i = 0; i < freefall; i++) push(trace, ms, posture, uniform(0.0, 0.25), 0.02);
+      Vec hit = diagonal();
+      for (int i = 0; i < 3; i++) push(trace, ms, hit, uniform(2.9, 3.4), 0.02);
+      double deg = kind == 1 ? uniform(44.0, 46.0) : uniform(0.0, 90.0);
+      Vec after = rotated(posture, deg);
+      bool shaking = kind == 2;
+      for (int i = 0; i < 60; i++) {
+        if (shaking && i < 30) push(trace, ms, diagonal(), uniform(1.0, 3.4), 0.05);
+        else push(trace, ms, after, 1.0, 0.02);
+      }
+      posture = after;
+    } else if (kind == 5) {
+      for (int i = 0; i < 3; i++) push(trace, ms, diagonal(), uniform(2.9, 3.4), 0.02);
+    } else {
+      posture = randomUnit();
+    }
+  }
+  return trace;
+}
+
+struct Outcome {
+  uint32_t falls;
+  uint32_t mismatches;
+};
+
+static Outcome compare(const std::vector<Sample>& trace, FloatKernel& reference) {
+  FallDetector imu;
+  Outcome out = { 0, 0 };
+  for (size_t i = 0; i < trace.size(); i++) {
+    const Sample& s = trace[i];
+    bool expected = reference.processSample(s.x, s.y, s.z, s.ms);
+    imu.processSample(s.x, s.y, s.z, 0, 0, 0, s.ms);
+    bool got = imu.wasFallDetected();
+    if (got != expected) {
+      if (out.mismatches < 5) {
+        printf("  muestra %zu (%lu ms): float %d, cuentas %d\n", i, (unsigned long)s.ms, expected, got);
+      }
+      out.mismatches++;
+    }
+    if (expected) out.falls++;
+  }
+  return out;
+}
+
+TEST(las_trazas_deciden_igual) {
+  std::vector<Sample> trace = makeTrace(20000);
+  FloatKernel reference;
+  Outcome out = compare(trace, reference);
+
+  CHECK_EQ(out.mismatches, 0u);
+  // La traza debe ejercitar las dos salidas de la comprobación del ángulo
+  CHECK(out.falls > 4000);
+  CHECK(reference.smallAngles > 4000);
+  printf("  %zu muestras, %lu caídas, %lu descartadas por ángulo\n", trace.size(),
+         (unsigned long)out.falls, (unsigned long)reference.smallAngles);
+}
+
+// Lleva a ambos núcleos de `stable` a `after` pasando por caída libre e
+// impacto, y devuelve la decisión de cada uno
+static void fallTo(FallDetector& imu, FloatKernel& reference, uint32_t& ms,
+                   const int16_t* stable, const int16_t* after, bool& floatFall, bool& countsFall) {
+  const int16_t steps[4][3] = {
+    { stable[0], stable[1], stable[2] },
+    { 0, 0, 0 },
+    { 32000, 32000, 32000 },
+    { after[0], after[1], after[2] },
+  };
+  const uint32_t gaps[4] = { 10, 10, 10, 200 };
+  floatFall = countsFall = false;
+  for (int i = 0; i < 4; i++) {
+    ms += gaps[i];
+    floatFall |= reference.processSample(steps[i][0], steps[i][1], steps[i][2], ms);
+    imu.processSample(steps[i][0], steps[i][1], steps[i][2], 0, 0, 0, ms);
+    countsFall |= imu.wasFallDetected();
+  }
+  ms += 1000;
+}
+
+TEST(en_el_limite_de_45_grados_mandan_las_cuentas) {
+  FallDetector imu;
+  FloatKernel reference;
+  uint32_t ms = 0;
+  uint32_t cases = 0, floatWrong = 0;
+  double worstDeg = 0;
+
+  for (int i = 0; i < 200000; i++) {
+    Vec a = randomUnit();
+    double scale = uniform(0.86, 1.14);
+    int16_t stable[3] = { counts(a.x * scale), counts(a.y * scale), counts(a.z * scale) };
+    Vec b = rotated(a, 45.0 + uniform(-1e-4, 1e-4));
+    double afterScale = uniform(0.5, 1.5);
+    int16_t after[3] = { counts(b.x * afterScale), counts(b.y * afterScale), counts(b.z * afterScale) };
+
+    // La verdad: cos < 1/√2 en aritmética exacta de 128 bits
+    __int128 dot = (__int128)stable[0]*after[0] + (__int128)stable[1]*after[1] + (__int128)stable[2]*after[2];
+    __int128 n1 = (__int128)stable[0]*stable[0] + (__int128)stable[1]*stable[1] + (__int128)stable[2]*stable[2];
+    __int128 n2 = (__int128)after[0]*after[0] + (__int128)after[1]*after[1] + (__int128)after[2]*after[2];
+    bool above = dot < 0 || 2 * dot * dot < n1 * n2;
+
+    bool floatFall, countsFall;
+    fallTo(imu, reference, ms, stable, after, floatFall, countsFall);
+    CHECK_EQ(countsFall, above);
+    cases++;
+
+    if (floatFall != above) {
+      floatWrong++;
+      long double cosv = (long double)dot / sqrtl((long double)n1 * (long double)n2);
+      double deg = fabs((double)(acosl(cosv) * 180.0L / M_PI) - 45.0);
+      if (deg > worstDeg) worstDeg = deg;
+    }
+  }
+
+  // El float solo se equivoca a una fracción de milésima de grado de 45°
+  CHECK(worstDeg < 1e-3);
+  printf("  %lu casos a ±1e-4° de 45°: el float falla en %lu, como mucho a %.2g° del límite\n",
+         (unsigned long)cases, (unsigned long)floatWrong, worstDeg);
+}
+
+TEST(medida_por_muestra) {
+  std::vector<Sample> trace = makeTrace(20000);
+  const size_t n = trace.size();
+
+  FloatKernel reference;
+  double floatNs = HostTest::nsPerIteration(n, [&](size_t i) {
+    const Sample& s = trace[i];
+    HostTest::keep(reference.processSample(s.x, s.y, s.z, s.ms));
+  });
+
+  FallDetector imu;
+  double countsNs = HostTest::nsPerIteration(n, [&](size_t i) {
+    const Sample& s = trace[i];
+    imu.processSample(s.x, s.y, s.z, 0, 0, 0, s.ms);
+    HostTest::keep(imu.wasFallDetected());
+  });
+
+  BENCH("float (sqrt, acos): %.1f ns por muestra\n", floatNs);
+  BENCH("cuentas al cuadrado: %.1f ns por muestra\n", countsNs);
+}
+
+HOST_TEST_MAIN()
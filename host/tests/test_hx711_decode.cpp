@@ -0,0 +1,104 @@
+// Lectura del HX711: extensión de signo de la palabra de 24 bits y lectura
+// bit a bit contra el HX711 falso en todo su rango. La ruta por registros
+// solo existe en el ESP32; aquí se compila la portátil, que comparte
+// decodeRaw() con ella.
+
+#include "HostTest.h"
+#include "FakeHal.h"
+#include "FakeDevices.h"
+#include <BloodPressureReader.h>
+#include <vector>
+
+static const uint8_t DOUT_PIN = 32;
+static const uint8_t SCK_PIN = 33;
+
+TEST(extension_de_signo) {
+  CHECK_EQ(BloodPressureReader::decodeRaw(0x000000UL), 0);
+  CHECK_EQ(BloodPressureReader::decodeRaw(0x000001UL), 1);
+  CHECK_EQ(BloodPressureReader::decodeRaw(0x7FFFFFUL), 8388607);
+  CHECK_EQ(BloodPressureReader::decodeRaw(0x800000UL), -8388608);
+  CHECK_EQ(BloodPressureReader::decodeRaw(0x800001UL), -8388607);
+  CHECK_EQ(BloodPressureReader::decodeRaw(0xFFFFFFUL), -1);
+}
+
+TEST(ignora_el_byte_alto) {
+  CHECK_EQ(BloodPressureReader::decodeRaw(0xFF7FFFFFUL), 8388607);
+  CHECK_EQ(BloodPressureReader::decodeRaw(0x12800000UL), -8388608);
+  CHECK_EQ(BloodPressureReader::decodeRaw(0xAB000000UL), 0);
+}
+
+// Espera a la siguiente conversión y la lee como lo hace update(), o por
+// la ruta portátil
+static bool readNext(BloodPressureReader& bp, long& raw, bool portable = false) {
+  for (int i = 0; i < 4 && !bp.isReady(); i++) {
+    FakeHal::advanceMicros(FakeHx711::PERIOD_US / 2);
+  }
+  if (!bp.isReady()) return false;
+  raw = portable ? bp.readRawPortable() : bp.readRawInstant();
+  return true;
+}
+
+TEST(lectura_en_todo_el_rango) {
+  FakeHal::reset();
+  FakeHx711 hx(DOUT_PIN, SCK_PIN);
+  BloodPressureReader bp(DOUT_PIN, SCK_PIN);
+  bp.begin();
+
+  // Descarta lo que convirtió durante begin()
+  long raw;
+  CHECK(readNext(bp, raw));
+  for (int i = 0; i < 2000; i++) {
+    CHECK(readNext(bp, raw));
+    CHECK_EQ(raw, FakeHx711::valueAt(hx.getConversions() - 1));
+    CHECK_EQ(raw, bp.getLastRaw());
+  }
+  CHECK_EQ(hx.getReads(), hx.getConversions() - hx.getOverwritten());
+}
+
+TEST(valores_limite_por_el_bus) {
+  static const int32_t limits[] = { 0, 1, -1, 8388607, -8388608, 0x555555, -0x555556 };
+  const size_t count = sizeof(limits) / sizeof(limits[0]);
+
+  FakeHal::reset();
+  FakeHx711 hx(DOUT_PIN, SCK_PIN);
+  hx.setSource([&](uint32_t index) { return limits[index % count]; });
+  BloodPressureReader bp(DOUT_PIN, SCK_PIN);
+  bp.begin();
+
+  long raw;
+  CHECK(readNext(bp, raw));
+  // Alterna readRawInstant() y readRawPortable(): las dos decodifican igual
+  for (size_t i = 0; i < 4 * count; i++) {
+    CHECK(readNext(bp, raw, i % 2 == 1));
+    CHECK_EQ(raw, limits[(hx.getConversions() - 1) % count]);
+  }
+}
+
+TEST(coste_de_decodificar_y_leer) {
+  std::vector<uint32_t> words(1 << 16);
+  for (size_t i = 0; i < words.size(); i++) words[i] = (uint32_t)(i * 2654435761UL) & 0xFFFFFFUL;
+  double decodeNs = HostTest::nsPerIteration(words.size() * 64, [&](size_t i) {
+    HostTest::keep(BloodPressureReader::decodeRaw(words[i & 0xFFFF]));
+  });
+
+  FakeHal::reset();
+  FakeHx711 hx(DOUT_PIN, SCK_PIN);
+  BloodPressureReader bp(DOUT_PIN, SCK_PIN);
+  bp.begin();
+  long raw;
+  readNext(bp, raw);
+  uint64_t busUs = 0;
+  const size_t reads = 2000;
+  double readNs = HostTest::nsPerIteration(reads, [&](size_t) {
+    while (!bp.isReady()) FakeHal::advanceMicros(500);
+    uint64_t start = FakeHal::nowMicros();
+    HostTest::keep(bp.readRawInstant());
+    busUs += FakeHal::nowMicros() - start;
+  });
+
+  BENCH("decodeRaw: %.2f ns/palabra\n", decodeNs);
+  BENCH("lectura portátil: %.1f us de bus por muestra (tiempo virtual), %.0f ns en este host\n",
+        busUs / (double)reads, readNs);
+}
+
+HOST_TEST_MAIN()
@@ -0,0 +1,62 @@
+// Adquisición del HX711 por interrupción sobre el GPIO falso: el consumidor
+// se detiene 50 ms entre vaciados (lo que tarda un refresco de la OLED) y
+// no se debe perder ni desordenar ninguna conversión.
+
+#include "HostTest.h"
+#include "FakeHal.h"
+#include "FakeDevices.h"
+#include <BloodPressureReader.h>
+
+static const uint8_t DOUT_PIN = 32;
+static const uint8_t SCK_PIN = 33;
+
+TEST(sin_perdidas_con_consumidor_detenido_50ms) {
+  FakeHal::reset();
+  FakeHx711 hx(DOUT_PIN, SCK_PIN);
+  BloodPressureReader bp(DOUT_PIN, SCK_PIN);
+  bp.begin();
+  bp.enableInterruptMode();
+
+  // enableInterruptMode() ya leyó la conversión que estaba lista
+  uint32_t overwrittenAtArm = hx.getOverwritten();
+  uint32_t expected = hx.getConversions() - 1;
+  uint32_t received = 0;
+
+  for (int stall = 0; stall < 200; stall++) {
+    FakeHal::advanceMillis(50);
+    long raw;
+    while (bp.readSample(raw)) {
+      CHECK_EQ(raw, FakeHx711::valueAt(expected));
+      expected++;
+      received++;
+    }
+  }
+
+  CHECK_EQ(expected, hx.getConversions());
+  CHECK_EQ(bp.getDroppedSamples(), 0);
+  CHECK_EQ(hx.getOverwritten(), overwrittenAtArm);
+  CHECK(received >= 200 * 50000 / FakeHx711::PERIOD_US);
+}
+
+// La cola aguanta SAMPLE_QUEUE_SIZE conversiones; más allá cuenta las que
+// descarta en vez de perderlas en silencio
+TEST(detencion_larga_cuenta_las_descartadas) {
+  FakeHal::reset();
+  FakeHx711 hx(DOUT_PIN, SCK_PIN);
+  BloodPressureReader bp(DOUT_PIN, SCK_PIN);
+  bp.begin();
+  bp.enableInterruptMode();
+
+  uint32_t before = hx.getConversions();
+  FakeHal::advanceMicros((uint64_t)FakeHx711::PERIOD_US * (BloodPressureReader::SAMPLE_QUEUE_SIZE + 8));
+  uint32_t produced = hx.getConversions() - before + 1;
+
+  long raw;
+  uint32_t drained = 0;
+  while (bp.readSample(raw)) drained++;
+
+  CHECK(bp.getDroppedSamples() > 0);
+  CHECK_EQ(drained + bp.getDroppedSamples(), produced);
+}
+
+HOST_TEST_MAIN()
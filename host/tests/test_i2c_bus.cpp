@@ -0,0 +1,101 @@
+// Arbitraje del bus I2C con hilos reales: un hilo hace de sensores (núcleo
+// 1) y otro de pantalla (núcleo 0), que envía en trozos de DISPLAY_CHUNK.
+// Con un sensor esperando no se concede ningún trozo nuevo, así que su
+// espera se limita al trozo que ya estuviera en curso.
+
+#include "HostTest.h"
+#include <I2CBus.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+typedef std::chrono::steady_clock SteadyClock;
+
+// Lo que tarda un trozo de pantalla a CLOCK_HZ: 9 bits por byte en el bus
+static const uint32_t CHUNK_US = I2CBus::DISPLAY_CHUNK * 9UL * 1000000UL / I2CBus::CLOCK_HZ;
+static const uint32_t SENSOR_HOLD_US = 60;   // una ráfaga del FIFO del MPU6050
+
+// Ocupa la CPU como lo haría la transferencia: el bus no se suelta antes
+static void busyFor(uint32_t us) {
+  SteadyClock::time_point end = SteadyClock::now() + std::chrono::microseconds(us);
+  while (SteadyClock::now() < end) {
+  }
+}
+
+TEST(con_ambos_esperando_gana_el_sensor) {
+  I2CBus bus;
+  for (int round = 0; round < 100; round++) {
+    std::atomic<int> order(0);
+    int sensorPos = -1, displayPos = -1;
+
+    bus.acquire(I2CBus::PRIORITY_DISPLAY);
+    std::thread display([&] {
+      bus.acquire(I2CBus::PRIORITY_DISPLAY);
+      displayPos = order++;
+      bus.release();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    std::thread sensor([&] {
+      bus.acquire(I2CBus::PRIORITY_SENSOR);
+      sensorPos = order++;
+      bus.release();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    bus.release();
+    sensor.join();
+    display.join();
+
+    CHECK_EQ(sensorPos, 0);
+    CHECK_EQ(displayPos, 1);
+  }
+}
+
+TEST(el_sensor_espera_como_mucho_un_trozo) {
+  I2CBus bus;
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> displayGrants(0);
+
+  // La pantalla manda trozos sin parar, como un flush() largo. Con tope:
+  // si acaparase el bus, el sensor acabaría entrando y la prueba fallaría
+  // en vez de quedarse colgada
+  const uint32_t reads = 1500;
+  std::thread display([&] {
+    while (!done.load() && displayGrants.load() < reads * 10) {
+      I2CBus::Lock lock(bus, I2CBus::PRIORITY_DISPLAY);
+      displayGrants.fetch_add(1);
+      busyFor(CHUNK_US);
+    }
+  });
+
+  uint32_t maxChunks = 0, maxWaitUs = 0;
+  for (uint32_t i = 0; i < reads; i++) {
+    // Trozos concedidos mientras el sensor espera. Uno puede haberse
+    // concedido justo antes de que se anunciara y contarse después; un
+    // segundo sería un trozo nuevo con el sensor ya esperando.
+    uint32_t before = displayGrants.load();
+    SteadyClock::time_point start = SteadyClock::now();
+    {
+      I2CBus::Lock lock(bus, I2CBus::PRIORITY_SENSOR);
+      uint32_t chunks = displayGrants.load() - before;
+      uint32_t waitUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+          SteadyClock::now() - start).count();
+      if (chunks > maxChunks) maxChunks = chunks;
+      if (waitUs > maxWaitUs) maxWaitUs = waitUs;
+      busyFor(SENSOR_HOLD_US);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  done.store(true);
+  display.join();
+
+  uint32_t grants = displayGrants.load();
+  CHECK(maxChunks <= 1);
+  CHECK(grants > reads / 2);   // la pantalla también avanza
+  CHECK_EQ(bus.getStats(I2CBus::PRIORITY_SENSOR).acquisitions, reads);
+  BENCH("trozo de pantalla %lu us; sensor: espera máx %lu us (reloj del host), %lu trozos; "
+        "pantalla: %lu trozos\n",
+        (unsigned long)CHUNK_US, (unsigned long)maxWaitUs, (unsigned long)maxChunks,
+        (unsigned long)grants);
+}
+
+HOST_TEST_MAIN()
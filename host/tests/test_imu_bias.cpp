@@ -0,0 +1,127 @@
+// Sesgo del acelerómetro estimado en reposo: plano basta una postura; en
+// cualquier otra se ajusta con varias posturas distintas, y si todas caen
+// en un mismo plano la calibración queda pendiente en vez de inventarse.
+
+#include "HostTest.h"
+#include "FakeHal.h"
+#include "FakeDevices.h"
+#include <FallDetector.h>
+#include <math.h>
+#include <vector>
+
+static const int8_t INT_PIN = 25;
+static const double BIAS_G[3] = { 0.03, -0.02, 0.05 };
+static const double HOLD_S = 8.0;   // de sobra para las cuatro ventanas
+
+struct Posture {
+  double x, y, z;
+};
+
+// Cada postura (vector de gravedad unitario) quieta HOLD_S, más el sesgo
+static MotionSource holding(const std::vector<Posture>& postures) {
+  return [postures](double t) {
+    size_t i = (size_t)(t / HOLD_S);
+    if (i >= postures.size()) i = postures.size() - 1;
+    const Posture& p = postures[i];
+    double n = sin(t * 377.0) * 0.004;
+    MotionSample s = { p.x + BIAS_G[0] + n, p.y + BIAS_G[1] - n, p.z + BIAS_G[2] + n, 0.0, 0.0, 0.0 };
+    return s;
+  };
+}
+
+static Posture tilted(double pitchDeg, double rollDeg) {
+  double p = pitchDeg * M_PI / 180.0;
+  double r = rollDeg * M_PI / 180.0;
+  Posture g = { -sin(p), cos(p) * sin(r), cos(p) * cos(r) };
+  return g;
+}
+
+static void run(FallDetector& imu, double seconds) {
+  uint32_t steps = (uint32_t)(seconds * 100);
+  for (uint32_t i = 0; i < steps; i++) {
+    FakeHal::advanceMillis(10);
+    imu.on();
+  }
+}
+
+static bool biasClose(const FallDetector& imu, int32_t tolerance) {
+  int16_t b[3];
+  imu.getBias(b[0], b[1], b[2]);
+  for (uint8_t i = 0; i < 3; i++) {
+    int32_t expected = (int32_t)lround(BIAS_G[i] * 16384.0);
+    if (abs(b[i] - expected) > tolerance) {
+      printf("  eje %u: %d, esperado %d\n", i, b[i], expected);
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(plano_basta_una_postura) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  std::vector<Posture> postures = { { 0.0, 0.0, 1.0 } };
+  mpu.setMotion(holding(postures));
+  FallDetector imu(INT_PIN);
+  imu.begin();
+
+  run(imu, HOLD_S);
+  CHECK(imu.isCalibrated());
+  CHECK(imu.takeCalibrationUpdate());
+  CHECK(biasClose(imu, 20));
+}
+
+TEST(en_la_muneca_con_varias_posturas) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  // Ninguna plana: muñeca de lado, palma arriba inclinada, colgando...
+  std::vector<Posture> postures = {
+    tilted(10, 80), tilted(-40, 20), tilted(60, -30), { 0.0, 0.0, -1.0 }, tilted(-70, 150)
+  };
+  mpu.setMotion(holding(postures));
+  FallDetector imu(INT_PIN);
+  imu.begin();
+
+  run(imu, HOLD_S);
+  CHECK(!imu.isCalibrated());
+  CHECK_EQ(imu.getCalibrationOrientations(), 1);
+
+  run(imu, HOLD_S * 4);
+  CHECK(imu.isCalibrated());
+  CHECK(imu.getCalibrationOrientations() >= FallDetector::MIN_ORIENTATIONS);
+  CHECK(biasClose(imu, 40));
+}
+
+TEST(posturas_en_un_plano_quedan_pendientes) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  // Girando solo alrededor de X: la gravedad recorre el plano YZ y el
+  // sesgo en X no se puede separar
+  std::vector<Posture> postures = {
+    tilted(0, 60), tilted(0, 120), tilted(0, 180), tilted(0, -120), tilted(0, -60)
+  };
+  mpu.setMotion(holding(postures));
+  FallDetector imu(INT_PIN);
+  imu.begin();
+
+  run(imu, HOLD_S * postures.size());
+  CHECK(!imu.isCalibrated());
+  CHECK(imu.getCalibrationOrientations() >= FallDetector::MIN_ORIENTATIONS);
+}
+
+TEST(en_movimiento_no_calibra) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  mpu.setMotion([](double t) {
+    MotionSample s = { 0.3 * sin(t * 6.0), 0.2 * cos(t * 4.0), 0.9, 0.0, 0.0, 0.0 };
+    return s;
+  });
+  FallDetector imu(INT_PIN);
+  imu.begin();
+
+  run(imu, 30.0);
+  CHECK(!imu.isCalibrated());
+  CHECK_EQ(imu.getCalibrationOrientations(), 0);
+}
+
+HOST_TEST_MAIN()
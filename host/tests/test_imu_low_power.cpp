@@ -0,0 +1,115 @@
+// Bajo consumo del MPU6050: en reposo no lo despierta nada; una caída libre
+// lo despierta ya en MAYBE_FREEFALL aunque la lectura periódica de postura
+// haya borrado antes INT_STATUS, y un cambio de postura lo despierta en la
+// siguiente lectura.
+
+#include "HostTest.h"
+#include "FakeHal.h"
+#include "FakeDevices.h"
+#include <FallDetector.h>
+#include <Arduino.h>
+
+static const int8_t INT_PIN = 25;
+
+static void run(FallDetector& imu, double seconds) {
+  uint32_t steps = (uint32_t)(seconds * 100);
+  for (uint32_t i = 0; i < steps; i++) {
+    FakeHal::advanceMillis(10);
+    imu.on();
+  }
+}
+
+// Calibra plano y entra en bajo consumo
+static void settle(FallDetector& imu) {
+  imu.begin();
+  imu.setLowPower(true);
+  run(imu, 10.0);
+}
+
+TEST(en_reposo_no_despierta) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  mpu.setMotion(FakeMpu6050::atRest);
+  FallDetector imu(INT_PIN);
+  settle(imu);
+  CHECK(imu.isLowPower());
+
+  run(imu, 30.0);
+  CHECK(imu.isLowPower());
+  CHECK_EQ(mpu.getFreefallEvents(), 0);
+  CHECK_EQ(imu.getStats().freefallWakes, 0);
+  CHECK_EQ(imu.getStats().lowPowerEntries, 1);
+}
+
+TEST(caida_en_bajo_consumo_se_detecta) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  mpu.setMotion([](double t) {
+    double d = t - 20.0;
+    MotionSample s = FakeMpu6050::atRest(t);
+    if (d >= 0 && d < 0.35) {
+      s.ax = 0.02; s.ay = 0.03; s.az = 0.05;
+    } else if (d >= 0.35 && d < 0.38) {
+      s.ax = 2.3; s.ay = 2.3; s.az = 2.3;
+    } else if (d >= 0.38) {
+      s.ax = 1.0; s.ay = 0.01; s.az = 0.02;
+    }
+    return s;
+  });
+  FallDetector imu(INT_PIN);
+  settle(imu);
+  CHECK(imu.isLowPower());
+
+  run(imu, 15.0);
+  CHECK_EQ(imu.getStats().freefallWakes, 1);
+  CHECK(imu.wasFallDetected());
+}
+
+TEST(estado_borrado_por_la_lectura_de_postura_no_se_pierde) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  // Caída libre corta y vuelve a la misma postura: la postura no cambia y
+  // el pulso de INT no llega, solo queda INT_STATUS
+  mpu.setMotion([](double t) {
+    double d = t - 20.05;
+    MotionSample s = FakeMpu6050::atRest(t);
+    if (d >= 0 && d < 0.3) {
+      s.ax = 0.02; s.ay = 0.03; s.az = 0.05;
+    }
+    return s;
+  });
+  FallDetector imu(INT_PIN);
+  settle(imu);
+  CHECK(imu.isLowPower());
+  detachInterrupt(INT_PIN);
+
+  run(imu, 11.0);
+  CHECK_EQ(mpu.getFreefallEvents(), 1);
+  CHECK(!imu.isLowPower());
+  CHECK_EQ(imu.getStats().freefallWakes, 1);
+}
+
+TEST(cambio_de_postura_despierta) {
+  FakeHal::reset();
+  FakeMpu6050 mpu(INT_PIN);
+  // A los 20 s gira la muñeca 90° despacio, sin golpes
+  mpu.setMotion([](double t) {
+    MotionSample s = FakeMpu6050::atRest(t);
+    if (t >= 20.0) {
+      double a = (t - 20.0 < 2.0 ? (t - 20.0) / 2.0 : 1.0) * M_PI / 2;
+      s.ax = sin(a); s.az = cos(a);
+    }
+    return s;
+  });
+  FallDetector imu(INT_PIN);
+  settle(imu);
+  CHECK(imu.isLowPower());
+
+  run(imu, 9.5);
+  CHECK(imu.isLowPower());
+  run(imu, 1.5);
+  CHECK(!imu.isLowPower());
+  CHECK_EQ(imu.getStats().freefallWakes, 0);
+}
+
+HOST_TEST_MAIN()
@@ -0,0 +1,176 @@
+// Las rutas de cada informe de vitales no piden memoria dinámica: la
+// pantalla (setField + flush), el registro (LOG_INFO y su volcado) y el
+// texto JSON y la trama binaria. Se cuentan las llamadas a operator new y,
+// con glibc, también a malloc/calloc/realloc, y cada ruta debe dar cero.
+
+#include "HostTest.h"
+#include "FakeHal.h"
+#include <Display.h>
+#include <Log.h>
+#include <VitalsFrame.h>
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+static std::atomic<bool> counting(false);
+static std::atomic<uint32_t> allocations(0);
+
+static void noteAllocation() {
+  if (counting.load(std::memory_order_relaxed)) allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+// glibc deja sustituir malloc y sus internos también pasan por aquí;
+// reenviamos a su implementación
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+  noteAllocation();
+  return __libc_malloc(size);
+}
+void* calloc(size_t n, size_t size) {
+  noteAllocation();
+  return __libc_calloc(n, size);
+}
+void* realloc(void* ptr, size_t size) {
+  noteAllocation();
+  return __libc_realloc(ptr, size);
+}
+void free(void* ptr) {
+  __libc_free(ptr);
+}
+}
+#endif
+
+// operator new acaba en malloc: con glibc la misma petición cuenta dos
+// veces, lo que no importa cuando lo esperado es cero
+void* operator new(size_t size) {
+  noteAllocation();
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+void operator delete(void* p) noexcept {
+  free(p);
+}
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+static void startCounting() {
+  allocations.store(0);
+  counting.store(true);
+}
+
+static uint32_t stopCounting() {
+  counting.store(false);
+  return allocations.load();
+}
+
+class OledSink : public FakeHal::I2cDevice {
+public:
+  void onWrite(const uint8_t* data, size_t len) override { (void)data; (void)len; }
+  size_t onRead(uint8_t* data, size_t len) override { memset(data, 0, len); return len; }
+};
+
+class NullPrint : public Print {
+public:
+  size_t write(uint8_t c) override { (void)c; return 1; }
+  size_t write(const uint8_t* buffer, size_t size) override { (void)buffer; return size; }
+};
+
+static const int CYCLES = 1000;
+
+TEST(el_contador_ve_las_reservas) {
+  startCounting();
+  int* p = new int(7);
+  void* q = malloc(16);
+  uint32_t n = stopCounting();
+  HostTest::keep(p);
+  HostTest::keep(q);
+  delete p;
+  free(q);
+  CHECK(n >= 2);
+}
+
+TEST(pantalla_sin_reservas) {
+  OledSink sink;
+  FakeHal::attachI2c(0x3C, &sink);
+  Display display;
+  display.init();   // el búfer de la pantalla se reserva aquí, una vez
+
+  startCounting();
+  char text[8];
+  for (int i = 0; i < CYCLES; i++) {
+    snprintf(text, sizeof(text), "%d", 40 + i % 160);
+    display.setField(FIELD_BPM, text);
+    snprintf(text, sizeof(text), "%d%%", 85 + i % 16);
+    display.setField(FIELD_SPO2, text);
+    snprintf(text, sizeof(text), "%d/%d", 100 + i % 60, 60 + i % 40);
+    display.setField(FIELD_BP, text);
+    display.setAlert(i % 7 == 0);
+    display.flush();
+  }
+  uint32_t n = stopCounting();
+  FakeHal::detachI2c(0x3C);
+
+  CHECK(display.getBytesSent() > 0);
+  CHECK_EQ(n, 0);
+}
+
+TEST(registro_sin_reservas) {
+  NullPrint out;
+  startCounting();
+  for (int i = 0; i < CYCLES; i++) {
+    LOG_INFO("BPM=%d SpO2=%d BP=%d/%d", 40 + i % 160, 85 + i % 16, 100 + i % 60, 60 + i % 40);
+    // Con el anillo lleno también se cuenta el descarte
+    if (i % 64 == 63) Log::flush(out);
+  }
+  Log::flush(out);
+  uint32_t n = stopCounting();
+
+  CHECK(Log::dropped() > 0);
+  CHECK_EQ(n, 0);
+}
+
+TEST(json_y_trama_sin_reservas) {
+  static char json[160];
+  static uint8_t frame[VITALS_FRAME_MAX_SIZE];
+  size_t bytes = 0;
+
+  startCounting();
+  for (int i = 0; i < CYCLES; i++) {
+    // El mismo texto que DeviceManager::sendVitals() en PAYLOAD_JSON
+    int n = snprintf(json, sizeof(json),
+                     "{\"device\":\"IOT-01\",\"type\":\"vitals\",\"bpm\":\"%d\",\"spo2\":\"%d\","
+                     "\"bpSystolic\":\"%d\",\"bpDiastolic\":\"%d\"}",
+                     40 + i % 160, 85 + i % 16, 100 + i % 60, 60 + i % 40);
+    bytes += (size_t)n;
+
+    VitalsFrame vitals = {};
+    vitals.type = VitalsFrame::VITALS;
+    vitals.sequence = (uint16_t)i;
+    vitals.bpm = (uint8_t)(40 + i % 160);
+    bytes += encodeVitalsFrame(vitals, frame, sizeof(frame));
+  }
+  uint32_t n = stopCounting();
+
+  CHECK(bytes > 0);
+  CHECK_EQ(n, 0);
+}
+
+HOST_TEST_MAIN()
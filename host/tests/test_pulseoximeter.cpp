@@ -0,0 +1,70 @@
+// Lectura del MAX30102 a través del anillo de 4 huecos de la librería de
+// SparkFun: a la cadencia de la tarea no se pierde ninguna muestra, y si
+// la tarea se retrasa lo perdido queda contado en getDroppedSamples().
+
+#include "HostTest.h"
+#include "FakeHal.h"
+#include "FakeDevices.h"
+#include <Pulseoximeter.h>
+
+static const uint32_t TASK_PERIOD_MS = 10;
+
+static void startSensor(Pulseoximeter& ppg) {
+  FakeHal::reset();
+  FakeMax30102::instance().reset();
+  ppg.begin();
+}
+
+static uint32_t consumed() {
+  FakeMax30102& chip = FakeMax30102::instance();
+  return chip.getProduced() - chip.pending(FakeHal::nowMicros());
+}
+
+TEST(sin_perdidas_a_la_cadencia_de_la_tarea) {
+  Pulseoximeter ppg;
+  startSensor(ppg);
+  FakeMax30102& chip = FakeMax30102::instance();
+
+  // Un minuto con la holgura que deja el planificador: a veces la pasada
+  // llega con una tarea entera de retraso
+  for (uint32_t i = 0; i < 6000; i++) {
+    FakeHal::advanceMillis(i % 7 == 0 ? 2 * TASK_PERIOD_MS : TASK_PERIOD_MS);
+    ppg.on();
+  }
+
+  CHECK(chip.getProduced() > 6000);
+  CHECK_EQ(chip.getChipOverflows(), 0);
+  CHECK_EQ(chip.getLibraryOverwrites(), 0);
+  CHECK_EQ(ppg.getDroppedSamples(), 0);
+  CHECK_EQ(consumed(), chip.getProduced());
+}
+
+TEST(con_dedo_da_pulso_y_spo2) {
+  Pulseoximeter ppg;
+  startSensor(ppg);
+  for (uint32_t i = 0; i < 3000; i++) {
+    FakeHal::advanceMillis(TASK_PERIOD_MS);
+    ppg.on();
+  }
+  CHECK(ppg.getAverageBPM() >= 65 && ppg.getAverageBPM() <= 80);
+  CHECK(ppg.getSpO2() >= 94 && ppg.getSpO2() <= 100);
+}
+
+TEST(retraso_largo_cuenta_las_perdidas) {
+  Pulseoximeter ppg;
+  startSensor(ppg);
+  FakeMax30102& chip = FakeMax30102::instance();
+
+  for (uint32_t i = 0; i < 100; i++) {
+    FakeHal::advanceMillis(TASK_PERIOD_MS);
+    ppg.on();
+  }
+  // 50 ms sin pasar: check() trae 5 muestras y el anillo guarda 3 como mucho
+  FakeHal::advanceMillis(50);
+  ppg.on();
+
+  CHECK(ppg.getDroppedSamples() > 0);
+  CHECK_EQ(ppg.getDroppedSamples(), chip.getLibraryOverwrites());
+}
+
+HOST_TEST_MAIN()
@@ -0,0 +1,156 @@
+// TaskScheduler con un reloj virtual: cada tarea avanza el reloj lo que
+// "cuesta", así el orden EDF, los plazos perdidos y los excesos de budget
+// se comprueban sin depender de la velocidad del host.
+
+#include "HostTest.h"
+#include <TaskScheduler.h>
+#include <string>
+#include <vector>
+
+static uint32_t virtualNow = 0;
+static uint32_t virtualClock() { return virtualNow; }
+
+struct FakeTask {
+  char id;
+  uint32_t costUs;
+  std::string* log;
+  std::vector<uint32_t> starts;
+};
+
+static void runFakeTask(void* ctx) {
+  FakeTask* task = static_cast<FakeTask*>(ctx);
+  if (task->log) *task->log += task->id;
+  task->starts.push_back(virtualNow);
+  virtualNow += task->costUs;
+}
+
+// Avanza el reloj en pasos de 100 us mientras no haya nada listo
+static void runUntil(TaskScheduler& scheduler, uint32_t endUs) {
+  while ((int32_t)(virtualNow - endUs) < 0) {
+    if (!scheduler.runOnce()) virtualNow += 100;
+  }
+}
+
+TEST(plazo_mas_cercano_primero) {
+  virtualNow = 0;
+  std::string log;
+  FakeTask slow = { 's', 100, &log, {} };
+  FakeTask mid = { 'm', 100, &log, {} };
+  FakeTask fast = { 'f', 100, &log, {} };
+  TaskScheduler scheduler(virtualClock);
+  scheduler.addTask("lenta", runFakeTask, &slow, 100000, 1000);
+  scheduler.addTask("media", runFakeTask, &mid, 20000, 1000);
+  scheduler.addTask("rapida", runFakeTask, &fast, 10000, 1000);
+
+  // Liberadas a la vez: el orden lo dan los plazos, no el de alta
+  for (int i = 0; i < 3; i++) CHECK(scheduler.runOnce());
+  CHECK(log == "fms");
+  CHECK(!scheduler.runOnce());
+
+  // A 10 ms solo vuelve a estar liberada la rápida; a 20 ms lo están la
+  // rápida (plazo 30 ms) y la media (plazo 40 ms)
+  log.clear();
+  runUntil(scheduler, 40000);
+  CHECK(log == "ffmf");
+}
+
+TEST(sin_liberar_no_se_ejecuta) {
+  virtualNow = 0;
+  std::string log;
+  FakeTask a = { 'a', 0, &log, {} };
+  TaskScheduler scheduler(virtualClock);
+  scheduler.addTask("a", runFakeTask, &a, 10000, 1000);
+  CHECK(scheduler.runOnce());
+  virtualNow = 9999;
+  CHECK(!scheduler.runOnce());
+  virtualNow = 10000;
+  CHECK(scheduler.runOnce());
+  CHECK(log == "aa");
+}
+
+TEST(carga_del_equipo_sin_plazos_perdidos) {
+  // Los periodos y budgets de DeviceManager con costes dentro del budget
+  virtualNow = 0;
+  FakeTask ppg = { 'p', 1500, nullptr, {} };
+  FakeTask imu = { 'i', 800, nullptr, {} };
+  FakeTask bp = { 'b', 600, nullptr, {} };
+  FakeTask alerts = { 'a', 300, nullptr, {} };
+  FakeTask report = { 'r', 400, nullptr, {} };
+  TaskScheduler scheduler(virtualClock);
+  scheduler.addTask("ppg", runFakeTask, &ppg, 10000, 2000);
+  scheduler.addTask("imu", runFakeTask, &imu, 10000, 1000);
+  scheduler.addTask("bp", runFakeTask, &bp, 10000, 1000);
+  scheduler.addTask("alertas", runFakeTask, &alerts, 20000, 1000);
+  scheduler.addTask("reporte", runFakeTask, &report, 100000, 500);
+  runUntil(scheduler, 1000000);
+
+  for (uint8_t i = 0; i < scheduler.getTaskCount(); i++) {
+    const TaskScheduler::TaskStats& st = scheduler.getStats(i);
+    CHECK_EQ(st.runs, 1000000 / st.periodUs);
+    CHECK_EQ(st.deadlineMisses, 0);
+    CHECK_EQ(st.budgetOverruns, 0);
+  }
+  CHECK_EQ(scheduler.getBusyUs(),
+           100 * 1500 + 100 * 800 + 100 * 600 + 50 * 300 + 10 * 400);
+  CHECK(scheduler.getIdleUs() > 0);
+}
+
+TEST(exceso_de_budget_y_plazo_perdido) {
+  virtualNow = 0;
+  std::string log;
+  FakeTask fast = { 'f', 500, &log, {} };
+  FakeTask heavy = { 'h', 25000, &log, {} };
+  TaskScheduler scheduler(virtualClock);
+  scheduler.addTask("rapida", runFakeTask, &fast, 10000, 1000);
+  scheduler.addTask("pesada", runFakeTask, &heavy, 50000, 2000);
+  runUntil(scheduler, 200000);
+
+  const TaskScheduler::TaskStats& f = scheduler.getStats(0);
+  const TaskScheduler::TaskStats& h = scheduler.getStats(1);
+  CHECK_EQ(h.budgetOverruns, h.runs);
+  CHECK_EQ(h.maxRunUs, 25000);
+  CHECK_EQ(h.deadlineMisses, 0);
+  // La pesada bloquea a la rápida dos periodos y medio: pierde plazos,
+  // pero se salta las liberaciones atrasadas en vez de encadenar una
+  // ejecución por cada una
+  CHECK(f.deadlineMisses > 0);
+  size_t burst = 1, longestBurst = 1;
+  for (size_t i = 1; i < fast.starts.size(); i++) {
+    burst = fast.starts[i] - fast.starts[i - 1] == fast.costUs ? burst + 1 : 1;
+    if (burst > longestBurst) longestBurst = burst;
+  }
+  CHECK(longestBurst <= 2);
+  CHECK_EQ(f.budgetOverruns, 0);
+}
+
+TEST(vuelta_del_contador_de_microsegundos) {
+  const uint32_t start = 0xFFFFFFFFUL - 15000;
+  virtualNow = start;
+  std::string log;
+  FakeTask slow = { 's', 100, &log, {} };
+  FakeTask fast = { 'f', 100, &log, {} };
+  TaskScheduler scheduler(virtualClock);
+  scheduler.addTask("lenta", runFakeTask, &slow, 30000, 1000);
+  scheduler.addTask("rapida", runFakeTask, &fast, 10000, 1000);
+  runUntil(scheduler, start + 60000);
+  CHECK(log == "fsfffsff");
+  CHECK_EQ(scheduler.getStats(0).deadlineMisses, 0);
+  CHECK_EQ(scheduler.getStats(1).deadlineMisses, 0);
+}
+
+TEST(reset_de_estadisticas) {
+  virtualNow = 0;
+  FakeTask a = { 'a', 3000, nullptr, {} };
+  TaskScheduler scheduler(virtualClock);
+  scheduler.addTask("a", runFakeTask, &a, 10000, 1000);
+  runUntil(scheduler, 50000);
+  CHECK(scheduler.getStats(0).runs > 0);
+  scheduler.resetStats();
+  CHECK_EQ(scheduler.getStats(0).runs, 0);
+  CHECK_EQ(scheduler.getStats(0).budgetOverruns, 0);
+  CHECK_EQ(scheduler.getStats(0).maxRunUs, 0);
+  CHECK_EQ(scheduler.getBusyUs(), 0);
+  CHECK_EQ(scheduler.getIdleUs(), 0);
+}
+
+HOST_TEST_MAIN()
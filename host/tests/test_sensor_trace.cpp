@@ -0,0 +1,144 @@
+// Escritor de trazas: los lotes fechados hacia atrás de cada sensor salen
+// ordenados por tiempo, lo que llega demasiado tarde no hace retroceder el
+// reloj, y un registro que no cabe en la cola no rompe la decodificación.
+
+#include "HostTest.h"
+#include <SensorTrace.h>
+#include <vector>
+
+class MemoryPrint : public Print {
+public:
+  std::vector<uint8_t> bytes;
+  size_t write(uint8_t c) override { bytes.push_back(c); return 1; }
+};
+
+class MemorySource : public TraceSource {
+public:
+  explicit MemorySource(const std::vector<uint8_t>& bytes) : _bytes(bytes), _pos(0) {}
+  int read() override { return _pos < _bytes.size() ? _bytes[_pos++] : -1; }
+
+private:
+  const std::vector<uint8_t>& _bytes;
+  size_t _pos;
+};
+
+// Vacío si la cabecera no valida o la traza está corrupta
+static std::vector<TraceRecord> decode(const std::vector<uint8_t>& bytes) {
+  std::vector<TraceRecord> out;
+  MemorySource source(bytes);
+  SensorTraceReader reader(source);
+  if (!reader.begin()) return out;
+  TraceRecord rec;
+  while (reader.next(rec)) out.push_back(rec);
+  if (reader.isCorrupt()) out.clear();
+  return out;
+}
+
+static void recordPpg(SensorTraceWriter& writer, uint32_t us, int32_t ir) {
+  int32_t values[2] = { ir / 2, ir };
+  writer.record(TRACE_PPG, us, values);
+}
+
+static void recordHx711(SensorTraceWriter& writer, uint32_t us, int32_t counts) {
+  writer.record(TRACE_HX711, us, &counts);
+}
+
+TEST(lotes_desordenados_salen_por_tiempo) {
+  MemoryPrint out;
+  SensorTraceWriter writer;
+  writer.begin(out);
+
+  // Cada sensor en orden, pero los lotes se cruzan: el HX711 se vacía
+  // después con muestras anteriores
+  recordPpg(writer, 20000, 200);
+  recordPpg(writer, 30000, 300);
+  recordHx711(writer, 15000, 150);
+  recordHx711(writer, 27500, 275);
+  recordPpg(writer, 40000, 400);
+  writer.end();
+
+  std::vector<TraceRecord> recs = decode(out.bytes);
+  CHECK_EQ(recs.size(), 5);
+  const uint32_t expectedUs[] = { 15000, 20000, 27500, 30000, 40000 };
+  const uint8_t expectedChannel[] = { TRACE_HX711, TRACE_PPG, TRACE_HX711, TRACE_PPG, TRACE_PPG };
+  for (size_t i = 0; i < recs.size() && i < 5; i++) {
+    CHECK_EQ(recs[i].timestampUs, expectedUs[i]);
+    CHECK_EQ(recs[i].channel, expectedChannel[i]);
+    int32_t value = recs[i].channel == TRACE_PPG ? recs[i].values[1] : recs[i].values[0];
+    CHECK_EQ(value, (int32_t)(expectedUs[i] / 100));
+  }
+  CHECK_EQ(writer.getClamped(), 0);
+}
+
+TEST(muestra_demasiado_tarde_no_retrocede) {
+  MemoryPrint out;
+  SensorTraceWriter writer;
+  writer.begin(out);
+
+  for (uint32_t i = 0; i <= 20; i++) {
+    recordPpg(writer, 1000000 + i * 10000, (int32_t)i);
+  }
+  // Más de REORDER_US por detrás de lo último visto
+  recordHx711(writer, 1000000, 7);
+  writer.end();
+
+  std::vector<TraceRecord> recs = decode(out.bytes);
+  CHECK_EQ(recs.size(), 22);
+  CHECK_EQ(writer.getClamped(), 1);
+  for (size_t i = 1; i < recs.size(); i++) {
+    CHECK(recs[i].timestampUs >= recs[i - 1].timestampUs);
+  }
+}
+
+TEST(tiempo_con_vuelta_de_micros) {
+  MemoryPrint out;
+  SensorTraceWriter writer;
+  writer.begin(out);
+
+  uint32_t start = 0xFFFFFFFFu - 25000;
+  recordPpg(writer, start + 20000, 1);
+  recordHx711(writer, start + 10000, 2);
+  recordPpg(writer, start + 30000, 3);   // ya pasó la vuelta
+  recordHx711(writer, start + 22500, 4);
+  writer.end();
+
+  std::vector<TraceRecord> recs = decode(out.bytes);
+  CHECK_EQ(recs.size(), 4);
+  for (size_t i = 1; i < recs.size(); i++) {
+    CHECK(recs[i].timestampUs > recs[i - 1].timestampUs);
+  }
+  CHECK_EQ(recs.back().timestampUs - recs.front().timestampUs, 20000);
+  CHECK_EQ(writer.getClamped(), 0);
+}
+
+TEST(cola_llena_descarta_registros_enteros) {
+  TraceBuffer buffer;
+  SensorTraceWriter writer;
+  writer.begin(buffer);
+
+  // Nadie vacía la cola: a partir de cierto punto los registros no caben
+  const uint32_t SAMPLES = 5000;
+  for (uint32_t i = 0; i < SAMPLES; i++) {
+    recordHx711(writer, i * 12500, (int32_t)(i * 1000));
+  }
+  writer.end();
+  CHECK(writer.getDropped() > 0);
+  CHECK_EQ(writer.getRecordCount() + writer.getDropped(), SAMPLES);
+
+  std::vector<uint8_t> bytes;
+  uint8_t chunk[64];
+  size_t n;
+  while ((n = buffer.read(chunk, sizeof(chunk))) > 0) {
+    bytes.insert(bytes.end(), chunk, chunk + n);
+  }
+  CHECK_EQ(bytes.size(), writer.getBytesWritten());
+
+  // Lo que salió decodifica con su tiempo y su valor de origen
+  std::vector<TraceRecord> recs = decode(bytes);
+  CHECK_EQ(recs.size(), writer.getRecordCount());
+  for (size_t i = 0; i < recs.size(); i++) {
+    CHECK_EQ(recs[i].timestampUs / 12500 * 1000, (uint64_t)recs[i].values[0]);
+  }
+}
+
+HOST_TEST_MAIN()
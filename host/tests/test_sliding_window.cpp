@@ -0,0 +1,124 @@
+// SlidingWindowStats frente al recorrido ingenuo de la ventana que
+// sustituyó: mismos máximos, mínimos y sumas en cada muestra, y el coste
+// por muestra de ambos con ventanas de 20, 200 y 2000.
+
+#include "HostTest.h"
+#include <SlidingWindowStats.h>
+#include <random>
+#include <vector>
+
+static const size_t SAMPLES = 100000;
+
+// Lo que hacía el firmware: guardar la ventana y recorrerla en cada consulta
+template <size_t N>
+class NaiveWindow {
+public:
+  NaiveWindow() : _index(0), _count(0) {}
+
+  void push(long value) {
+    _values[_index] = value;
+    _index = (_index + 1) % N;
+    if (_count < N) _count++;
+  }
+
+  long getMax() const {
+    long m = _values[0];
+    for (size_t i = 1; i < _count; i++) if (_values[i] > m) m = _values[i];
+    return m;
+  }
+
+  long getMin() const {
+    long m = _values[0];
+    for (size_t i = 1; i < _count; i++) if (_values[i] < m) m = _values[i];
+    return m;
+  }
+
+  long getSum() const {
+    long s = 0;
+    for (size_t i = 0; i < _count; i++) s += _values[i];
+    return s;
+  }
+
+private:
+  long _values[N];
+  size_t _index;
+  size_t _count;
+};
+
+static std::vector<long> signal(size_t n) {
+  // Valores repetidos a propósito: los empates son el caso delicado del deque
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<long> dist(60, 180);
+  std::vector<long> xs(n);
+  for (size_t i = 0; i < n; i++) xs[i] = dist(rng);
+  return xs;
+}
+
+template <size_t N>
+static bool equivalent(const std::vector<long>& xs) {
+  NaiveWindow<N> naive;
+  SlidingWindowStats<long, N, long> stats;
+  for (size_t i = 0; i < xs.size(); i++) {
+    naive.push(xs[i]);
+    stats.push(xs[i]);
+    if (stats.getMax() != naive.getMax() || stats.getMin() != naive.getMin() ||
+        stats.getSum() != naive.getSum()) {
+      printf("  ventana %zu: difiere en la muestra %zu\n", N, i);
+      return false;
+    }
+  }
+  return true;
+}
+
+template <size_t N>
+static void bench(const std::vector<long>& xs) {
+  static NaiveWindow<N> naive;
+  static SlidingWindowStats<long, N, long> stats;
+  double naiveNs = HostTest::nsPerIteration(xs.size(), [&](size_t i) {
+    naive.push(xs[i]);
+    HostTest::keep(naive.getMax() + naive.getMin() + naive.getSum());
+  });
+  double streamNs = HostTest::nsPerIteration(xs.size(), [&](size_t i) {
+    stats.push(xs[i]);
+    HostTest::keep(stats.getMax() + stats.getMin() + stats.getSum());
+  });
+  BENCH("ventana %4zu: recorrido %9.1f ns/muestra, SlidingWindowStats %6.1f ns/muestra\n",
+        N, naiveNs, streamNs);
+}
+
+TEST(mismos_resultados_que_el_recorrido) {
+  std::vector<long> xs = signal(SAMPLES);
+  CHECK(equivalent<20>(xs));
+  CHECK(equivalent<200>(xs));
+  CHECK(equivalent<2000>(xs));
+}
+
+TEST(ventana_monotona_y_constante) {
+  // Subidas y bajadas largas vacían y llenan el deque entero
+  std::vector<long> xs;
+  for (long v = 0; v < 500; v++) xs.push_back(v);
+  for (long v = 500; v > 0; v--) xs.push_back(v);
+  for (int i = 0; i < 500; i++) xs.push_back(7);
+  CHECK(equivalent<20>(xs));
+  CHECK(equivalent<200>(xs));
+}
+
+TEST(reset_vacia_la_ventana) {
+  SlidingWindowStats<long, 20, long> stats;
+  for (long v = 1; v <= 50; v++) stats.push(v);
+  stats.reset();
+  CHECK_EQ(stats.getCount(), 0);
+  stats.push(-3);
+  CHECK_EQ(stats.getMax(), -3);
+  CHECK_EQ(stats.getMin(), -3);
+  CHECK_EQ(stats.getSum(), -3);
+}
+
+TEST(coste_por_muestra) {
+  std::vector<long> xs = signal(SAMPLES);
+  bench<20>(xs);
+  bench<200>(xs);
+  bench<2000>(xs);
+}
+
+HOST_TEST_MAIN()
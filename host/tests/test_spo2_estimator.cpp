@@ -0,0 +1,128 @@
+// SpO2Estimator frente a calculateSpO2FromBuffers(), el cálculo por lotes
+// que sustituyó: el mismo valor sobre cada ventana que publica, y el coste
+// por muestra de ambos.
+
+#include "HostTest.h"
+#include <SpO2Estimator.h>
+#include <limits.h>
+#include <math.h>
+#include <random>
+#include <vector>
+
+static const size_t SAMPLES = 100000;
+static const size_t WINDOW = SpO2Estimator::WINDOW;
+
+// Copia del cálculo por lotes que tenía Pulseoximeter.cpp
+static int batchSpO2(const long* red, const long* ir, size_t len) {
+  if (len == 0) return -1;
+
+  long minR = LONG_MAX, maxR = LONG_MIN;
+  long minIR = LONG_MAX, maxIR = LONG_MIN;
+  long sumR = 0, sumIR = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    sumR += red[i];
+    sumIR += ir[i];
+    if (red[i] < minR) minR = red[i];
+    if (red[i] > maxR) maxR = red[i];
+    if (ir[i] < minIR) minIR = ir[i];
+    if (ir[i] > maxIR) maxIR = ir[i];
+  }
+
+  float dcR = (float)sumR / len;
+  float dcIR = (float)sumIR / len;
+  float acR = (float)(maxR - minR);
+  float acIR = (float)(maxIR - minIR);
+
+  if (dcR <= 0.0f || dcIR <= 0.0f || acIR <= 0.0f) return -1;
+  float ratio = (acR / dcR) / (acIR / dcIR);
+  float spo2 = 110.0f - 25.0f * ratio;
+  if (spo2 > 100.0f) spo2 = 100.0f;
+  if (spo2 < 0.0f) spo2 = 0.0f;
+
+  return (int)round(spo2);
+}
+
+// Pulso de 75 lpm a 100 Hz con ruido, como sale del MAX30102
+struct Signal {
+  std::vector<long> red;
+  std::vector<long> ir;
+};
+
+static Signal ppgSignal(size_t n) {
+  std::mt19937 rng(7);
+  std::normal_distribution<float> noise(0.0f, 150.0f);
+  Signal s;
+  s.red.resize(n);
+  s.ir.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    float phase = sinf(i * 2.0f * (float)M_PI / 80.0f);
+    s.red[i] = 90000 + (long)(800.0f * phase + noise(rng));
+    s.ir[i] = 110000 + (long)(1500.0f * phase + noise(rng));
+  }
+  return s;
+}
+
+static bool matchesBatch(const Signal& s, uint16_t hop, size_t& compared) {
+  SpO2Estimator estimator(hop);
+  compared = 0;
+  for (size_t i = 0; i < s.ir.size(); i++) {
+    if (!estimator.push(s.red[i], s.ir[i])) continue;
+    size_t first = i + 1 - WINDOW;
+    int expected = batchSpO2(&s.red[first], &s.ir[first], WINDOW);
+    if (estimator.getValue() != expected) {
+      printf("  salto %u, muestra %zu: %d en vez de %d\n", hop, i, estimator.getValue(), expected);
+      return false;
+    }
+    compared++;
+  }
+  return true;
+}
+
+TEST(mismo_valor_que_el_lote) {
+  Signal s = ppgSignal(SAMPLES);
+  size_t compared;
+  CHECK(matchesBatch(s, 10, compared));
+  CHECK_EQ(compared, (SAMPLES - WINDOW) / 10 + 1);
+  CHECK(matchesBatch(s, 1, compared));
+  CHECK_EQ(compared, SAMPLES - WINDOW + 1);
+  // El salto del firmware original: una ventana nueva cada WINDOW muestras
+  CHECK(matchesBatch(s, WINDOW, compared));
+}
+
+TEST(sin_ventana_completa_no_publica) {
+  SpO2Estimator estimator(10);
+  for (size_t i = 0; i + 1 < WINDOW; i++) CHECK(!estimator.push(90000, 110000));
+  CHECK(!estimator.isReady());
+  CHECK_EQ(estimator.getValue(), -1);
+  CHECK(estimator.push(90000, 110000));
+  // Señal plana: sin componente alterna en IR no hay valor
+  CHECK_EQ(estimator.getValue(), -1);
+}
+
+TEST(coste_por_muestra) {
+  Signal s = ppgSignal(SAMPLES);
+  const size_t n = SAMPLES - WINDOW;
+
+  // Lote cada 100 muestras (el firmware original), cada 10 (lo publicado
+  // ahora) y en cada muestra
+  double batch100 = HostTest::nsPerIteration(n, [&](size_t i) {
+    if (i % WINDOW == 0) HostTest::keep(batchSpO2(&s.red[i], &s.ir[i], WINDOW));
+  });
+  double batch10 = HostTest::nsPerIteration(n, [&](size_t i) {
+    if (i % 10 == 0) HostTest::keep(batchSpO2(&s.red[i], &s.ir[i], WINDOW));
+  });
+  double batch1 = HostTest::nsPerIteration(n, [&](size_t i) {
+    HostTest::keep(batchSpO2(&s.red[i], &s.ir[i], WINDOW));
+  });
+  SpO2Estimator estimator(10);
+  double stream10 = HostTest::nsPerIteration(n, [&](size_t i) {
+    if (estimator.push(s.red[i], s.ir[i])) HostTest::keep(estimator.getValue());
+  });
+
+  BENCH("lote cada 100: %.1f, cada 10: %.1f, en cada muestra: %.1f ns/muestra\n",
+        batch100, batch10, batch1);
+  BENCH("SpO2Estimator publicando cada 10: %.1f ns/muestra\n", stream10);
+}
+
+HOST_TEST_MAIN()
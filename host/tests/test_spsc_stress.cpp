@@ -0,0 +1,197 @@
+// La cola y el seqlock entre núcleos con dos hilos reales: uno hace de
+// adquisición (núcleo 1) y otro de comunicaciones (núcleo 0). Cada valor
+// lleva campos derivados de su número de serie, así una lectura a medias
+// se detecta.
+
+#include "HostTest.h"
+#include <SpscRing.h>
+#include <SeqLock.h>
+#include <DeviceManager.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static const uint32_t EVENTS = 200000;
+
+// Cede el procesador al otro hilo; yield() no basta cuando el host tiene
+// un solo núcleo
+static void backOff() {
+  std::this_thread::sleep_for(std::chrono::microseconds(20));
+}
+
+static VitalsSnapshot makeVitals(uint32_t seq) {
+  VitalsSnapshot vitals;
+  vitals.bpm = (int)(seq * 3);
+  vitals.spo2 = (int)(seq % 101);
+  vitals.systolic = (int)(seq ^ 0x5A5A);
+  vitals.diastolic = (int)~seq;
+  vitals.pulseCount = seq * 2654435761UL;
+  vitals.timestampMs = seq;
+  vitals.alert = (seq & 1) != 0;
+  return vitals;
+}
+
+static bool intact(const VitalsSnapshot& vitals) {
+  VitalsSnapshot expected = makeVitals(vitals.timestampMs);
+  return vitals.bpm == expected.bpm &&
+         vitals.spo2 == expected.spo2 &&
+         vitals.systolic == expected.systolic &&
+         vitals.diastolic == expected.diastolic &&
+         vitals.pulseCount == expected.pulseCount &&
+         vitals.alert == expected.alert;
+}
+
+// DeviceEvent solo lleva tipo y hora; para que un hueco a medias se note
+// la cola transporta el evento con una instantánea completa detrás
+struct StressEvent {
+  DeviceEvent event;
+  VitalsSnapshot vitals;
+};
+
+static StressEvent makeEvent(uint32_t seq) {
+  StressEvent item = {};
+  item.event.type = (seq % 7 == 0) ? DeviceEvent::FALL : DeviceEvent::VITALS;
+  item.event.timestampMs = seq;
+  item.vitals = makeVitals(seq);
+  return item;
+}
+
+static bool intact(const StressEvent& item) {
+  DeviceEvent::Type type = (item.event.timestampMs % 7 == 0) ? DeviceEvent::FALL : DeviceEvent::VITALS;
+  return item.event.type == type &&
+         item.vitals.timestampMs == item.event.timestampMs &&
+         intact(item.vitals);
+}
+
+TEST(sin_perdidas_si_el_productor_reintenta) {
+  SpscRing<StressEvent, 16> ring;
+  std::thread producer([&] {
+    for (uint32_t seq = 0; seq < EVENTS;) {
+      if (ring.push(makeEvent(seq))) seq++;
+      else backOff();
+    }
+  });
+
+  uint32_t next = 0;
+  bool ordered = true, whole = true;
+  while (next < EVENTS) {
+    StressEvent event;
+    if (!ring.pop(event)) continue;
+    if (event.event.timestampMs != next) ordered = false;
+    if (!intact(event)) whole = false;
+    next++;
+  }
+  producer.join();
+
+  CHECK(ordered);
+  CHECK(whole);
+  CHECK(ring.empty());
+}
+
+// Como publishEvent(): la adquisición nunca espera y lo que no cabe se
+// descarta y se cuenta. Lo que llega tiene que llegar entero y en orden.
+TEST(descartes_contados_y_orden_conservado) {
+  SpscRing<StressEvent, 16> ring;
+  std::atomic<bool> done(false);
+  std::thread producer([&] {
+    for (uint32_t seq = 0; seq < EVENTS; seq++) {
+      ring.push(makeEvent(seq));
+      // A ráfagas, como los informes de la adquisición
+      if (seq % 64 == 63) backOff();
+    }
+    done.store(true);
+  });
+
+  uint32_t received = 0;
+  int64_t last = -1;
+  bool ordered = true, whole = true;
+  for (;;) {
+    bool finished = done.load();
+    StressEvent event;
+    while (ring.pop(event)) {
+      if ((int64_t)event.event.timestampMs <= last) ordered = false;
+      if (!intact(event)) whole = false;
+      last = event.event.timestampMs;
+      received++;
+    }
+    if (finished) break;
+  }
+  producer.join();
+
+  CHECK(ordered);
+  CHECK(whole);
+  CHECK_EQ(received + ring.dropped(), EVENTS);
+  printf("  %lu recibidos, %lu descartados\n", (unsigned long)received, (unsigned long)ring.dropped());
+}
+
+TEST(clear_desde_el_consumidor) {
+  SpscRing<long, 32> ring;
+  std::atomic<bool> done(false);
+  std::thread producer([&] {
+    for (long i = 0; i < 200000;) {
+      if (ring.push(i)) i++;
+      else backOff();
+    }
+    done.store(true);
+  });
+
+  // Tras clear() solo pueden salir valores posteriores a los ya vistos
+  long last = -1, got = 0;
+  bool ordered = true;
+  for (;;) {
+    bool finished = done.load();
+    long value;
+    while (ring.pop(value)) {
+      if (value <= last) ordered = false;
+      last = value;
+      if (++got % 1000 == 0) ring.clear();
+    }
+    if (finished) break;
+  }
+  producer.join();
+  CHECK(ordered);
+}
+
+// Como reportVitals()/sendVitals(): la adquisición reescribe latestVitals
+// sin esperar y comunicaciones lo lee cuando le llega el aviso. Una lectura
+// que devuelve true nunca mezcla dos escrituras, ni va hacia atrás.
+TEST(seqlock_sin_lecturas_a_medias) {
+  SeqLock<VitalsSnapshot> latest;
+  std::atomic<bool> done(false);
+  std::thread producer([&] {
+    for (uint32_t seq = 1; seq <= EVENTS; seq++) {
+      latest.write(makeVitals(seq));
+      if (seq % 64 == 63) backOff();
+    }
+    done.store(true);
+  });
+
+  uint32_t reads = 0, failed = 0, last = 0;
+  bool whole = true, ordered = true;
+  for (;;) {
+    bool finished = done.load();
+    VitalsSnapshot vitals;
+    if (latest.version() > 0) {
+      if (latest.read(vitals)) {
+        if (!intact(vitals)) whole = false;
+        if (vitals.timestampMs < last) ordered = false;
+        last = vitals.timestampMs;
+        reads++;
+      } else {
+        failed++;
+      }
+    }
+    if (finished) break;
+  }
+  producer.join();
+
+  VitalsSnapshot final;
+  CHECK(latest.read(final));
+  CHECK_EQ(final.timestampMs, EVENTS);
+  CHECK_EQ(latest.version(), EVENTS);
+  CHECK(whole);
+  CHECK(ordered);
+  printf("  %lu lecturas, %lu abandonadas\n", (unsigned long)reads, (unsigned long)failed);
+}
+
+HOST_TEST_MAIN()
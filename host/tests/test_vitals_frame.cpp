@@ -0,0 +1,140 @@
+// Trama binaria de vitales: ida y vuelta de VITALS y FALL_ALERT, rechazo de
+// versión, tipo y longitud malos, y lo que cuesta frente al JSON que se
+// enviaba antes (tiempo de codificación y bytes por notificación).
+
+#include "HostTest.h"
+#include <VitalsFrame.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static VitalsFrame makeVitals(uint16_t seq) {
+  VitalsFrame frame = {};
+  frame.type = VitalsFrame::VITALS;
+  frame.sequence = seq;
+  frame.timestampMs = 0x89ABCDEFUL + seq;
+  frame.bpm = (uint8_t)(60 + seq % 120);
+  frame.spo2 = (uint8_t)(85 + seq % 16);
+  frame.systolic = (int16_t)(110 + seq % 40);
+  frame.diastolic = (int16_t)(70 + seq % 25);
+  frame.flags = VitalsFrame::FLAG_BP_VALID;
+  return frame;
+}
+
+static bool sameVitals(const VitalsFrame& a, const VitalsFrame& b) {
+  return a.type == b.type && a.sequence == b.sequence && a.timestampMs == b.timestampMs &&
+         a.bpm == b.bpm && a.spo2 == b.spo2 && a.systolic == b.systolic &&
+         a.diastolic == b.diastolic && a.flags == b.flags;
+}
+
+// El mismo texto que DeviceManager::sendVitals() en PAYLOAD_JSON
+static int encodeJson(const VitalsFrame& frame, char* out, size_t len) {
+  return snprintf(out, len,
+                  "{\"device\":\"IOT-01\",\"type\":\"vitals\",\"bpm\":\"%d\",\"spo2\":\"%d\","
+                  "\"bpSystolic\":\"%d\",\"bpDiastolic\":\"%d\"}",
+                  frame.bpm, frame.spo2, frame.systolic, frame.diastolic);
+}
+
+TEST(vitales_ida_y_vuelta) {
+  VitalsFrame in = makeVitals(0xBEEF);
+  in.systolic = -1;   // negativos en int16
+  in.diastolic = 300;
+  in.flags = VitalsFrame::FLAG_ALERT | VitalsFrame::FLAG_BP_VALID;
+
+  uint8_t buf[VITALS_FRAME_MAX_SIZE];
+  CHECK_EQ(encodeVitalsFrame(in, buf, sizeof(buf)), VITALS_FRAME_VITALS_SIZE);
+  CHECK_EQ(buf[0], VITALS_FRAME_VERSION);
+  CHECK_EQ(buf[2], 0xEF);   // little-endian
+  CHECK_EQ(buf[3], 0xBE);
+
+  VitalsFrame out;
+  CHECK(decodeVitalsFrame(buf, VITALS_FRAME_VITALS_SIZE, out));
+  CHECK(sameVitals(in, out));
+}
+
+TEST(sin_spo2_y_sin_flags) {
+  VitalsFrame in = makeVitals(7);
+  in.spo2 = VITALS_FRAME_NO_SPO2;
+  in.flags = 0;
+
+  uint8_t buf[VITALS_FRAME_MAX_SIZE];
+  CHECK_EQ(encodeVitalsFrame(in, buf, sizeof(buf)), VITALS_FRAME_VITALS_SIZE);
+  VitalsFrame out;
+  CHECK(decodeVitalsFrame(buf, VITALS_FRAME_VITALS_SIZE, out));
+  CHECK_EQ(out.spo2, VITALS_FRAME_NO_SPO2);
+  CHECK_EQ(out.flags, 0);
+  CHECK(sameVitals(in, out));
+}
+
+TEST(alerta_de_caida_ida_y_vuelta) {
+  VitalsFrame in = {};
+  in.type = VitalsFrame::FALL_ALERT;
+  in.sequence = 42;
+  in.timestampMs = 123456789UL;
+
+  uint8_t buf[VITALS_FRAME_MAX_SIZE];
+  CHECK_EQ(encodeVitalsFrame(in, buf, sizeof(buf)), VITALS_FRAME_HEADER_SIZE);
+  VitalsFrame out;
+  CHECK(decodeVitalsFrame(buf, VITALS_FRAME_HEADER_SIZE, out));
+  CHECK_EQ(out.type, VitalsFrame::FALL_ALERT);
+  CHECK_EQ(out.sequence, 42);
+  CHECK_EQ(out.timestampMs, 123456789UL);
+}
+
+TEST(sin_espacio_no_codifica) {
+  uint8_t buf[VITALS_FRAME_MAX_SIZE];
+  CHECK_EQ(encodeVitalsFrame(makeVitals(1), buf, VITALS_FRAME_VITALS_SIZE - 1), 0);
+  VitalsFrame alert = {};
+  alert.type = VitalsFrame::FALL_ALERT;
+  CHECK_EQ(encodeVitalsFrame(alert, buf, VITALS_FRAME_HEADER_SIZE - 1), 0);
+}
+
+TEST(rechaza_version_tipo_y_longitud) {
+  uint8_t buf[VITALS_FRAME_MAX_SIZE];
+  CHECK_EQ(encodeVitalsFrame(makeVitals(3), buf, sizeof(buf)), VITALS_FRAME_VITALS_SIZE);
+  VitalsFrame out;
+
+  uint8_t bad[VITALS_FRAME_MAX_SIZE];
+  memcpy(bad, buf, sizeof(bad));
+  bad[0] = VITALS_FRAME_VERSION + 1;
+  CHECK(!decodeVitalsFrame(bad, sizeof(bad), out));
+
+  memcpy(bad, buf, sizeof(bad));
+  bad[1] = 0x7F;
+  CHECK(!decodeVitalsFrame(bad, sizeof(bad), out));
+
+  // Vitales cortados a la cabecera, y menos que la cabecera
+  CHECK(!decodeVitalsFrame(buf, VITALS_FRAME_VITALS_SIZE - 1, out));
+  CHECK(!decodeVitalsFrame(buf, VITALS_FRAME_HEADER_SIZE, out));
+  CHECK(!decodeVitalsFrame(buf, VITALS_FRAME_HEADER_SIZE - 1, out));
+  CHECK(!decodeVitalsFrame(buf, 0, out));
+}
+
+TEST(medida_binario_frente_a_json) {
+  const size_t n = 1 << 16;
+  std::vector<VitalsFrame> frames(256);
+  for (size_t i = 0; i < frames.size(); i++) frames[i] = makeVitals((uint16_t)i);
+
+  static uint8_t frame[VITALS_FRAME_MAX_SIZE];
+  size_t binaryBytes = 0;
+  double binaryNs = HostTest::nsPerIteration(n, [&](size_t i) {
+    size_t len = encodeVitalsFrame(frames[i & 0xFF], frame, sizeof(frame));
+    binaryBytes += len;
+    HostTest::keep(frame[len - 1]);
+  });
+
+  static char json[160];
+  size_t jsonBytes = 0;
+  double jsonNs = HostTest::nsPerIteration(n, [&](size_t i) {
+    int len = encodeJson(frames[i & 0xFF], json, sizeof(json));
+    jsonBytes += (size_t)len;
+    HostTest::keep(json[len - 1]);
+  });
+
+  CHECK(binaryBytes == n * VITALS_FRAME_VITALS_SIZE);
+  CHECK(jsonBytes > binaryBytes);
+  BENCH("binario: %.1f ns, %zu bytes por trama\n", binaryNs, binaryBytes / n);
+  BENCH("JSON:    %.1f ns, %.1f bytes por trama\n", jsonNs, jsonBytes / (double)n);
+}
+
+HOST_TEST_MAIN()
@@ -0,0 +1,348 @@
+// Registro offline en segmentos: entrega en orden entre segmentos, lleno
+// borra el segmento más antiguo entero, un corte de luz solo pierde lo no
+// sincronizado, un registro a medias no estropea lo que viene detrás y lo
+// enviado sin confirmar se reenvía.
+
+#include "HostTest.h"
+#include <VitalsLog.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+
+// Segmentos en memoria. Lo que sobrevive a un corte es lo sincronizado;
+// crear y borrar segmentos se da por persistente al momento.
+class MemoryLogStorage : public LogStorage {
+public:
+  typedef std::map<uint32_t, std::vector<uint8_t> > Segments;
+
+  Segments live;
+  Segments synced;
+  uint32_t syncs = 0;
+  bool failNextAppend = false;
+
+  bool begin() override { _open = false; return true; }
+
+  size_t listSegments(uint32_t* ids, size_t max) override {
+    std::vector<uint32_t> all;
+    for (Segments::const_iterator it = live.begin(); it != live.end(); ++it) all.push_back(it->first);
+    size_t first = all.size() > max ? all.size() - max : 0;
+    for (size_t i = first; i < all.size(); i++) ids[i - first] = all[i];
+    return all.size() - first;
+  }
+
+  bool create(uint32_t id) override {
+    live[id].clear();
+    synced[id].clear();
+    _openId = id;
+    _open = true;
+    return true;
+  }
+
+  bool append(const void* data, size_t len) override {
+    if (!_open) return false;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    if (failNextAppend) {
+      // Se queda a medio escribir
+      failNextAppend = false;
+      live[_openId].insert(live[_openId].end(), bytes, bytes + len / 2);
+      return false;
+    }
+    live[_openId].insert(live[_openId].end(), bytes, bytes + len);
+    return true;
+  }
+
+  bool sync() override {
+    if (!_open) return false;
+    synced[_openId] = live[_openId];
+    syncs++;
+    return true;
+  }
+
+  size_t size(uint32_t id) override {
+    Segments::const_iterator it = live.find(id);
+    return it == live.end() ? 0 : it->second.size();
+  }
+
+  bool read(uint32_t id, size_t offset, void* data, size_t len) override {
+    Segments::const_iterator it = live.find(id);
+    if (it == live.end() || offset + len > it->second.size()) return false;
+    memcpy(data, &it->second[offset], len);
+    return true;
+  }
+
+  bool remove(uint32_t id) override {
+    live.erase(id);
+    synced.erase(id);
+    return true;
+  }
+
+  // Corte de luz: se pierde lo no sincronizado, salvo `tornBytes` de la
+  // cola del segmento abierto que llegaron a la flash
+  void powerLoss(size_t tornBytes = 0) {
+    if (_open && tornBytes > 0) {
+      std::vector<uint8_t>& tail = live[_openId];
+      std::vector<uint8_t>& kept = synced[_openId];
+      size_t keep = kept.size() + tornBytes;
+      if (keep <= tail.size()) kept.assign(tail.begin(), tail.begin() + keep);
+    }
+    live = synced;
+    _open = false;
+  }
+
+private:
+  uint32_t _openId = 0;
+  bool _open = false;
+};
+
+class MemoryCalibrationStore : public CalibrationStore {
+public:
+  bool begin() override { return true; }
+  bool read(const char* key, void* data, size_t len) override {
+    std::map<std::string, std::vector<uint8_t> >::const_iterator it = _records.find(key);
+    if (it == _records.end() || it->second.size() != len) return false;
+    memcpy(data, it->second.data(), len);
+    return true;
+  }
+  bool write(const char* key, const void* data, size_t len) override {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    _records[key].assign(bytes, bytes + len);
+    return true;
+  }
+  bool erase(const char* key) override { return _records.erase(key) > 0; }
+
+private:
+  std::map<std::string, std::vector<uint8_t> > _records;
+};
+
+static bool appendSeq(VitalsLog& log, uint32_t n) {
+  uint8_t payload[4] = { (uint8_t)n, (uint8_t)(n >> 8), 0xA5, 0x5A };
+  return log.append(payload, sizeof(payload));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Envía todo lo pendiente, confirmando cada lote si `confirm`, y devuelve
+// las secuencias, comprobando que cada trama es la que se grabó con esa
+// secuencia
+static std::vector<uint32_t> drain(VitalsLog& log, uint32_t firstPayload, size_t maxLen = 244,
+                                   bool confirm = true) {
+  std::vector<uint32_t> seqs;
+  uint8_t batch[244];
+  size_t len;
+  uint32_t lastSeq = 0;
+  while ((len = log.peekBatch(batch, maxLen, lastSeq)) > 0) {
+    if (confirm) log.commit(lastSeq);
+    size_t pos = 0;
+    while (pos < len) {
+      uint32_t seq = getU32(batch + pos);
+      uint8_t n = batch[pos + 4];
+      const uint8_t* payload = batch + pos + VitalsLog::ENTRY_OVERHEAD;
+      uint32_t value = payload[0] | ((uint32_t)payload[1] << 8);
+      if (n != 4 || value != (uint16_t)(firstPayload + seq - 1)) seqs.push_back(0);
+      else seqs.push_back(seq);
+      pos += VitalsLog::ENTRY_OVERHEAD + n;
+    }
+  }
+  return seqs;
+}
+
+static bool consecutive(const std::vector<uint32_t>& seqs, uint32_t first, uint32_t count) {
+  if (seqs.size() != count) return false;
+  for (uint32_t i = 0; i < count; i++) {
+    if (seqs[i] != first + i) return false;
+  }
+  return true;
+}
+
+TEST(entrega_en_orden_entre_segmentos) {
+  MemoryLogStorage storage;
+  VitalsLog log(storage, 4, 3, 1);
+  CHECK(log.begin());
+  for (uint32_t i = 0; i < 10; i++) CHECK(appendSeq(log, i));
+
+  CHECK_EQ(log.pending(), 10);
+  CHECK(consecutive(drain(log, 0), 1, 10));
+  CHECK_EQ(log.pending(), 0);
+  CHECK_EQ(log.getCorrupt(), 0);
+}
+
+TEST(lleno_borra_el_segmento_mas_antiguo) {
+  MemoryLogStorage storage;
+  VitalsLog log(storage, 4, 3, 1);
+  CHECK(log.begin());
+  for (uint32_t i = 0; i < 20; i++) CHECK(appendSeq(log, i));
+
+  // Segmentos 1, 5, 9, 13, 17: quedan los tres últimos
+  CHECK_EQ(storage.live.size(), 3);
+  CHECK_EQ(storage.live.begin()->first, 9);
+  CHECK_EQ(log.getOverwritten(), 8);
+  CHECK_EQ(log.pending(), 12);
+  CHECK(log.pending() >= log.capacity());
+  CHECK(consecutive(drain(log, 0), 9, 12));
+
+  // Nada se reescribe en su sitio: ningún segmento pasa de su tamaño
+  for (MemoryLogStorage::Segments::const_iterator it = storage.live.begin(); it != storage.live.end(); ++it) {
+    CHECK(it->second.size() <= 4 * VitalsLog::RECORD_SIZE);
+  }
+}
+
+TEST(sync_por_lotes) {
+  MemoryLogStorage storage;
+  VitalsLog log(storage, 256, 4, 12);
+  CHECK(log.begin());
+  for (uint32_t i = 0; i < 30; i++) CHECK(appendSeq(log, i));
+  CHECK_EQ(storage.syncs, 2);
+  CHECK(log.sync());
+  CHECK_EQ(storage.syncs, 3);
+  CHECK(log.sync());   // sin nada nuevo no vuelve a sincronizar
+  CHECK_EQ(storage.syncs, 3);
+}
+
+TEST(corte_de_luz_pierde_solo_lo_no_sincronizado) {
+  MemoryLogStorage storage;
+  {
+    VitalsLog log(storage, 16, 4, 5);
+    CHECK(log.begin());
+    for (uint32_t i = 0; i < 12; i++) CHECK(appendSeq(log, i));
+  }
+  storage.powerLoss();
+
+  VitalsLog log(storage, 16, 4, 5);
+  CHECK(log.begin());
+  CHECK_EQ(log.pending(), 10);
+  // Sigue en un segmento nuevo con la secuencia siguiente a lo que quedó
+  CHECK(appendSeq(log, 10));
+  CHECK_EQ(storage.live.rbegin()->first, 11);
+  CHECK(consecutive(drain(log, 0), 1, 11));
+  CHECK_EQ(log.getCorrupt(), 0);
+}
+
+TEST(registro_a_medias_no_estropea_lo_siguiente) {
+  MemoryLogStorage storage;
+  {
+    VitalsLog log(storage, 8, 4, 3);
+    CHECK(log.begin());
+    for (uint32_t i = 0; i < 7; i++) CHECK(appendSeq(log, i));
+  }
+  // Del registro 7 solo llegaron 10 bytes
+  storage.powerLoss(VitalsLog::RECORD_SIZE + 10);
+
+  VitalsLog log(storage, 8, 4, 3);
+  CHECK(log.begin());
+  CHECK_EQ(log.pending(), 6);
+  for (uint32_t i = 6; i < 10; i++) CHECK(appendSeq(log, i));
+  CHECK(consecutive(drain(log, 0), 1, 10));
+  CHECK_EQ(log.getCorrupt(), 0);
+}
+
+TEST(fallo_al_escribir_sigue_en_otro_segmento) {
+  MemoryLogStorage storage;
+  VitalsLog log(storage, 8, 4, 1);
+  CHECK(log.begin());
+  for (uint32_t i = 0; i < 3; i++) CHECK(appendSeq(log, i));
+  storage.failNextAppend = true;
+  CHECK(!appendSeq(log, 3));
+  for (uint32_t i = 3; i < 6; i++) CHECK(appendSeq(log, i));
+
+  CHECK(consecutive(drain(log, 0), 1, 6));
+  CHECK_EQ(log.getCorrupt(), 0);
+}
+
+TEST(cursor_de_entrega_tras_reinicio) {
+  MemoryLogStorage storage;
+  MemoryCalibrationStore cursor;
+  {
+    VitalsLog log(storage, 16, 8, 1, &cursor, "log_vitals");
+    CHECK(log.begin());
+    for (uint32_t i = 0; i < 50; i++) CHECK(appendSeq(log, i));
+    CHECK(consecutive(drain(log, 0), 1, 50));
+    for (uint32_t i = 50; i < 60; i++) CHECK(appendSeq(log, i));
+  }
+
+  VitalsLog log(storage, 16, 8, 1, &cursor, "log_vitals");
+  CHECK(log.begin());
+  CHECK_EQ(log.pending(), 10);
+  CHECK(consecutive(drain(log, 0), 51, 10));
+}
+
+TEST(desconexion_tras_empaquetar_antes_de_confirmar) {
+  MemoryLogStorage storage;
+  MemoryCalibrationStore cursor;
+  {
+    VitalsLog log(storage, 16, 8, 1, &cursor, "log_vitals");
+    CHECK(log.begin());
+    for (uint32_t i = 0; i < 40; i++) CHECK(appendSeq(log, i));
+
+    // Ráfaga de cuatro lotes; el enlace cae antes de confirmarlos
+    CHECK(consecutive(drain(log, 0, VitalsLog::MIN_BATCH_SIZE, false), 1, 40));
+    CHECK_EQ(log.pending(), 40);
+    log.rewind();
+
+    // Al reconectar sale todo otra vez; se confirma hasta la 10 y se apaga
+    uint8_t batch[10 * (VitalsLog::ENTRY_OVERHEAD + 4)];
+    uint32_t lastSeq = 0;
+    CHECK_EQ(log.peekBatch(batch, sizeof(batch), lastSeq), sizeof(batch));
+    CHECK_EQ(lastSeq, 10);
+    log.commit(lastSeq);
+    CHECK_EQ(log.pending(), 30);
+    CHECK(log.peekBatch(batch, sizeof(batch), lastSeq) > 0);   // 11-20 sin confirmar
+  }
+
+  // El cursor solo se guarda cada CURSOR_SAVE_INTERVAL o al vaciarse: se
+  // reenvía de más, nunca de menos
+  {
+    VitalsLog log(storage, 16, 8, 1, &cursor, "log_vitals");
+    CHECK(log.begin());
+    CHECK_EQ(log.pending(), 40);
+    CHECK(consecutive(drain(log, 0), 1, 40));
+    CHECK_EQ(log.pending(), 0);
+  }
+
+  VitalsLog log(storage, 16, 8, 1, &cursor, "log_vitals");
+  CHECK(log.begin());
+  CHECK_EQ(log.pending(), 0);
+}
+
+TEST(ficheros_en_disco) {
+  char dir[] = "/tmp/vitals_log_XXXXXX";
+  CHECK(mkdtemp(dir) != nullptr);
+  std::string segments = std::string(dir) + "/vitals";
+
+  {
+    FileLogStorage storage(segments.c_str());
+    VitalsLog log(storage, 8, 3, 4);
+    CHECK(log.begin());
+    for (uint32_t i = 0; i < 30; i++) CHECK(appendSeq(log, i));
+    CHECK(consecutive(drain(log, 0, VitalsLog::MIN_BATCH_SIZE), 9, 22));
+    for (uint32_t i = 30; i < 35; i++) CHECK(appendSeq(log, i));
+    CHECK(log.sync());
+  }
+
+  FileLogStorage storage(segments.c_str());
+  VitalsLog log(storage, 8, 3, 4);
+  CHECK(log.begin());
+  // Sin cursor guardado se reenvía todo lo retenido: segmentos 25 y 33
+  CHECK_EQ(log.pending(), 11);
+  CHECK(consecutive(drain(log, 0), 25, 11));
+
+  uint32_t ids[8];
+  CHECK(storage.listSegments(ids, 8) <= 3);
+
+  // Limpieza del directorio temporal
+  DIR* d = opendir(segments.c_str());
+  struct dirent* entry;
+  while (d && (entry = readdir(d)) != nullptr) {
+    if (entry->d_name[0] == '.') continue;
+    unlink((segments + "/" + entry->d_name).c_str());
+  }
+  if (d) closedir(d);
+  rmdir(segments.c_str());
+  rmdir(dir);
+}
+
+HOST_TEST_MAIN()
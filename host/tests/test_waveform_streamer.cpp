@@ -0,0 +1,57 @@
+// Empaquetado de curvas: una trama sale al juntar MIN_BATCH muestras o
+// cuando la más antigua de la cola lleva FLUSH_MS esperando, sin importar
+// cuándo salió la trama anterior.
+
+#include "HostTest.h"
+#include <WaveformStreamer.h>
+
+static const size_t FRAME_LEN = WaveformStreamer::MAX_FRAME_SIZE;
+
+static uint8_t frameCount(const uint8_t* frame) { return frame[4]; }
+
+static uint32_t frameFirstTime(const uint8_t* frame) {
+  return (uint32_t)frame[9] | ((uint32_t)frame[10] << 8) |
+         ((uint32_t)frame[11] << 16) | ((uint32_t)frame[12] << 24);
+}
+
+TEST(cola_vacia_no_da_trama) {
+  WaveformStreamer streamer;
+  uint8_t frame[FRAME_LEN];
+  CHECK_EQ(streamer.nextFrame(frame, sizeof(frame), 10000), 0);
+  CHECK_EQ(streamer.getFramesSent(), 0);
+}
+
+TEST(espera_a_que_envejezca_la_mas_antigua) {
+  WaveformStreamer streamer;
+  uint8_t frame[FRAME_LEN];
+
+  // Tras mucho rato sin nada, una muestra nueva no sale enseguida
+  streamer.push(WAVE_PRESSURE, 800, 5000);
+  CHECK_EQ(streamer.nextFrame(frame, sizeof(frame), 5001), 0);
+  streamer.push(WAVE_PRESSURE, 810, 5100);
+  CHECK_EQ(streamer.nextFrame(frame, sizeof(frame), 5000 + WaveformStreamer::FLUSH_MS - 1), 0);
+
+  size_t len = streamer.nextFrame(frame, sizeof(frame), 5000 + WaveformStreamer::FLUSH_MS);
+  CHECK(len > WaveformStreamer::HEADER_SIZE);
+  CHECK_EQ(frameCount(frame), 2);
+  CHECK_EQ(frameFirstTime(frame), 5000);
+
+  // La siguiente cuenta desde su propia muestra, no desde la trama anterior
+  streamer.push(WAVE_PRESSURE, 820, 5400);
+  CHECK_EQ(streamer.nextFrame(frame, sizeof(frame), 5401), 0);
+  CHECK(streamer.nextFrame(frame, sizeof(frame), 5400 + WaveformStreamer::FLUSH_MS) > 0);
+  CHECK_EQ(frameFirstTime(frame), 5400);
+}
+
+TEST(lote_completo_sale_sin_esperar) {
+  WaveformStreamer streamer;
+  uint8_t frame[FRAME_LEN];
+  for (uint8_t i = 0; i < WaveformStreamer::MIN_BATCH; i++) {
+    streamer.push(WAVE_PPG, 100000 + i, 1000 + i * 10);
+  }
+  CHECK(streamer.nextFrame(frame, sizeof(frame), 1000 + WaveformStreamer::MIN_BATCH * 10) > 0);
+  CHECK_EQ(frameCount(frame), WaveformStreamer::MIN_BATCH);
+  CHECK_EQ(streamer.getSamplesSent(), WaveformStreamer::MIN_BATCH);
+}
+
+HOST_TEST_MAIN()